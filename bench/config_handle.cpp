@@ -0,0 +1,104 @@
+#include "config_handle.hpp"
+#include "yaml.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dr::bench {
+
+namespace {
+	using Config = std::map<std::string, std::vector<double>>;
+
+	/// Config guarded by a mutex, the approach replaced by ConfigHandle.
+	struct MutexConfig {
+		std::mutex mutex;
+		std::shared_ptr<Config const> config;
+	};
+
+	/// Measure the latency of reads while another thread keeps publishing new configs.
+	/**
+	 * Returns the sorted latencies in nanoseconds.
+	 */
+	template<typename Read, typename Publish>
+	std::vector<double> measure(Read && read, Publish && publish, YAML::Node const & node, int reads) {
+		std::atomic<bool> stop{false};
+		std::thread writer{[&] {
+			while (!stop.load()) {
+				YamlResult<Config> config = parseYaml<Config>(node);
+				if (!config) std::abort();
+				publish(std::move(*config));
+			}
+		}};
+
+		std::vector<double> latencies;
+		latencies.reserve(reads);
+		for (int i = 0; i < reads; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			if (read() == 0) std::abort();
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			latencies.push_back(elapsed.count());
+		}
+
+		stop = true;
+		writer.join();
+		std::sort(latencies.begin(), latencies.end());
+		return latencies;
+	}
+
+	void print(char const * name, std::vector<double> const & latencies) {
+		auto percentile = [&] (double p) { return latencies[std::size_t(p * (latencies.size() - 1))]; };
+		std::printf("  %-14s p50 %8.1f ns   p99 %8.1f ns   p99.99 %10.1f ns   max %10.1f ns\n",
+			name, percentile(0.5), percentile(0.99), percentile(0.9999), latencies.back()
+		);
+	}
+}
+
+}
+
+int main() {
+	using namespace dr::bench;
+
+	YAML::Node node;
+	for (int i = 0; i < 200; ++i) {
+		for (int j = 0; j < 6; ++j) node["joint_" + std::to_string(i)].push_back(i + j * 0.5);
+	}
+	Config initial = *dr::parseYaml<Config>(node);
+
+	int const reads = 1000000;
+	std::string const key = "joint_7";
+
+	dr::ConfigHandle<Config> handle{initial, 4};
+	dr::ConfigReader<Config> reader = *handle.reader();
+	std::vector<double> handle_latencies = measure(
+		[&] { return reader.read()->at(key)[3]; },
+		[&] (Config config) { handle.publish(std::move(config)); },
+		node, reads
+	);
+
+	MutexConfig mutex_config{{}, std::make_shared<Config const>(initial)};
+	std::vector<double> mutex_latencies = measure(
+		[&] {
+			std::lock_guard<std::mutex> lock{mutex_config.mutex};
+			return mutex_config.config->at(key)[3];
+		},
+		[&] (Config config) {
+			auto replacement = std::make_shared<Config const>(std::move(config));
+			std::lock_guard<std::mutex> lock{mutex_config.mutex};
+			mutex_config.config = std::move(replacement);
+		},
+		node, reads
+	);
+
+	std::printf("read latency while reloading a config with 200 entries (%d reads)\n", reads);
+	print("ConfigHandle:", handle_latencies);
+	print("mutex:", mutex_latencies);
+}
@@ -0,0 +1,45 @@
+#include "decompose_large.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace dr::bench {
+
+namespace {
+	template<typename F>
+	double measure(F && parse, YAML::Node const & node, int iterations) {
+		// Warm up, which also builds the member table.
+		if (!parse(node)) std::abort();
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i) {
+			if (!parse(node)) std::abort();
+		}
+		std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / iterations;
+	}
+}
+
+}
+
+int main() {
+	using namespace dr::bench;
+
+	YAML::Node node;
+	for (int i = 0; i < 100; ++i) {
+		char name[4];
+		std::snprintf(name, sizeof(name), "m%02d", i);
+		node[name] = i * 0.5;
+	}
+
+	int const iterations = 2000;
+	double unrolled = measure(parseUnrolled, node, iterations);
+	double table    = measure(parseTable,    node, iterations);
+
+	std::printf("decode struct with 100 members (%d iterations)\n", iterations);
+	std::printf("  unrolled:     %8.2f us/decode\n", unrolled);
+	std::printf("  member table: %8.2f us/decode\n", table);
+	std::printf("run the dr_param_bench_decompose_size target to compare code size\n");
+}
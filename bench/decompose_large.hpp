@@ -0,0 +1,59 @@
+#pragma once
+#include "yaml.hpp"
+
+/**
+ * A struct with 100 members, to compare the code size and speed of the decoding backends for decomposable types.
+ */
+
+namespace dr::bench {
+
+#define DR_PARAM_BENCH_FIELDS10(N) \
+	double m##N##0; double m##N##1; double m##N##2; double m##N##3; double m##N##4; \
+	double m##N##5; double m##N##6; double m##N##7; double m##N##8; double m##N##9;
+
+struct Large {
+	DR_PARAM_BENCH_FIELDS10(0)
+	DR_PARAM_BENCH_FIELDS10(1)
+	DR_PARAM_BENCH_FIELDS10(2)
+	DR_PARAM_BENCH_FIELDS10(3)
+	DR_PARAM_BENCH_FIELDS10(4)
+	DR_PARAM_BENCH_FIELDS10(5)
+	DR_PARAM_BENCH_FIELDS10(6)
+	DR_PARAM_BENCH_FIELDS10(7)
+	DR_PARAM_BENCH_FIELDS10(8)
+	DR_PARAM_BENCH_FIELDS10(9)
+};
+
+#undef DR_PARAM_BENCH_FIELDS10
+
+/// Decode with parseDecomposableFromYaml().
+YamlResult<Large> parseUnrolled(YAML::Node const & node);
+
+/// Decode with parseDecomposableFromYamlTable().
+YamlResult<Large> parseTable(YAML::Node const & node);
+
+}
+
+#ifdef DR_PARAM_BENCH_DECOMPOSITION
+#include "decompose_macros.hpp"
+#include "yaml_decompose.hpp"
+
+#define DR_PARAM_BENCH_MEMBERS10(N) \
+	(m##N##0, "double", "", true) (m##N##1, "double", "", true) (m##N##2, "double", "", true) (m##N##3, "double", "", true) (m##N##4, "double", "", true) \
+	(m##N##5, "double", "", true) (m##N##6, "double", "", true) (m##N##7, "double", "", true) (m##N##8, "double", "", true) (m##N##9, "double", "", true)
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::bench::Large,
+	DR_PARAM_BENCH_MEMBERS10(0)
+	DR_PARAM_BENCH_MEMBERS10(1)
+	DR_PARAM_BENCH_MEMBERS10(2)
+	DR_PARAM_BENCH_MEMBERS10(3)
+	DR_PARAM_BENCH_MEMBERS10(4)
+	DR_PARAM_BENCH_MEMBERS10(5)
+	DR_PARAM_BENCH_MEMBERS10(6)
+	DR_PARAM_BENCH_MEMBERS10(7)
+	DR_PARAM_BENCH_MEMBERS10(8)
+	DR_PARAM_BENCH_MEMBERS10(9)
+);
+
+#undef DR_PARAM_BENCH_MEMBERS10
+#endif
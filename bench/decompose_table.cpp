@@ -0,0 +1,10 @@
+#define DR_PARAM_BENCH_DECOMPOSITION
+#include "decompose_large.hpp"
+
+namespace dr::bench {
+
+YamlResult<Large> parseTable(YAML::Node const & node) {
+	return parseDecomposableFromYamlTable<Large>(node);
+}
+
+}
@@ -0,0 +1,10 @@
+#define DR_PARAM_BENCH_DECOMPOSITION
+#include "decompose_large.hpp"
+
+namespace dr::bench {
+
+YamlResult<Large> parseUnrolled(YAML::Node const & node) {
+	return parseDecomposableFromYaml<Large>(node);
+}
+
+}
@@ -0,0 +1,60 @@
+#include "json.hpp"
+#include "yaml.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace dr::bench {
+
+namespace {
+	/// Generate a JSON document with many objects, like an exported calibration or map.
+	std::string generateDocument(int entries) {
+		std::string result = "{\"entries\": [\n";
+		for (int i = 0; i < entries; ++i) {
+			if (i != 0) result += ",\n";
+			result += "  {\"name\": \"entry_" + std::to_string(i) + "\", \"enabled\": true, \"offset\": null, ";
+			result += "\"pose\": [" + std::to_string(i * 0.25) + ", -1.5e-3, 2, 0.5, 0.25, 0.125]}";
+		}
+		result += "\n]}\n";
+		return result;
+	}
+
+	/// Measure the best time in milliseconds of a number of runs of a function.
+	template<typename F>
+	double measure(F && function, int runs) {
+		double best = 1e300;
+		for (int i = 0; i < runs; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+}
+
+}
+
+int main() {
+	using namespace dr::bench;
+
+	std::string const document = generateDocument(20000);
+	int const runs = 5;
+
+	double json = measure([&] {
+		dr::YamlResult<YAML::Node> node = dr::loadJson(document);
+		if (!node || (*node)["entries"].size() != 20000) std::abort();
+	}, runs);
+
+	double yaml = measure([&] {
+		YAML::Node node = YAML::Load(document);
+		if (node["entries"].size() != 20000) std::abort();
+	}, runs);
+
+	std::printf("loading a JSON document of %.1f MB (best of %d runs)\n", document.size() / 1e6, runs);
+	std::printf("  loadJson:   %8.1f ms\n", json);
+	std::printf("  YAML::Load: %8.1f ms\n", yaml);
+}
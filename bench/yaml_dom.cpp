@@ -0,0 +1,90 @@
+#include "yaml.hpp"
+#include "yaml_dom.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+	std::atomic<std::size_t> allocations{0};
+}
+
+// Do not inline the replacements, or the compiler sees memory from std::malloc()
+// released with operator delete (or the reverse) and warns about mismatched allocation functions.
+[[gnu::noinline]] void * operator new(std::size_t size) {
+	++allocations;
+	if (void * result = std::malloc(size ? size : 1)) return result;
+	throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * pointer) noexcept {
+	std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void * pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+namespace dr::bench {
+
+namespace {
+	using Config = std::map<std::string, std::vector<std::vector<double>>>;
+
+	/// Generate a document with many small sequences, like a calibration table.
+	std::string generateDocument(int entries) {
+		std::string result;
+		for (int i = 0; i < entries; ++i) {
+			result += "entry_" + std::to_string(i) + ":\n";
+			for (int j = 0; j < 4; ++j) result += "  - [" + std::to_string(i * 0.25) + ", -1.5e-3, 2, 0.5, 0.25, 0.125]\n";
+		}
+		return result;
+	}
+
+	/// Measure the best time in milliseconds and the allocations of a number of runs of a function.
+	template<typename F>
+	std::pair<double, std::size_t> measure(F && function, int runs) {
+		double best = 1e300;
+		std::size_t allocated = 0;
+		for (int i = 0; i < runs; ++i) {
+			std::size_t before = allocations.load();
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+			allocated = allocations.load() - before;
+		}
+		return {best, allocated};
+	}
+}
+
+}
+
+int main() {
+	using namespace dr::bench;
+
+	std::string const document = generateDocument(20000);
+	int const runs = 5;
+
+	auto node = measure([&] {
+		YAML::Node node = YAML::Load(document);
+		dr::YamlResult<Config> config = dr::parseYaml<Config>(node);
+		if (!config || config->size() != 20000) std::abort();
+	}, runs);
+
+	auto dom = measure([&] {
+		dr::YamlResult<dr::YamlDom> dom = dr::loadYamlDom(document);
+		if (!dom) std::abort();
+		dr::YamlResult<Config> config = dr::parseYaml<Config>(*dom);
+		if (!config || config->size() != 20000) std::abort();
+	}, runs);
+
+	std::printf("loading and decoding a document of %.1f MB (best of %d runs)\n", document.size() / 1e6, runs);
+	std::printf("  YAML::Node: %8.1f ms %10zu allocations\n", node.first, node.second);
+	std::printf("  YamlDom:    %8.1f ms %10zu allocations\n", dom.first, dom.second);
+}
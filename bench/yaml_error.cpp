@@ -0,0 +1,68 @@
+#include "yaml.hpp"
+#include "yaml_dom.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace dr::bench {
+
+namespace {
+	/// Generate a document with a long flat sequence of small integers.
+	std::string generateDocument(int elements) {
+		std::string result = "[";
+		for (int i = 0; i < elements; ++i) {
+			if (i) result += ", ";
+			result += std::to_string(i % 1000);
+		}
+		return result + "]";
+	}
+
+	/// Measure the best time in milliseconds of a number of runs of a function.
+	template<typename F>
+	double measure(F && function, int runs) {
+		double best = 1e300;
+		for (int i = 0; i < runs; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+}
+
+}
+
+int main() {
+	using namespace dr::bench;
+
+	int const elements = 1000000;
+	dr::YamlResult<dr::YamlDom> dom = dr::loadYamlDom(generateDocument(elements));
+	if (!dom) std::abort();
+	int const runs = 10;
+
+	// Decode the scalars one by one, so the cost of each YamlResult dominates.
+	double scalars = measure([&] {
+		long long sum = 0;
+		for (dr::YamlDomNode node : dom->root()) {
+			dr::YamlResult<int> value = dr::parseYaml<int>(node);
+			if (!value) std::abort();
+			sum += *value;
+		}
+		if (sum == 0) std::abort();
+	}, runs);
+
+	double vector = measure([&] {
+		dr::YamlResult<std::vector<int>> values = dr::parseYaml<std::vector<int>>(*dom);
+		if (!values || values->size() != std::size_t(elements)) std::abort();
+	}, runs);
+
+	std::printf("sizeof(YamlError):              %zu bytes\n", sizeof(dr::YamlError));
+	std::printf("sizeof(YamlResult<int>):        %zu bytes\n", sizeof(dr::YamlResult<int>));
+	std::printf("decode %d scalars:         %.1f ms\n", elements, scalars);
+	std::printf("decode std::vector<int>:        %.1f ms\n", vector);
+}
@@ -0,0 +1,57 @@
+#include "yaml.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace dr::bench {
+
+namespace {
+	/// Generate a lookup table with string keys.
+	std::string generateDocument(int entries) {
+		std::string result;
+		for (int i = 0; i < entries; ++i) result += "key_" + std::to_string(i * 7919 % entries) + ": " + std::to_string(i) + "\n";
+		return result;
+	}
+
+	/// Measure the best time in milliseconds of a number of runs of a function.
+	template<typename F>
+	double measure(F && function, int runs) {
+		double best = 1e300;
+		for (int i = 0; i < runs; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+
+	/// Measure decoding the node into a map type.
+	template<typename Map>
+	double measureDecode(YAML::Node const & node, std::size_t entries, int runs) {
+		return measure([&] {
+			dr::YamlResult<Map> map = dr::parseYaml<Map>(node);
+			if (!map || map->size() != entries) std::abort();
+		}, runs);
+	}
+}
+
+}
+
+int main() {
+	using namespace dr::bench;
+
+	int const entries = 50000;
+	YAML::Node const node = YAML::Load(generateDocument(entries));
+	int const runs = 10;
+
+	std::printf("decode %d entries:\n", entries);
+	std::printf("  std::map:           %.1f ms\n", measureDecode<std::map<std::string, int>>(node, entries, runs));
+	std::printf("  std::unordered_map: %.1f ms\n", measureDecode<std::unordered_map<std::string, int>>(node, entries, runs));
+	std::printf("  dr::FlatMap:        %.1f ms\n", measureDecode<dr::FlatMap<std::string, int>>(node, entries, runs));
+}
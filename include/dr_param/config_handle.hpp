@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * This header defines a handle to publish new versions of a config to threads that read it concurrently.
+ */
+
+namespace dr {
+
+namespace detail {
+	/// Epoch announced by a reader slot that is not reading.
+	constexpr std::uint64_t config_idle_epoch = std::numeric_limits<std::uint64_t>::max();
+
+	/// Reader slot of a ConfigHandle, on its own cache line to avoid false sharing between readers.
+	struct alignas(64) ConfigReaderSlot {
+		/// The epoch announced by the reader while it holds a snapshot, or config_idle_epoch.
+		std::atomic<std::uint64_t> epoch{config_idle_epoch};
+
+		/// True if the slot is claimed by a reader.
+		std::atomic<bool> claimed{false};
+	};
+}
+
+/// Handle to publish snapshots of a config to concurrent readers.
+/**
+ * A writer thread publishes new snapshots with publish(), for example after reloading a config file.
+ * Reader threads get a consistent view of the latest snapshot with ConfigReader::read().
+ *
+ * Reading is wait-free and does not allocate:
+ * it announces the current epoch in the slot of the reader and loads the pointer to the latest snapshot,
+ * without ever waiting on the writer or other readers.
+ * That makes it safe to read the config from realtime threads, without the priority inversion of a mutex.
+ *
+ * Old snapshots are not deleted while a reader may still use them.
+ * Instead, they are reclaimed by later calls to publish() or reclaim(), once no reader announced an epoch from before they were replaced.
+ *
+ * Each reader needs a slot, claimed once with reader().
+ * The number of slots is fixed when the handle is created.
+ * The handle must outlive all readers and snapshots.
+ */
+template<typename T>
+class ConfigHandle {
+public:
+	class Reader;
+
+	/// A consistent view of a snapshot, valid until the view is destroyed.
+	class Snapshot {
+		friend class Reader;
+
+		/// The slot of the reader, or null if the snapshot was moved from.
+		detail::ConfigReaderSlot * slot_;
+
+		/// The config.
+		T const * value_;
+
+		Snapshot(detail::ConfigReaderSlot * slot, T const * value) : slot_{slot}, value_{value} {}
+
+	public:
+		Snapshot(Snapshot && other) noexcept : slot_{std::exchange(other.slot_, nullptr)}, value_{other.value_} {}
+		Snapshot(Snapshot const &) = delete;
+		Snapshot & operator=(Snapshot const &) = delete;
+		Snapshot & operator=(Snapshot &&) = delete;
+
+		/// Release the snapshot, allowing it to be reclaimed once it is replaced.
+		~Snapshot() {
+			if (slot_) slot_->epoch.store(detail::config_idle_epoch, std::memory_order_release);
+		}
+
+		/// Get the config.
+		T const & value() const { return *value_; }
+
+		/// Get the config.
+		T const & operator*() const { return *value_; }
+
+		/// Access a member of the config.
+		T const * operator->() const { return value_; }
+	};
+
+	/// A reader of a ConfigHandle, to be used by a single thread.
+	class Reader {
+		friend class ConfigHandle;
+
+		/// The handle to read from, or null if the reader was moved from.
+		ConfigHandle const * handle_;
+
+		/// The slot claimed by the reader.
+		detail::ConfigReaderSlot * slot_;
+
+		Reader(ConfigHandle const * handle, detail::ConfigReaderSlot * slot) : handle_{handle}, slot_{slot} {}
+
+	public:
+		Reader(Reader && other) noexcept : handle_{std::exchange(other.handle_, nullptr)}, slot_{other.slot_} {}
+		Reader(Reader const &) = delete;
+		Reader & operator=(Reader const &) = delete;
+		Reader & operator=(Reader &&) = delete;
+
+		/// Release the slot of the reader.
+		~Reader() {
+			if (handle_) slot_->claimed.store(false, std::memory_order_release);
+		}
+
+		/// Get a view of the latest snapshot.
+		/**
+		 * This is wait-free and does not allocate.
+		 * A reader can hold only one snapshot at a time, the previous snapshot must be destroyed first.
+		 */
+		Snapshot read() const {
+			// Announce the epoch before loading the pointer, so the writer can not reclaim the loaded snapshot.
+			slot_->epoch.store(handle_->epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+			return Snapshot{slot_, handle_->current_.load(std::memory_order_seq_cst)};
+		}
+	};
+
+private:
+	/// The latest snapshot.
+	std::atomic<T const *> current_;
+
+	/// The number of snapshots replaced so far.
+	std::atomic<std::uint64_t> epoch_{0};
+
+	/// The reader slots.
+	std::unique_ptr<detail::ConfigReaderSlot[]> slots_;
+
+	/// The number of reader slots.
+	std::size_t slot_count_;
+
+	/// Mutex to serialize writers.
+	std::mutex writer_mutex_;
+
+	/// Replaced snapshots that may still be in use, with the epoch in which they were replaced.
+	std::vector<std::pair<T const *, std::uint64_t>> retired_;
+
+	/// Delete the retired snapshots that no reader can use anymore, with the writer mutex locked.
+	void reclaimLocked() {
+		std::uint64_t oldest = detail::config_idle_epoch;
+		for (std::size_t i = 0; i < slot_count_; ++i) oldest = std::min(oldest, slots_[i].epoch.load(std::memory_order_seq_cst));
+
+		// A reader that announced an epoch before a snapshot was replaced may still use it.
+		auto keep = retired_.begin();
+		for (auto & [snapshot, epoch] : retired_) {
+			if (epoch <= oldest) delete snapshot;
+			else *keep++ = {snapshot, epoch};
+		}
+		retired_.erase(keep, retired_.end());
+	}
+
+public:
+	/// Create a handle with an initial config and a fixed number of reader slots.
+	explicit ConfigHandle(T initial, std::size_t max_readers = 64) :
+		current_{new T const(std::move(initial))},
+		slots_{new detail::ConfigReaderSlot[max_readers]},
+		slot_count_{max_readers} {}
+
+	ConfigHandle(ConfigHandle const &) = delete;
+	ConfigHandle & operator=(ConfigHandle const &) = delete;
+
+	/// Delete all snapshots.
+	~ConfigHandle() {
+		delete current_.load();
+		for (auto & [snapshot, epoch] : retired_) delete snapshot;
+	}
+
+	/// Claim a reader slot.
+	/**
+	 * Returns std::nullopt if all slots are claimed.
+	 * This is not wait-free, claim the reader before entering a realtime loop.
+	 */
+	std::optional<Reader> reader() {
+		for (std::size_t i = 0; i < slot_count_; ++i) {
+			bool expected = false;
+			if (slots_[i].claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) return Reader{this, &slots_[i]};
+		}
+		return std::nullopt;
+	}
+
+	/// Publish a new snapshot.
+	/**
+	 * Readers see the new snapshot on their next read().
+	 * The replaced snapshot is reclaimed once no reader can use it anymore.
+	 */
+	void publish(T value) {
+		T const * snapshot = new T const(std::move(value));
+		std::lock_guard<std::mutex> lock{writer_mutex_};
+		T const * old = current_.exchange(snapshot, std::memory_order_seq_cst);
+		std::uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+		retired_.emplace_back(old, epoch);
+		reclaimLocked();
+	}
+
+	/// Reclaim replaced snapshots that are no longer in use.
+	/**
+	 * This is also done by publish(), so it only needs to be called to release memory early.
+	 */
+	void reclaim() {
+		std::lock_guard<std::mutex> lock{writer_mutex_};
+		reclaimLocked();
+	}
+
+	/// Get the number of replaced snapshots that are not reclaimed yet.
+	std::size_t retiredCount() {
+		std::lock_guard<std::mutex> lock{writer_mutex_};
+		return retired_.size();
+	}
+};
+
+template<typename T>
+using ConfigReader = typename ConfigHandle<T>::Reader;
+
+template<typename T>
+using ConfigSnapshot = typename ConfigHandle<T>::Snapshot;
+
+}
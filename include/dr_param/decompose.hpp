@@ -1,5 +1,12 @@
 #pragma once
+#include "string_table.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
@@ -128,6 +135,30 @@ struct MemberPtrInfo : MemberInfoBase {
 };
 
 
+/// Concrete implementation of MemberInfo concept with read-only access through a provided functor.
+/**
+ * Unlike MemberInfo, the accessor is only ever invoked with a const reference to the parent,
+ * and it may return the member by value, for example by calling a getter.
+ *
+ * This is used by constructor decompositions, which never modify an object member by member.
+ */
+template<typename T, typename F>
+struct ConstMemberInfo : MemberInfoBase {
+	F accessor;
+
+	using accessor_type = std::invoke_result_t<F, T const &>;
+
+	decltype(auto) access(T const & parent) const {
+		if constexpr (std::is_pointer_v<accessor_type>) {
+			return *accessor(parent);
+		} else if constexpr (is_reference_wrapper<accessor_type>) {
+			return accessor(parent).get();
+		} else {
+			return accessor(parent);
+		}
+	}
+};
+
 /// Create a member info struct from the required fields and an accessor functor.
 template<typename T, typename F>
 auto memberInfo(std::string name, std::string type, std::string description, bool required, F && accessor) {
@@ -142,6 +173,20 @@ auto memberInfo(std::string name, std::string type, std::string description, boo
 	return MemberPtrInfo<T, M>{{std::move(name), std::move(type), std::move(description), required}, member};
 }
 
+/// Create a read-only member info struct from the required fields and an accessor functor.
+template<typename T, typename F>
+auto constMemberInfo(std::string name, std::string type, std::string description, bool required, F && accessor) {
+	return ConstMemberInfo<std::decay_t<T>, std::decay_t<F>> {
+		{name, type, description, required}, std::forward<F>(accessor)
+	};
+}
+
+/// Create a read-only member info struct from the required fields and a pointer-to-member.
+template<typename T, typename M>
+auto constMemberInfo(std::string name, std::string type, std::string description, bool required, M T::* member) {
+	return MemberPtrInfo<T, M>{{std::move(name), std::move(type), std::move(description), required}, member};
+}
+
 /// Base struct to specialize when implementing decompositions for a given type.
 /**
  * The specialization should have atleast one static member function called `decompose()`.
@@ -164,4 +209,189 @@ auto decompose() {
 	return Decomposition<T>::decompose();
 }
 
+namespace detail {
+	template<typename T, typename = void> struct caches_decomposition_ : std::false_type {};
+	template<typename T> struct caches_decomposition_<T, std::void_t<decltype(Decomposition<T>::cache_decomposition)>>
+		: std::bool_constant<Decomposition<T>::cache_decomposition> {};
+}
+
+/// Check if the decomposition of a type may be created once and shared by all later uses.
+/**
+ * This is the case if the specialization of Decomposition<T> has a static member `cache_decomposition` that is true,
+ * as defined by the macros from decompose_macros.hpp.
+ * It must only be set if `decompose()` does not depend on any run-time state.
+ */
+template<typename T> constexpr bool caches_decomposition = detail::caches_decomposition_<T>::value;
+
+/// Get the decomposition of a type, created on first use and shared by all later calls if the type allows it.
+/**
+ * If caches_decomposition<T> is true, this returns a reference to a decomposition that is created only once,
+ * so hot code paths do not allocate the names and descriptions of the members over and over.
+ * Otherwise, this returns a new decomposition from decompose<T>() by value.
+ *
+ * Bind the result to a `const &` to support both cases.
+ */
+template<typename T>
+decltype(auto) cachedDecompose() {
+	if constexpr (caches_decomposition<T>) {
+		static auto const members = decompose<T>();
+		return (members);
+	} else {
+		return decompose<T>();
+	}
+}
+
+namespace detail {
+	template<typename T, typename = void> struct constructs_from_decomposition_ : std::false_type {};
+	template<typename T> struct constructs_from_decomposition_<T, std::void_t<decltype(Decomposition<T>::construct_from_members)>>
+		: std::bool_constant<Decomposition<T>::construct_from_members> {};
+}
+
+/// Check if a type must be constructed from the values of all members in its decomposition.
+/**
+ * This is the case if the specialization of Decomposition<T> has a static member
+ * `construct_from_members` that is true, as defined by DR_PARAM_DEFINE_CONSTRUCTOR_DECOMPOSITION.
+ *
+ * Such types need not be default constructible or assignable.
+ * Instead, they must be constructible from the values of the members, in the order of the decomposition.
+ */
+template<typename T> constexpr bool constructs_from_decomposition = detail::constructs_from_decomposition_<T>::value;
+
+/// A single named value of an enum.
+template<typename E>
+struct EnumEntry {
+	/// The value of the enum.
+	E value;
+
+	/// The name of the value.
+	std::string_view name;
+};
+
+/// Compile-time table mapping the values of an enum to names and back.
+/**
+ * Both directions are lookups in a hash table built at compile time,
+ * so converting a name to a value and a value to a name take constant time.
+ *
+ * Multiple names may map to the same value.
+ * In that case, the first name for the value is used when converting the value to a name.
+ */
+template<typename E, std::size_t N, bool IgnoreCase = false>
+class EnumTable {
+	static_assert(std::is_enum_v<E>, "EnumTable can only be used with enums");
+	using underlying_type = std::underlying_type_t<E>;
+
+	static constexpr std::size_t bucket_count = detail::stringTableBuckets(N);
+
+	/// The values in the table, in the same order as the names in `names_`.
+	std::array<E, N> values_;
+
+	/// The names in the table.
+	StringTable<N, IgnoreCase> names_;
+
+	/// The buckets of the hash table for the values, holding the index of a value plus one, or zero for empty buckets.
+	std::array<std::size_t, bucket_count> value_buckets_;
+
+	static constexpr std::size_t valueBucket(E value) noexcept {
+		// Fibonacci hashing of the underlying value.
+		std::uint64_t hash = static_cast<std::uint64_t>(static_cast<underlying_type>(value)) * 11400714819323198485ull;
+		return static_cast<std::size_t>(hash >> 32) % bucket_count;
+	}
+
+	static constexpr std::array<std::string_view, N> getNames(std::array<EnumEntry<E>, N> const & entries) noexcept {
+		std::array<std::string_view, N> result{};
+		for (std::size_t i = 0; i < N; ++i) result[i] = entries[i].name;
+		return result;
+	}
+
+	static constexpr std::array<E, N> getValues(std::array<EnumEntry<E>, N> const & entries) noexcept {
+		std::array<E, N> result{};
+		for (std::size_t i = 0; i < N; ++i) result[i] = entries[i].value;
+		return result;
+	}
+
+public:
+	/// Create a table from a list of entries.
+	constexpr explicit EnumTable(std::array<EnumEntry<E>, N> const & entries) :
+		values_{getValues(entries)},
+		names_{getNames(entries)},
+		value_buckets_{}
+	{
+		for (std::size_t i = 0; i < N; ++i) {
+			std::size_t bucket = valueBucket(values_[i]);
+			bool duplicate = false;
+			while (value_buckets_[bucket] != 0) {
+				if (values_[value_buckets_[bucket] - 1] == values_[i]) duplicate = true;
+				bucket = (bucket + 1) % bucket_count;
+			}
+			if (!duplicate) value_buckets_[bucket] = i + 1;
+		}
+	}
+
+	/// Get the number of entries in the table.
+	constexpr std::size_t size() const noexcept {
+		return N;
+	}
+
+	/// Get the name of the entry at the given index.
+	constexpr std::string_view name(std::size_t index) const {
+		return names_.name(index);
+	}
+
+	/// Find the name of a value, or std::nullopt if the value is not in the table.
+	constexpr std::optional<std::string_view> name(E value) const noexcept {
+		std::size_t bucket = valueBucket(value);
+		while (value_buckets_[bucket] != 0) {
+			std::size_t index = value_buckets_[bucket] - 1;
+			if (values_[index] == value) return names_.name(index);
+			bucket = (bucket + 1) % bucket_count;
+		}
+		return std::nullopt;
+	}
+
+	/// Find the value for a name, or std::nullopt if the name is not in the table.
+	constexpr std::optional<E> value(std::string_view name) const noexcept {
+		std::optional<std::size_t> index = names_.find(name);
+		if (!index) return std::nullopt;
+		return values_[*index];
+	}
+};
+
+/// Create an EnumTable from a braced list of entries.
+template<typename E, bool IgnoreCase = false, std::size_t N>
+constexpr EnumTable<E, N, IgnoreCase> makeEnumTable(EnumEntry<E> const (&entries)[N]) {
+	std::array<EnumEntry<E>, N> array{};
+	for (std::size_t i = 0; i < N; ++i) array[i] = entries[i];
+	return EnumTable<E, N, IgnoreCase>{array};
+}
+
+/// Base struct to specialize when implementing decompositions for a given enum.
+/**
+ * The specialization should have a static constexpr member called `table`.
+ * It should be an EnumTable for the enum.
+ */
+template<typename E>
+struct EnumDecomposition;
+
+namespace detail {
+	template<typename T, typename = void> struct can_decompose_enum_ : std::false_type {};
+	template<typename T> struct can_decompose_enum_<T, std::void_t<decltype(EnumDecomposition<T>::table)>> : std::true_type{};
+}
+
+/// Check if an enum decomposition is available for a given type.
+template<typename T> constexpr bool can_decompose_enum = detail::can_decompose_enum_<T>::value;
+
+/// Get the name of an enum value, or std::nullopt if the value has no name.
+template<typename E>
+constexpr std::optional<std::string_view> enumName(E value) {
+	static_assert(can_decompose_enum<E>, "no enum decomposition available for given type E");
+	return EnumDecomposition<E>::table.name(value);
+}
+
+/// Get the enum value for a name, or std::nullopt if there is no value with the name.
+template<typename E>
+constexpr std::optional<E> enumValue(std::string_view name) {
+	static_assert(can_decompose_enum<E>, "no enum decomposition available for given type E");
+	return EnumDecomposition<E>::table.value(name);
+}
+
 }
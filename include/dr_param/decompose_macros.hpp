@@ -38,10 +38,13 @@
  *
  * All parenthesis enclosed groups of arguments are passed to dr::param::memberInfo.
  * See that function for more details.
+ *
+ * The decomposition is created once and shared, so the arguments must not depend on any run-time state.
  */
 #define DR_PARAM_DEFINE_DECOMPOSITION(T, ...) \
 template<> struct dr::param::Decomposition<T> { \
 	using Type = T; \
+	static constexpr bool cache_decomposition = true; \
 	static auto decompose() { \
 		return DR_PARAM_MEMBERS_TUPLE(__VA_ARGS__); \
 	} \
@@ -77,7 +80,93 @@ template<> struct dr::param::Decomposition<T> { \
 #define DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(T, MEMBERS) \
 template<> struct dr::param::Decomposition<T> { \
 	using Type = T; \
+	static constexpr bool cache_decomposition = true; \
 	static auto decompose() { \
 		return DR_PARAM_STRUCT_MEMBERS_TUPLE(MEMBERS); \
 	} \
 }
+
+// These bits are here to implement looping over macro arguments.
+#define DR_PARAM_CONST_MEMBER_TUPLE_ENTRY_FIRST_END
+#define DR_PARAM_CONST_MEMBER_TUPLE_ENTRY1_END
+#define DR_PARAM_CONST_MEMBER_TUPLE_ENTRY2_END
+
+#define DR_PARAM_CONST_MEMBER_TUPLE_ENTRY_FIRST(...) dr::param::constMemberInfo<Type>(__VA_ARGS__) DR_PARAM_CONST_MEMBER_TUPLE_ENTRY1
+#define DR_PARAM_CONST_MEMBER_TUPLE_ENTRY1(...) , dr::param::constMemberInfo<Type>(__VA_ARGS__) DR_PARAM_CONST_MEMBER_TUPLE_ENTRY2
+#define DR_PARAM_CONST_MEMBER_TUPLE_ENTRY2(...) , dr::param::constMemberInfo<Type>(__VA_ARGS__) DR_PARAM_CONST_MEMBER_TUPLE_ENTRY1
+
+#define DR_PARAM_CONST_MEMBERS_TUPLE(...) std::make_tuple(DR_PARAM_ADD_END(DR_PARAM_CONST_MEMBER_TUPLE_ENTRY_FIRST __VA_ARGS__))
+
+/// Macro to define the decomposition of a type that is constructed from all of its members at once.
+/**
+ * This macro must be invoked from the global namespace.
+ *
+ * Usage:
+ * DR_PARAM_DEFINE_CONSTRUCTOR_DECOMPOSITION(T,
+ *  ("bar", "int",    "The bar member of T", true,  &T::bar)
+ *  ("baz", "double", "The baz member of T", false, [] (T const & v) { return v.baz(); })
+ * );
+ *
+ * This macro defines a specialization for the struct dr::param::Decomposition<T>.
+ *
+ * All parenthesis enclosed groups of arguments are passed to dr::param::constMemberInfo.
+ * The accessors are only used to read members, so they may return by value.
+ *
+ * When decoding, T is constructed once from the decoded values of all members, in the order given here.
+ * Missing optional members are value initialized.
+ * T is constructed with parentheses if possible, and with braces otherwise, so aggregates are supported too.
+ * This allows decoding types that are not default constructible, or that have const members.
+ */
+#define DR_PARAM_DEFINE_CONSTRUCTOR_DECOMPOSITION(T, ...) \
+template<> struct dr::param::Decomposition<T> { \
+	using Type = T; \
+	static constexpr bool cache_decomposition = true; \
+	static constexpr bool construct_from_members = true; \
+	static auto decompose() { \
+		return DR_PARAM_CONST_MEMBERS_TUPLE(__VA_ARGS__); \
+	} \
+}
+
+// These bits are here to implement looping over macro arguments.
+#define DR_PARAM_ENUM_ENTRY_FIRST_END
+#define DR_PARAM_ENUM_ENTRY1_END
+#define DR_PARAM_ENUM_ENTRY2_END
+
+#define DR_PARAM_ENUM_ENTRY_FIRST(VALUE, NAME)   {Type::VALUE, NAME} DR_PARAM_ENUM_ENTRY1
+#define DR_PARAM_ENUM_ENTRY1(VALUE, NAME)      , {Type::VALUE, NAME} DR_PARAM_ENUM_ENTRY2
+#define DR_PARAM_ENUM_ENTRY2(VALUE, NAME)      , {Type::VALUE, NAME} DR_PARAM_ENUM_ENTRY1
+
+#define DR_PARAM_ENUM_TABLE(IGNORE_CASE, ...) dr::param::makeEnumTable<Type, IGNORE_CASE>({DR_PARAM_ADD_END(DR_PARAM_ENUM_ENTRY_FIRST __VA_ARGS__)})
+
+/// Macro to easily define the names of the values of an enum.
+/**
+ * This macro must be invoked from the global namespace.
+ *
+ * Usage:
+ * DR_PARAM_DEFINE_ENUM(Mode,
+ *  (fast,    "fast")
+ *  (precise, "precise")
+ *  (precise, "accurate")
+ * );
+ *
+ * This macro defines a specialization for the struct dr::param::EnumDecomposition<Mode>.
+ *
+ * Each parenthesis enclosed group of arguments (value, name) maps Mode::value to a name.
+ * A value may be given multiple names, in which case the first name is used for encoding.
+ */
+#define DR_PARAM_DEFINE_ENUM(T, ENTRIES) \
+template<> struct dr::param::EnumDecomposition<T> { \
+	using Type = T; \
+	static constexpr auto table = DR_PARAM_ENUM_TABLE(false, ENTRIES); \
+}
+
+/// Macro to define the names of the values of an enum, matched without regard for ASCII case.
+/**
+ * This macro must be invoked from the global namespace.
+ * It is identical to DR_PARAM_DEFINE_ENUM, except that names are matched case-insensitively.
+ */
+#define DR_PARAM_DEFINE_ENUM_CASE_INSENSITIVE(T, ENTRIES) \
+template<> struct dr::param::EnumDecomposition<T> { \
+	using Type = T; \
+	static constexpr auto table = DR_PARAM_ENUM_TABLE(true, ENTRIES); \
+}
@@ -0,0 +1,260 @@
+#pragma once
+#include "decompose.hpp"
+#include "type_traits.hpp"
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+
+#include <estd/tuple/for_each.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+ * This header contains utilities to find the members that differ between two objects.
+ *
+ * The objects are compared by walking their decomposition (see decompose.hpp),
+ * and the standard library types that have YAML conversions in yaml.hpp.
+ * It is used amongst others to reconfigure only the parts of a system affected by a changed config.
+ */
+
+namespace dr::param {
+
+/// A member that differs between two objects.
+struct Difference {
+	/// The path to the member, in the same syntax as YamlError::formatTrace().
+	/**
+	 * The path is empty if the objects themselves differ and have no members.
+	 */
+	std::string path;
+
+	/// The old value of the member, if values were requested and the member exists in the old object.
+	std::optional<YAML::Node> old_value;
+
+	/// The new value of the member, if values were requested and the member exists in the new object.
+	std::optional<YAML::Node> new_value;
+};
+
+namespace detail {
+	template<typename T, typename = void> struct is_equality_comparable : std::false_type {};
+	template<typename T> struct is_equality_comparable<T, std::void_t<decltype(std::declval<T const &>() == std::declval<T const &>())>> : std::true_type {};
+
+	/// A single step of the path to the member being compared.
+	struct DiffStep {
+		/// The name of a member or the key of a map entry, for steps that are not numeric.
+		std::string_view name;
+
+		/// The index of a sequence element or the numeric key of a map entry, for numeric steps.
+		long long number;
+
+		/// True if the step is formatted as `number` instead of `name`.
+		bool is_number;
+
+		/// True if the step is a sequence index.
+		bool is_index;
+	};
+
+	/// State of a running diff.
+	/**
+	 * The path is kept as a list of steps, and only formatted into a string when a difference is found.
+	 */
+	struct DiffState {
+		/// The differences found so far.
+		std::vector<Difference> differences;
+
+		/// The path to the member being compared.
+		std::vector<DiffStep> path;
+
+		/// If true, the old and new values are stored with each difference.
+		bool include_values;
+
+		/// Format the current path.
+		std::string formatPath() const {
+			std::string result;
+			for (std::size_t i = 0; i < path.size(); ++i) {
+				DiffStep const & step = path[i];
+				if (step.is_index && i != 0) result += '[';
+				if (!step.is_index && i != 0) result += '.';
+				if (step.is_number) result += std::to_string(step.number);
+				else result += step.name;
+				if (step.is_index && i != 0) result += ']';
+			}
+			return result;
+		}
+
+		/// Record a difference at the current path.
+		/**
+		 * A null pointer means the value does not exist in that object.
+		 */
+		template<typename T>
+		void add(T const * old_value, T const * new_value) {
+			Difference difference{formatPath(), std::nullopt, std::nullopt};
+			if constexpr (can_encode_yaml<T>) {
+				if (include_values && old_value) difference.old_value = encodeYaml(*old_value);
+				if (include_values && new_value) difference.new_value = encodeYaml(*new_value);
+			}
+			differences.push_back(std::move(difference));
+		}
+	};
+
+	template<typename T>
+	void diffInto(T const & a, T const & b, DiffState & state);
+
+	template<typename T>
+	void diffStep(T const & a, T const & b, DiffState & state, DiffStep step) {
+		state.path.push_back(step);
+		diffInto(a, b, state);
+		state.path.pop_back();
+	}
+
+	/// Get the path step for the key of a map entry.
+	template<typename Key>
+	DiffStep mapKeyStep(Key const & key) {
+		if constexpr (can_decompose_enum<Key>) {
+			if (std::optional<std::string_view> name = enumName(key)) return DiffStep{*name, 0, false, false};
+			return DiffStep{{}, static_cast<long long>(key), true, false};
+		} else if constexpr (std::is_integral_v<Key> || std::is_enum_v<Key>) {
+			return DiffStep{{}, static_cast<long long>(key), true, false};
+		} else {
+			return DiffStep{key, 0, false, false};
+		}
+	}
+
+	/// Get the entry an iterator points to, looking through pointers to entries.
+	template<typename Entry> Entry const & mapEntry(Entry const & entry) { return entry; }
+	template<typename Entry> Entry const & mapEntry(Entry const * entry) { return *entry; }
+
+	/// Diff two ranges of map entries that are sorted by key.
+	template<typename Mapped, typename Iterator, typename Compare>
+	void diffSortedEntries(Iterator i, Iterator end_a, Iterator j, Iterator end_b, Compare const & compare, DiffState & state) {
+		// Walk both sorted ranges at the same time.
+		while (i != end_a || j != end_b) {
+			if (j == end_b || (i != end_a && compare(mapEntry(*i).first, mapEntry(*j).first))) {
+				state.path.push_back(mapKeyStep(mapEntry(*i).first));
+				state.add<Mapped>(&mapEntry(*i).second, nullptr);
+				state.path.pop_back();
+				++i;
+			} else if (i == end_a || compare(mapEntry(*j).first, mapEntry(*i).first)) {
+				state.path.push_back(mapKeyStep(mapEntry(*j).first));
+				state.add<Mapped>(nullptr, &mapEntry(*j).second);
+				state.path.pop_back();
+				++j;
+			} else {
+				diffStep(mapEntry(*i).second, mapEntry(*j).second, state, mapKeyStep(mapEntry(*i).first));
+				++i;
+				++j;
+			}
+		}
+	}
+
+	template<typename Map>
+	void diffMaps(Map const & a, Map const & b, DiffState & state) {
+		using Mapped = typename Map::mapped_type;
+		if constexpr (is_std_map<Map>::value) {
+			diffSortedEntries<Mapped>(a.begin(), a.end(), b.begin(), b.end(), a.key_comp(), state);
+		} else if constexpr (is_flat_map<Map>::value) {
+			diffSortedEntries<Mapped>(a.begin(), a.end(), b.begin(), b.end(), a.keyCompare(), state);
+		} else {
+			// Sort the entries of unordered maps by key, so the differences are reported in a predictable order.
+			using Entry = typename Map::value_type;
+			using Key = typename Map::key_type;
+			auto sorted = [] (Map const & map) {
+				std::vector<Entry const *> entries;
+				entries.reserve(map.size());
+				for (Entry const & entry : map) entries.push_back(&entry);
+				std::sort(entries.begin(), entries.end(), [] (Entry const * x, Entry const * y) {
+					return std::less<Key>{}(x->first, y->first);
+				});
+				return entries;
+			};
+			std::vector<Entry const *> sorted_a = sorted(a);
+			std::vector<Entry const *> sorted_b = sorted(b);
+			diffSortedEntries<Mapped>(sorted_a.begin(), sorted_a.end(), sorted_b.begin(), sorted_b.end(), std::less<Key>{}, state);
+		}
+	}
+
+	template<typename T>
+	void diffInto(T const & a, T const & b, DiffState & state) {
+		// Identical objects can not differ.
+		if (&a == &b) return;
+
+		if constexpr (can_decompose<T>) {
+			// Keep the decomposition alive for the member names in the path.
+			auto const & members = cachedDecompose<T>();
+			estd::for_each(members, [&] (auto const & member) {
+				diffStep(member.access(a), member.access(b), state, DiffStep{member.name, 0, false, false});
+				return true;
+			});
+		} else if constexpr (std::is_floating_point_v<T>) {
+			// Treat NaN as equal to NaN, like they are in YAML.
+			if (!(a == b) && !(std::isnan(a) && std::isnan(b))) state.add(&a, &b);
+		} else if constexpr (std::is_same_v<T, YAML::Node>) {
+			if (!yamlEqual(a, b)) state.add(&a, &b);
+		} else if constexpr (is_std_vector<T>::value || is_std_array<T>::value) {
+			std::size_t common = std::min(a.size(), b.size());
+			for (std::size_t i = 0; i < common; ++i) diffStep(a[i], b[i], state, DiffStep{{}, static_cast<long long>(i), true, true});
+			// Bind the elements to a reference to the value type, since std::vector<bool> returns them by value.
+			for (std::size_t i = common; i < a.size(); ++i) {
+				typename T::value_type const & value = a[i];
+				state.path.push_back(DiffStep{{}, static_cast<long long>(i), true, true});
+				state.add<typename T::value_type>(&value, nullptr);
+				state.path.pop_back();
+			}
+			for (std::size_t i = common; i < b.size(); ++i) {
+				typename T::value_type const & value = b[i];
+				state.path.push_back(DiffStep{{}, static_cast<long long>(i), true, true});
+				state.add<typename T::value_type>(nullptr, &value);
+				state.path.pop_back();
+			}
+		} else if constexpr (is_std_optional<T>::value) {
+			if (a && b) diffInto(*a, *b, state);
+			else if (a || b) state.add(&a, &b);
+		} else if constexpr (is_std_shared_ptr<T>::value) {
+			if (a && b) diffInto(*a, *b, state);
+			else if (a || b) state.add(&a, &b);
+		} else if constexpr (is_std_map<T>::value || is_std_unordered_map<T>::value || is_flat_map<T>::value) {
+			diffMaps(a, b, state);
+		} else if constexpr (is_std_variant<T>::value) {
+			if (a.index() != b.index()) {
+				state.add(&a, &b);
+			} else {
+				std::visit([&] (auto const & value_a, auto const & value_b) {
+					if constexpr (std::is_same_v<decltype(value_a), decltype(value_b)>) diffInto(value_a, value_b, state);
+				}, a, b);
+			}
+		} else {
+			static_assert(is_equality_comparable<T>::value, "type T has no decomposition and can not be compared with ==");
+			if (!(a == b)) state.add(&a, &b);
+		}
+	}
+}
+
+/// Find the members that differ between two objects.
+/**
+ * The objects are compared member by member, following the decomposition of T.
+ * Sequences are compared element by element, and maps entry by entry.
+ * Other types are compared with `==`, except that NaN is considered equal to NaN.
+ *
+ * If `include_values` is true, each difference holds the old and new value as YAML node.
+ * Elements and map entries that exist in only one of the objects have only one value.
+ *
+ * The differences are returned in the order of the decomposition,
+ * and entries of unordered maps are visited in the order of their keys.
+ * YAML nodes are compared with yamlEqual().
+ */
+template<typename T>
+std::vector<Difference> diff(T const & a, T const & b, bool include_values = false) {
+	detail::DiffState state{{}, {}, include_values};
+	detail::diffInto(a, b, state);
+	return std::move(state.differences);
+}
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+ * This header defines a map that stores its entries in a sorted vector.
+ *
+ * It is meant for large lookup tables that are filled once and then only read,
+ * where a node based map wastes memory and cache locality on a node per entry.
+ */
+
+namespace dr {
+
+namespace detail {
+	/// Stable sort the entries of a flat map by key.
+	/**
+	 * Returns an iterator to the first of two entries with the same key, or the end iterator if all keys are unique.
+	 */
+	template<typename Key, typename Value, typename Compare>
+	typename std::vector<std::pair<Key, Value>>::iterator sortFlatMapEntries(std::vector<std::pair<Key, Value>> & entries, Compare const & compare) {
+		using Entry = std::pair<Key, Value>;
+		std::stable_sort(entries.begin(), entries.end(), [&] (Entry const & a, Entry const & b) {
+			return compare(a.first, b.first);
+		});
+		return std::adjacent_find(entries.begin(), entries.end(), [&] (Entry const & a, Entry const & b) {
+			return !compare(a.first, b.first);
+		});
+	}
+}
+
+/// A map that stores its entries in a vector, sorted by key.
+/**
+ * Lookups use a binary search.
+ * Inserting a single entry is linear in the size of the map,
+ * so fill the map at once from a vector of entries instead.
+ */
+template<typename Key, typename Value, typename Compare = std::less<Key>>
+class FlatMap {
+public:
+	using key_type       = Key;
+	using mapped_type    = Value;
+	using value_type     = std::pair<Key, Value>;
+	using key_compare    = Compare;
+	using size_type      = std::size_t;
+	using iterator       = typename std::vector<value_type>::iterator;
+	using const_iterator = typename std::vector<value_type>::const_iterator;
+
+private:
+	/// The entries, sorted by key without duplicates.
+	std::vector<value_type> entries_;
+
+	/// The comparison for keys.
+	Compare compare_;
+
+public:
+	/// Create an empty map.
+	FlatMap() = default;
+
+	/// Create an empty map with a custom comparison.
+	explicit FlatMap(Compare compare) : compare_{std::move(compare)} {}
+
+	/// Create a map from unsorted entries.
+	/**
+	 * If a key occurs more than once, only the first entry with that key is kept.
+	 */
+	explicit FlatMap(std::vector<value_type> entries, Compare compare = Compare{}) : entries_{std::move(entries)}, compare_{std::move(compare)} {
+		detail::sortFlatMapEntries(entries_, compare_);
+		auto last = std::unique(entries_.begin(), entries_.end(), [this] (value_type const & a, value_type const & b) {
+			return !compare_(a.first, b.first);
+		});
+		entries_.erase(last, entries_.end());
+	}
+
+	/// Create a map from entries that are already sorted by key without duplicates.
+	/**
+	 * The order of the entries is not checked.
+	 */
+	static FlatMap fromSorted(std::vector<value_type> entries, Compare compare = Compare{}) {
+		FlatMap result{std::move(compare)};
+		result.entries_ = std::move(entries);
+		return result;
+	}
+
+	/// Get the number of entries.
+	size_type size() const { return entries_.size(); }
+
+	/// Check if the map is empty.
+	bool empty() const { return entries_.empty(); }
+
+	/// Reserve space for a number of entries.
+	void reserve(size_type capacity) { entries_.reserve(capacity); }
+
+	/// Get the sorted entries.
+	std::vector<value_type> const & entries() const { return entries_; }
+
+	/// Get the comparison for keys.
+	Compare const & keyCompare() const { return compare_; }
+
+	iterator begin() { return entries_.begin(); }
+	iterator end()   { return entries_.end(); }
+	const_iterator begin() const { return entries_.begin(); }
+	const_iterator end()   const { return entries_.end(); }
+
+	/// Find the entry with a key, or end() if there is none.
+	iterator find(Key const & key) {
+		iterator result = lowerBound(key);
+		if (result == entries_.end() || compare_(key, result->first)) return entries_.end();
+		return result;
+	}
+
+	/// Find the entry with a key, or end() if there is none.
+	const_iterator find(Key const & key) const {
+		const_iterator result = lowerBound(key);
+		if (result == entries_.end() || compare_(key, result->first)) return entries_.end();
+		return result;
+	}
+
+	/// Check if the map has an entry with a key.
+	bool contains(Key const & key) const { return find(key) != end(); }
+
+	/// Count the entries with a key, either 0 or 1.
+	size_type count(Key const & key) const { return contains(key) ? 1 : 0; }
+
+	/// Get the value for a key.
+	/**
+	 * \throws std::out_of_range if the map has no entry with the key.
+	 */
+	Value & at(Key const & key) {
+		iterator result = find(key);
+		if (result == end()) throw std::out_of_range{"FlatMap::at: key not found"};
+		return result->second;
+	}
+
+	/// Get the value for a key.
+	/**
+	 * \throws std::out_of_range if the map has no entry with the key.
+	 */
+	Value const & at(Key const & key) const {
+		const_iterator result = find(key);
+		if (result == end()) throw std::out_of_range{"FlatMap::at: key not found"};
+		return result->second;
+	}
+
+	/// Insert an entry if the map has no entry with the same key yet.
+	/**
+	 * Returns an iterator to the entry with the key and true if the entry was inserted.
+	 */
+	std::pair<iterator, bool> insert(value_type entry) {
+		iterator position = lowerBound(entry.first);
+		if (position != entries_.end() && !compare_(entry.first, position->first)) return {position, false};
+		return {entries_.insert(position, std::move(entry)), true};
+	}
+
+	/// Get the first entry with a key that is not less than the given key.
+	iterator lowerBound(Key const & key) {
+		return std::lower_bound(entries_.begin(), entries_.end(), key, [this] (value_type const & entry, Key const & other) {
+			return compare_(entry.first, other);
+		});
+	}
+
+	/// Get the first entry with a key that is not less than the given key.
+	const_iterator lowerBound(Key const & key) const {
+		return std::lower_bound(entries_.begin(), entries_.end(), key, [this] (value_type const & entry, Key const & other) {
+			return compare_(entry.first, other);
+		});
+	}
+
+	friend bool operator==(FlatMap const & a, FlatMap const & b) { return a.entries_ == b.entries_; }
+	friend bool operator!=(FlatMap const & a, FlatMap const & b) { return a.entries_ != b.entries_; }
+};
+
+}
@@ -0,0 +1,210 @@
+#pragma once
+#include "decompose.hpp"
+#include "schema_hash.hpp"
+#include "type_traits.hpp"
+#include "yaml.hpp"
+
+#include <estd/tuple/for_each.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+/*
+ * This header contains utilities to hash and compare the values of objects.
+ *
+ * Like the schema hash, the hash and comparison are derived from the decomposition of a type (see decompose.hpp),
+ * and the standard library types that have YAML conversions in yaml.hpp.
+ * It is used amongst others to detect if a config changed, and to key caches on the contents of a config.
+ */
+
+namespace dr::param {
+
+template<typename T>
+void addHash(StableHash & hash, T const & value);
+
+namespace detail {
+	/// Add the structure and contents of a YAML node tree to a hash.
+	/**
+	 * Nodes that are equal according to yamlEqual() add the same data to the hash.
+	 */
+	void addYamlNodeHash(StableHash & hash, YAML::Node const & node);
+
+	/// Add a floating point value to a hash, such that values that compare equal give the same hash.
+	inline void addFloatHash(StableHash & hash, double value) {
+		// All NaNs are equal to each other, and positive and negative zero are equal.
+		if (std::isnan(value)) value = std::numeric_limits<double>::quiet_NaN();
+		if (value == 0) value = 0;
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		hash.add(bits);
+	}
+}
+
+/// Add the value of an object to a hash.
+/**
+ * The hash includes the names and values of all members in the decomposition of T,
+ * so renaming a member changes the hash, even if the value stays the same.
+ *
+ * Standard containers with YAML conversions are hashed element by element,
+ * where the hash of an unordered map does not depend on the iteration order of its entries,
+ * and shared pointers are hashed by the value they point to.
+ * Enums with a decomposition are hashed by the name of their value.
+ * Floating point values are hashed such that NaN and signed zeroes hash the same as when they are compared with equal().
+ *
+ * The hash only depends on the value, not on the platform or process, so it can safely be stored.
+ */
+template<typename T>
+void addHash(StableHash & hash, T const & value) {
+	if constexpr (can_decompose<T>) {
+		auto const & members = cachedDecompose<T>();
+		hash.add(std::uint64_t(std::tuple_size_v<std::decay_t<decltype(members)>>));
+		estd::for_each(members, [&] (auto const & member) {
+			hash.add(std::string_view{member.name});
+			addHash(hash, member.access(value));
+			return true;
+		});
+	} else if constexpr (can_decompose_enum<T>) {
+		if (std::optional<std::string_view> name = enumName(value)) hash.add(*name);
+		else hash.add(std::uint64_t(value));
+	} else if constexpr (std::is_same_v<T, bool>) {
+		hash.add(std::uint8_t(value));
+	} else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+		hash.add(std::uint64_t(value));
+	} else if constexpr (std::is_floating_point_v<T>) {
+		detail::addFloatHash(hash, double(value));
+	} else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+		hash.add(std::string_view{value});
+	} else if constexpr (std::is_same_v<T, YAML::Node>) {
+		detail::addYamlNodeHash(hash, value);
+	} else if constexpr (detail::is_std_vector<T>::value || detail::is_std_array<T>::value) {
+		hash.add(std::uint64_t(value.size()));
+		for (typename T::value_type const & element : value) addHash(hash, element);
+	} else if constexpr (detail::is_std_optional<T>::value) {
+		hash.add(std::uint8_t(value.has_value()));
+		if (value) addHash(hash, *value);
+	} else if constexpr (detail::is_std_shared_ptr<T>::value) {
+		// Shared values are hashed like optional values, the identity of the object does not matter.
+		hash.add(std::uint8_t(value != nullptr));
+		if (value) addHash(hash, *value);
+	} else if constexpr (detail::is_std_map<T>::value || detail::is_flat_map<T>::value) {
+		hash.add(std::uint64_t(value.size()));
+		for (auto const & [key, mapped] : value) {
+			addHash(hash, key);
+			addHash(hash, mapped);
+		}
+	} else if constexpr (detail::is_std_unordered_map<T>::value) {
+		// The iteration order is unspecified, so combine the hashes of the entries in an order independent way.
+		std::uint64_t entries = 0;
+		for (auto const & [key, mapped] : value) {
+			StableHash entry;
+			addHash(entry, key);
+			addHash(entry, mapped);
+			entries += entry.value();
+		}
+		hash.add(std::uint64_t(value.size()));
+		hash.add(entries);
+	} else if constexpr (detail::is_std_variant<T>::value) {
+		hash.add(std::uint64_t(value.index()));
+		std::visit([&] (auto const & alternative) { addHash(hash, alternative); }, value);
+	} else {
+		static_assert(!sizeof(T *), "type T has no decomposition and no YAML conversion in yaml.hpp");
+	}
+}
+
+/// Compute a stable hash of the value of an object.
+/**
+ * See addHash() for the details of what is included in the hash.
+ * Objects that compare equal with equal() have the same hash.
+ */
+template<typename T>
+std::uint64_t hash(T const & value) {
+	StableHash result;
+	addHash(result, value);
+	return result.value();
+}
+
+/// Compare the values of two objects.
+/**
+ * The objects are compared member by member, following the decomposition of T.
+ * Standard containers with YAML conversions are compared element by element,
+ * shared pointers are compared by the value they point to,
+ * YAML nodes are compared with yamlEqual() and other types are compared with `==`,
+ * except that NaN is considered equal to NaN.
+ *
+ * The comparison stops at the first difference.
+ */
+template<typename T>
+bool equal(T const & a, T const & b) {
+	if (&a == &b) return true;
+
+	if constexpr (can_decompose<T>) {
+		auto const & members = cachedDecompose<T>();
+		std::size_t stopped_at = estd::for_each(members, [&] (auto const & member) {
+			return param::equal(member.access(a), member.access(b));
+		});
+		return stopped_at == std::tuple_size_v<std::decay_t<decltype(members)>>;
+	} else if constexpr (std::is_floating_point_v<T>) {
+		return a == b || (std::isnan(a) && std::isnan(b));
+	} else if constexpr (std::is_same_v<T, YAML::Node>) {
+		return yamlEqual(a, b);
+	} else if constexpr (detail::is_std_vector<T>::value || detail::is_std_array<T>::value) {
+		if (a.size() != b.size()) return false;
+		for (std::size_t i = 0; i < a.size(); ++i) {
+			if (!param::equal<typename T::value_type>(a[i], b[i])) return false;
+		}
+		return true;
+	} else if constexpr (detail::is_std_optional<T>::value) {
+		if (a.has_value() != b.has_value()) return false;
+		return !a || param::equal(*a, *b);
+	} else if constexpr (detail::is_std_shared_ptr<T>::value) {
+		if ((a == nullptr) != (b == nullptr)) return false;
+		return !a || param::equal(*a, *b);
+	} else if constexpr (detail::is_std_map<T>::value || detail::is_flat_map<T>::value) {
+		if (a.size() != b.size()) return false;
+		for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j) {
+			if (!param::equal(i->first, j->first) || !param::equal(i->second, j->second)) return false;
+		}
+		return true;
+	} else if constexpr (detail::is_std_unordered_map<T>::value) {
+		if (a.size() != b.size()) return false;
+		for (auto const & [key, mapped] : a) {
+			auto other = b.find(key);
+			if (other == b.end() || !param::equal(mapped, other->second)) return false;
+		}
+		return true;
+	} else if constexpr (detail::is_std_variant<T>::value) {
+		if (a.index() != b.index()) return false;
+		return std::visit([] (auto const & value_a, auto const & value_b) {
+			if constexpr (std::is_same_v<decltype(value_a), decltype(value_b)>) return param::equal(value_a, value_b);
+			else return false;
+		}, a, b);
+	} else {
+		return a == b;
+	}
+}
+
+/// Function object to use hash() in unordered containers.
+struct StructuralHash {
+	template<typename T>
+	std::size_t operator()(T const & value) const {
+		return std::size_t(param::hash(value));
+	}
+};
+
+/// Function object to use equal() in unordered containers.
+struct StructuralEqual {
+	template<typename T>
+	bool operator()(T const & a, T const & b) const {
+		return param::equal(a, b);
+	}
+};
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "yaml.hpp"
+
+#include <estd/result.hpp>
+
+#include <string>
+#include <string_view>
+
+/**
+ * This header defines a fast reader for JSON documents.
+ *
+ * JSON is a subset of YAML, so yaml-cpp can read JSON documents too, but it is slow for large documents.
+ * This reader produces the same node tree as yaml-cpp in a single pass,
+ * so the result can be decoded with parseYaml<T>() like any other document.
+ */
+
+namespace dr {
+
+/// Load a JSON document from a buffer.
+/**
+ * The resulting node tree is equal to the tree yaml-cpp produces for the same document,
+ * including the tags and the flow style of maps and sequences.
+ *
+ * Syntax errors are reported as YamlError with the line and column of the error.
+ */
+YamlResult<YAML::Node> loadJson(std::string_view data);
+
+/// Read a JSON file from a path.
+/**
+ * readYamlFile() uses this function for files with a `.json` extension.
+ */
+estd::result<YAML::Node, estd::error> readJsonFile(std::string const & path);
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+/*
+ * This header contains a small work-stealing scheduler to run independent tasks in parallel.
+ *
+ * It is used amongst others to load and parse many YAML files at once.
+ */
+
+namespace dr::param {
+
+/// Get the default number of threads to use for parallel work.
+/**
+ * This is the number of hardware threads, or 1 if that can not be determined.
+ */
+std::size_t defaultThreadCount();
+
+/// Run a task for each index in [0, count) on a pool of worker threads.
+/**
+ * Each worker starts with an equal share of the indices.
+ * Workers that run out of work steal half of the remaining indices of another worker,
+ * so uneven task durations are balanced automatically.
+ *
+ * The task must not throw exceptions.
+ * The function returns when all tasks have finished.
+ *
+ * If `threads` is 0, defaultThreadCount() is used.
+ * No more threads are started than there are tasks, and with a single thread the tasks run on the calling thread.
+ * If a thread can not be started, the tasks run on the threads that did start.
+ *
+ * A parallelFor() called from a task of another parallelFor() runs its tasks serially on the calling thread,
+ * so nested parallel work is bounded by the number of threads of the outer call.
+ */
+void parallelFor(std::size_t count, std::function<void(std::size_t index)> const & task, std::size_t threads = 0);
+
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include "decompose.hpp"
+#include "type_traits.hpp"
+
+#include <estd/tuple/for_each.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeindex>
+#include <variant>
+#include <vector>
+
+/*
+ * This header contains utilities to compute a hash of the structure of a type.
+ *
+ * The hash is derived from the decomposition of a type (see decompose.hpp),
+ * and the standard library types that have YAML conversions in yaml.hpp.
+ * It is used amongst others to detect if a stored snapshot of a config was made for a different version of a type.
+ */
+
+namespace dr::param {
+
+/// Simple stable 64 bit hash based on FNV-1a.
+/**
+ * The hash only depends on the data added to it, not on the platform or process,
+ * so it can safely be stored in files.
+ */
+class StableHash {
+	std::uint64_t state_ = 14695981039346656037ull;
+
+public:
+	/// Add a single byte to the hash.
+	void add(std::uint8_t byte) noexcept {
+		state_ ^= byte;
+		state_ *= 1099511628211ull;
+	}
+
+	/// Add an integer to the hash, in little endian byte order.
+	void add(std::uint64_t value) noexcept {
+		for (int i = 0; i < 8; ++i) add(std::uint8_t(value >> (8 * i)));
+	}
+
+	/// Add a string to the hash, including the length so that concatenations can not collide.
+	void add(std::string_view data) noexcept {
+		add(std::uint64_t(data.size()));
+		for (char c : data) add(std::uint8_t(c));
+	}
+
+	/// Get the current value of the hash.
+	std::uint64_t value() const noexcept {
+		return state_;
+	}
+};
+
+namespace detail {
+	template<typename T>
+	void addSchemaHash(StableHash & hash, std::vector<std::type_index> & stack);
+
+	template<typename... Ts>
+	void addVariantSchemaHash(StableHash & hash, std::vector<std::type_index> & stack, std::variant<Ts...> const *) {
+		hash.add(std::uint64_t(sizeof...(Ts)));
+		(addSchemaHash<Ts>(hash, stack), ...);
+	}
+
+	/// Add the structure of a type to a hash.
+	/**
+	 * The stack holds the decomposable types that are currently being added, from outer to inner.
+	 */
+	template<typename T>
+	void addSchemaHash(StableHash & hash, std::vector<std::type_index> & stack) {
+		if constexpr (can_decompose<T>) {
+			// Recursive types refer back to the enclosing occurrence of the type, by the number of levels to go up.
+			auto found = std::find(stack.begin(), stack.end(), std::type_index{typeid(T)});
+			if (found != stack.end()) {
+				hash.add(std::string_view{"recursive"});
+				hash.add(std::uint64_t(stack.end() - found));
+				return;
+			}
+
+			stack.push_back(typeid(T));
+			auto members = decompose<T>();
+			hash.add(std::string_view{"struct"});
+			hash.add(std::uint64_t(std::tuple_size_v<decltype(members)>));
+			estd::for_each(members, [&] (auto const & member) {
+				using member_type = std::decay_t<decltype(member.access(std::declval<T const &>()))>;
+				hash.add(std::string_view{member.name});
+				hash.add(std::uint8_t(member.required));
+				addSchemaHash<member_type>(hash, stack);
+			});
+			stack.pop_back();
+		} else if constexpr (can_decompose_enum<T>) {
+			constexpr auto const & table = EnumDecomposition<T>::table;
+			hash.add(std::string_view{"enum"});
+			hash.add(std::uint64_t(table.size()));
+			for (std::size_t i = 0; i < table.size(); ++i) hash.add(table.name(i));
+		} else if constexpr (std::is_same_v<T, bool>) {
+			hash.add(std::string_view{"bool"});
+		} else if constexpr (std::is_integral_v<T>) {
+			hash.add(std::string_view{std::is_signed_v<T> ? "int" : "uint"});
+			hash.add(std::uint64_t(sizeof(T)));
+		} else if constexpr (std::is_floating_point_v<T>) {
+			hash.add(std::string_view{"float"});
+			hash.add(std::uint64_t(sizeof(T)));
+		} else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+			hash.add(std::string_view{"string"});
+		} else if constexpr (is_std_vector<T>::value) {
+			hash.add(std::string_view{"vector"});
+			addSchemaHash<typename T::value_type>(hash, stack);
+		} else if constexpr (is_std_array<T>::value) {
+			hash.add(std::string_view{"array"});
+			hash.add(std::uint64_t(std::tuple_size_v<T>));
+			addSchemaHash<typename T::value_type>(hash, stack);
+		} else if constexpr (is_std_optional<T>::value) {
+			hash.add(std::string_view{"optional"});
+			addSchemaHash<typename T::value_type>(hash, stack);
+		} else if constexpr (is_std_shared_ptr<T>::value) {
+			hash.add(std::string_view{"shared_ptr"});
+			addSchemaHash<std::remove_const_t<typename T::element_type>>(hash, stack);
+		} else if constexpr (is_std_map<T>::value) {
+			hash.add(std::string_view{"map"});
+			addSchemaHash<typename T::key_type>(hash, stack);
+			addSchemaHash<typename T::mapped_type>(hash, stack);
+		} else if constexpr (is_std_unordered_map<T>::value) {
+			hash.add(std::string_view{"unordered_map"});
+			addSchemaHash<typename T::key_type>(hash, stack);
+			addSchemaHash<typename T::mapped_type>(hash, stack);
+		} else if constexpr (is_flat_map<T>::value) {
+			hash.add(std::string_view{"flat_map"});
+			addSchemaHash<typename T::key_type>(hash, stack);
+			addSchemaHash<typename T::mapped_type>(hash, stack);
+		} else if constexpr (is_std_variant<T>::value) {
+			hash.add(std::string_view{"variant"});
+			addVariantSchemaHash(hash, stack, static_cast<T const *>(nullptr));
+		} else {
+			hash.add(std::string_view{"opaque"});
+		}
+	}
+}
+
+/// Add the structure of a type to a hash.
+/**
+ * Decomposable types add the name, required flag and structure of each member.
+ * Enums with an enum decomposition add the names of their values.
+ * Standard containers add their kind and the structure of their elements.
+ * Arithmetic types add their kind and size.
+ *
+ * A decomposable type that occurs inside itself adds a back reference to the enclosing occurrence,
+ * so recursive types have a finite hash.
+ *
+ * All other types are treated as opaque: they add a fixed marker, regardless of their contents.
+ */
+template<typename T>
+void addSchemaHash(StableHash & hash) {
+	std::vector<std::type_index> stack;
+	detail::addSchemaHash<T>(hash, stack);
+}
+
+/// Compute a hash of the structure of a type.
+/**
+ * See addSchemaHash() for the details of what is included in the hash.
+ * The hash changes when members are added, removed, renamed or change type,
+ * so it can be used to detect if stored data was written for a different version of a type.
+ */
+template<typename T>
+std::uint64_t schemaHash() {
+	StableHash hash;
+	addSchemaHash<T>(hash);
+	return hash.value();
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+/*
+ * This header contains a compile-time lookup table for a fixed set of names.
+ *
+ * It is used amongst others to select the alternative of a std::variant by name when parsing YAML,
+ * without having to try each alternative in turn.
+ */
+
+namespace dr::param {
+
+namespace detail {
+	/// Convert an ASCII character to lowercase, leaving all other characters untouched.
+	constexpr char asciiToLower(char c) noexcept {
+		if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+		return c;
+	}
+
+	/// Compute the 32 bit FNV-1a hash of a string, optionally ignoring ASCII case.
+	template<bool IgnoreCase = false>
+	constexpr std::uint32_t fnv1a(std::string_view data) noexcept {
+		std::uint32_t hash = 2166136261u;
+		for (char c : data) {
+			if constexpr (IgnoreCase) c = asciiToLower(c);
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	/// Compare two strings for equality, optionally ignoring ASCII case.
+	template<bool IgnoreCase = false>
+	constexpr bool stringEqual(std::string_view a, std::string_view b) noexcept {
+		if constexpr (!IgnoreCase) {
+			return a == b;
+		} else {
+			if (a.size() != b.size()) return false;
+			for (std::size_t i = 0; i < a.size(); ++i) {
+				if (asciiToLower(a[i]) != asciiToLower(b[i])) return false;
+			}
+			return true;
+		}
+	}
+
+	/// Get the number of buckets to use for a table of N names.
+	/**
+	 * This is the smallest power of two that is atleast twice as large as N,
+	 * to keep the probe sequences of the open addressing short.
+	 */
+	constexpr std::size_t stringTableBuckets(std::size_t n) noexcept {
+		std::size_t result = 1;
+		while (result < 2 * n) result *= 2;
+		return result;
+	}
+}
+
+/// Compile-time hash table that maps a fixed set of names to their index.
+/**
+ * The table uses open addressing with linear probing,
+ * so a lookup hashes the name once and usually needs only a single string comparison.
+ *
+ * The table can be constructed in a constant expression.
+ * Constructing it with duplicate names is an error, and fails to compile when done in a constant expression.
+ *
+ * If IgnoreCase is true, names are matched without regard for ASCII case.
+ * The lookup still does not allocate or copy the name.
+ */
+template<std::size_t N, bool IgnoreCase = false>
+class StringTable {
+	static constexpr std::size_t bucket_count = detail::stringTableBuckets(N);
+
+	/// The names in the table, in the order given to the constructor.
+	std::array<std::string_view, N> names_;
+
+	/// The buckets of the hash table, holding the index of a name plus one, or zero for empty buckets.
+	std::array<std::size_t, bucket_count> buckets_;
+
+public:
+	/// Create a table from a list of names.
+	constexpr explicit StringTable(std::array<std::string_view, N> const & names) : names_{names}, buckets_{} {
+		for (std::size_t i = 0; i < N; ++i) {
+			std::size_t bucket = detail::fnv1a<IgnoreCase>(names_[i]) % bucket_count;
+			while (buckets_[bucket] != 0) {
+				if (detail::stringEqual<IgnoreCase>(names_[buckets_[bucket] - 1], names_[i])) throw std::logic_error("duplicate name in StringTable");
+				bucket = (bucket + 1) % bucket_count;
+			}
+			buckets_[bucket] = i + 1;
+		}
+	}
+
+	/// Get the number of names in the table.
+	constexpr std::size_t size() const noexcept {
+		return N;
+	}
+
+	/// Get the name at the given index.
+	constexpr std::string_view name(std::size_t index) const {
+		return names_[index];
+	}
+
+	/// Find the index of a name, or std::nullopt if the name is not in the table.
+	constexpr std::optional<std::size_t> find(std::string_view name) const noexcept {
+		std::size_t bucket = detail::fnv1a<IgnoreCase>(name) % bucket_count;
+		while (buckets_[bucket] != 0) {
+			std::size_t index = buckets_[bucket] - 1;
+			if (detail::stringEqual<IgnoreCase>(names_[index], name)) return index;
+			bucket = (bucket + 1) % bucket_count;
+		}
+		return std::nullopt;
+	}
+};
+
+}
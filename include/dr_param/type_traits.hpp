@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace dr {
+	template<typename Key, typename Value, typename Compare> class FlatMap;
+}
+
+/*
+ * This header contains traits to recognize the standard library types that have YAML conversions in yaml.hpp.
+ *
+ * They are used by the utilities that walk through the structure of a type,
+ * like the schema hash and path-selective decoding.
+ */
+
+namespace dr::param::detail {
+
+template<typename T> struct is_std_vector : std::false_type {};
+template<typename T, typename A> struct is_std_vector<std::vector<T, A>> : std::true_type {};
+
+template<typename T> struct is_std_array : std::false_type {};
+template<typename T, std::size_t N> struct is_std_array<std::array<T, N>> : std::true_type {};
+
+template<typename T> struct is_std_optional : std::false_type {};
+template<typename T> struct is_std_optional<std::optional<T>> : std::true_type {};
+
+template<typename T> struct is_std_shared_ptr : std::false_type {};
+template<typename T> struct is_std_shared_ptr<std::shared_ptr<T>> : std::true_type {};
+
+template<typename T> struct is_std_map : std::false_type {};
+template<typename K, typename V, typename C, typename A> struct is_std_map<std::map<K, V, C, A>> : std::true_type {};
+
+template<typename T> struct is_std_unordered_map : std::false_type {};
+template<typename K, typename V, typename H, typename E, typename A> struct is_std_unordered_map<std::unordered_map<K, V, H, E, A>> : std::true_type {};
+
+template<typename T> struct is_flat_map : std::false_type {};
+template<typename K, typename V, typename C> struct is_flat_map<FlatMap<K, V, C>> : std::true_type {};
+
+template<typename T> struct is_std_variant : std::false_type {};
+template<typename... Ts> struct is_std_variant<std::variant<Ts...>> : std::true_type {};
+
+}
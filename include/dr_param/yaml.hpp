@@ -1,4 +1,8 @@
 #pragma once
+#include "flat_map.hpp"
+#include "string_table.hpp"
+#include "type_traits.hpp"
+
 #include <estd/result.hpp>
 #include <estd/convert/convert.hpp>
 #include <estd/convert/traits.hpp>
@@ -6,10 +10,23 @@
 #include <yaml-cpp/yaml.h>
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <locale>
+#include <map>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
 
 /**
  * This header defines a system to convert complex structs to/from YAML representation.
@@ -30,21 +47,46 @@ struct YamlNodeDescription {
 	YAML::NodeType::value node_type;
 };
 
-/// An error that occured during the conversion of a node tree to an object.
-struct YamlError {
-	/// A human readable description of the error.
-	std::string message;
+namespace detail {
+	struct YamlErrorData;
+}
 
-	/// A trace through the node tree to the root node.
-	std::vector<YamlNodeDescription> trace;
+/// An error that occured during the conversion of a node tree to an object.
+/**
+ * The error is a single pointer to heap allocated data,
+ * so it adds little to the size of every YamlResult<T> and costs nothing to move on the success path.
+ *
+ * The trace is recorded as a stack of frames while the error propagates up from the failing node.
+ * Frames for sequence indices store the index itself and are only formatted when the trace is requested.
+ */
+class YamlError {
+	/// The message and trace, or null if the error was moved from.
+	std::unique_ptr<detail::YamlErrorData> data_;
 
+public:
 	/// Create a new YAML error.
 	explicit YamlError(std::string message, std::vector<YamlNodeDescription> node_path = {});
 
+	YamlError(YamlError const & other);
+	YamlError(YamlError && other) noexcept;
+	YamlError & operator=(YamlError const & other);
+	YamlError & operator=(YamlError && other) noexcept;
+	~YamlError();
+
+	/// Get a human readable description of the error.
+	std::string const & message() const;
+
+	/// Get the trace through the node tree to the root node, starting at the node that caused the error.
+	std::vector<YamlNodeDescription> trace() const;
+
 	/// Append a node description to the trace.
 	YamlError  & appendTrace(YamlNodeDescription description) &;
 	YamlError && appendTrace(YamlNodeDescription description) &&;
 
+	/// Append an element of a sequence to the trace.
+	YamlError  & appendTrace(std::size_t index, YAML::NodeType::value node_type) &;
+	YamlError && appendTrace(std::size_t index, YAML::NodeType::value node_type) &&;
+
 	/// Format the node trace as a string.
 	std::string formatTrace() const;
 
@@ -64,13 +106,227 @@ constexpr bool can_encode_yaml = estd::can_convert<T, YAML::Node>;
 template<typename T>
 constexpr bool can_parse_yaml = estd::can_convert<YAML::Node, YamlResult<T>>;
 
+/// Limits on the resources used to preprocess and decode a document.
+/**
+ * All limits are disabled by default.
+ * Set them when processing documents from untrusted sources,
+ * to fail quickly on include cycles, huge files or documents that use aliases to expand exponentially.
+ */
+struct YamlLimits {
+	/// Maximum nesting depth of included files during preprocessing.
+	std::size_t max_include_depth = std::numeric_limits<std::size_t>::max();
+
+	/// Maximum number of bytes read from files during preprocessing, including the root file.
+	std::uint64_t max_bytes_read = std::numeric_limits<std::uint64_t>::max();
+
+	/// Maximum number of nodes visited while preprocessing a document or while decoding it.
+	/**
+	 * A node that is reachable through multiple aliases is counted each time it is visited.
+	 */
+	std::size_t max_nodes = std::numeric_limits<std::size_t>::max();
+
+	/// Maximum number of elements in a sequence or entries in a map decoded into a container.
+	std::size_t max_sequence_length = std::numeric_limits<std::size_t>::max();
+
+	/// Maximum time spent decoding a document.
+	/**
+	 * The time is only checked every few hundred nodes, so it can be exceeded slightly.
+	 */
+	std::chrono::steady_clock::duration max_decode_time = std::chrono::steady_clock::duration::max();
+};
+
+namespace detail {
+	/// Resources used so far by the decoding on a thread.
+	struct YamlDecodeBudget {
+		/// The limits to enforce.
+		YamlLimits limits;
+
+		/// The number of nodes decoded so far.
+		std::size_t nodes = 0;
+
+		/// The time point after which decoding fails, or the maximum time point if there is no time limit.
+		std::chrono::steady_clock::time_point deadline;
+
+		/// Create the error for exceeding the node limit or the time limit.
+		YamlError exceeded() const;
+
+		/// Create the error for a sequence or map that is too long.
+		YamlError tooLong(std::size_t length) const;
+
+		/// Account for decoding one more node.
+		std::optional<YamlError> addNode() {
+			++nodes;
+			if (nodes > limits.max_nodes) return exceeded();
+			if (nodes % 256 == 0 && deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() > deadline) return exceeded();
+			return std::nullopt;
+		}
+	};
+
+	/// The decode budget of the calling thread, or null if decoding is not limited.
+	inline thread_local YamlDecodeBudget * current_yaml_decode_budget = nullptr;
+
+	/// Check the length of a sequence or map against the decode budget of the calling thread.
+	inline std::optional<YamlError> checkYamlLength(YAML::Node const & node) {
+		YamlDecodeBudget const * budget = current_yaml_decode_budget;
+		if (!budget) return std::nullopt;
+		std::size_t length = node.size();
+		if (length > budget->limits.max_sequence_length) return budget->tooLong(length);
+		return std::nullopt;
+	}
+}
+
+/// Enforce limits on all decoding by the calling thread while the scope exists.
+/**
+ * The limits apply to the total of all parseYaml() calls made during the lifetime of the scope.
+ * Scopes can be nested, in which case the innermost scope is used until it is destroyed.
+ */
+class YamlLimitsScope {
+	/// The resources used by decoding in this scope.
+	detail::YamlDecodeBudget budget_;
+
+	/// The budget of the enclosing scope, restored when this scope ends.
+	detail::YamlDecodeBudget * previous_;
+
+public:
+	/// Start enforcing the given limits.
+	explicit YamlLimitsScope(YamlLimits const & limits);
+
+	YamlLimitsScope(YamlLimitsScope const &) = delete;
+	YamlLimitsScope & operator=(YamlLimitsScope const &) = delete;
+
+	/// Stop enforcing the limits.
+	~YamlLimitsScope();
+};
+
+namespace detail {
+	/// Prefix of the tag of a deferred include, see YamlPreprocessOptions::lazy_includes in yaml_preprocess.hpp.
+	constexpr std::string_view yaml_deferred_include_tag = "!deferred_include";
+
+	/// Check if a tag is reserved for deferred includes.
+	inline bool isYamlDeferredIncludeTag(std::string const & tag) {
+		return tag.compare(0, yaml_deferred_include_tag.size(), yaml_deferred_include_tag) == 0;
+	}
+
+	/// Create the error for decoding a deferred include of a file that was never resolved.
+	YamlError unresolvedYamlInclude(std::string_view path);
+
+	/// Decoded values of the nodes in a document that are reachable through more than one path.
+	class YamlAliasMemo {
+		/// The document, kept alive so the identities of its nodes can not be reused by other nodes.
+		YAML::Node root_;
+
+		/// The identities of the nodes that are reachable through more than one path.
+		std::unordered_set<void const *> aliased_;
+
+		/// The decoded values, by node identity and type.
+		std::map<std::pair<void const *, std::type_index>, std::shared_ptr<void const>> values_;
+
+	public:
+		/// Find the aliased nodes in a document.
+		explicit YamlAliasMemo(YAML::Node const & root);
+
+		/// Get the identity of a node if it is reachable through more than one path, or null otherwise.
+		void const * aliasedIdentity(YAML::Node const & node) const;
+
+		/// Get the storage for the decoded value of a node as type T.
+		template<typename T>
+		std::shared_ptr<void const> & value(void const * identity) {
+			return values_[{identity, std::type_index{typeid(T)}}];
+		}
+	};
+
+	/// The alias memo of the calling thread, or null if decoding is not memoized.
+	inline thread_local YamlAliasMemo * current_yaml_alias_memo = nullptr;
+
+	/// Decode a node as shared value, reusing the value decoded for an earlier alias of the same node.
+	/**
+	 * The identity must be the aliased identity of the node in the memo, or null to decode without memoization.
+	 */
+	template<typename T>
+	YamlResult<std::shared_ptr<T const>> parseYamlShared(YAML::Node const & node, YamlAliasMemo * memo, void const * identity) {
+		if (identity) {
+			if (std::shared_ptr<void const> const & cached = memo->value<T>(identity)) return std::static_pointer_cast<T const>(cached);
+		}
+
+		YamlResult<T> result = estd::parse<T, YamlError>(node);
+		if (!result) return std::move(result.error());
+
+		auto shared = std::make_shared<T const>(std::move(*result));
+		if (identity) memo->value<T>(identity) = shared;
+		return shared;
+	}
+}
+
+/// Decode each node reachable through multiple aliases only once per type, while the scope exists.
+/**
+ * YAML anchors and aliases refer to the same node, but each alias is normally decoded separately.
+ * Within this scope, decoding an aliased node of the given document as the same type again copies the earlier result,
+ * and decoding it as `std::shared_ptr<T const>` shares the earlier result without copying it.
+ *
+ * Only maps and sequences are memoized, decoding scalars is cheaper than looking them up.
+ * Errors are not memoized.
+ *
+ * The scope keeps the document alive, but the document must not be modified while the scope exists.
+ * Scopes can be nested, in which case the innermost scope is used until it is destroyed.
+ */
+class YamlAliasScope {
+	/// The aliased nodes and their decoded values.
+	detail::YamlAliasMemo memo_;
+
+	/// The memo of the enclosing scope, restored when this scope ends.
+	detail::YamlAliasMemo * previous_;
+
+public:
+	/// Start memoizing the decoding of aliased nodes in a document.
+	explicit YamlAliasScope(YAML::Node const & root);
+
+	YamlAliasScope(YamlAliasScope const &) = delete;
+	YamlAliasScope & operator=(YamlAliasScope const &) = delete;
+
+	/// Stop memoizing.
+	~YamlAliasScope();
+};
+
 /// Parse a YAML::Node into a type T.
 template<typename T>
 YamlResult<T> parseYaml(YAML::Node const & node) {
 	static_assert(can_parse_yaml<T>, "No YAML conversion defined for T");
+	if (detail::YamlDecodeBudget * budget = detail::current_yaml_decode_budget) {
+		if (std::optional<YamlError> error = budget->addNode()) return std::move(*error);
+	}
+	if constexpr (!std::is_same_v<T, YAML::Node>) {
+		// Deferred includes hold the path of the included file, which must not be mistaken for its contents.
+		if (node.IsDefined() && node.IsScalar() && detail::isYamlDeferredIncludeTag(node.Tag())) return detail::unresolvedYamlInclude(node.Scalar());
+	}
+	if constexpr (std::is_copy_constructible_v<T>) {
+		if (detail::YamlAliasMemo * memo = detail::current_yaml_alias_memo) {
+			if (void const * identity = memo->aliasedIdentity(node)) {
+				YamlResult<std::shared_ptr<T const>> shared = detail::parseYamlShared<T>(node, memo, identity);
+				if (!shared) return std::move(shared.error());
+				return T(**shared);
+			}
+		}
+	}
 	return estd::parse<T, YamlError>(node);
 }
 
+/// Parse a YAML::Node into a type T, decoding each aliased node only once.
+/**
+ * See YamlAliasScope for details.
+ */
+template<typename T>
+YamlResult<T> parseYamlShared(YAML::Node const & node) {
+	YamlAliasScope scope{node};
+	return parseYaml<T>(node);
+}
+
+/// Parse a YAML::Node into a type T, while enforcing resource limits.
+template<typename T>
+YamlResult<T> parseYaml(YAML::Node const & node, YamlLimits const & limits) {
+	YamlLimitsScope scope{limits};
+	return parseYaml<T>(node);
+}
+
 /// Encode a value T into a YAML::Node.
 template<typename T>
 YAML::Node encodeYaml(T const & value) {
@@ -78,6 +334,130 @@ YAML::Node encodeYaml(T const & value) {
 	return estd::convert<YAML::Node>(value);
 }
 
+/// Name of a type when it is used as alternative of a std::variant.
+/**
+ * Specialize this struct with a `static constexpr std::string_view value` to allow T to be used in a std::variant.
+ *
+ * The name is used as YAML tag of the node holding the alternative (without the leading `!`),
+ * or as value of the discriminator key (see yaml_variant_discriminator).
+ */
+template<typename T>
+struct yaml_variant_name;
+
+/// Discriminator key used to select the alternative of a std::variant from a YAML map.
+/**
+ * By default this is empty, and the alternative can only be selected with a YAML tag.
+ *
+ * Specialize this struct for a std::variant with a non-empty `static constexpr std::string_view value`
+ * to also allow a key in the map to select the alternative.
+ * The key is not passed on to the alternative itself, unless it is a decomposable type with a member of the same name.
+ *
+ * An alternative that has its own property with the name of the discriminator key is encoded with a tag instead.
+ */
+template<typename Variant>
+struct yaml_variant_discriminator {
+	static constexpr std::string_view value = "";
+};
+
+namespace detail {
+	template<typename T, typename = void> struct has_yaml_variant_name_ : std::false_type {};
+	template<typename T> struct has_yaml_variant_name_<T, std::void_t<decltype(yaml_variant_name<T>::value)>> : std::true_type {};
+}
+
+/// Trait to check if a type has a name to use as alternative of a std::variant.
+template<typename T>
+constexpr bool has_yaml_variant_name = detail::has_yaml_variant_name_<T>::value;
+
+namespace detail {
+	/// Get the name from an explicit YAML tag on a node, without the leading `!`.
+	/**
+	 * Returns std::nullopt if the node has no tag, or only the non-specific `?` or `!` tag.
+	 */
+	std::optional<std::string_view> yamlTagName(YAML::Node const & node);
+
+	/// Copy a map node without the given key.
+	/**
+	 * The child nodes are not deep-copied, only the map itself.
+	 */
+	YAML::Node removeYamlKey(YAML::Node const & node, std::string_view key);
+
+	/// Get the identity of the data of a node, shared by all aliases of the node.
+	/**
+	 * yaml-cpp does not expose the identity of nodes,
+	 * but the tag is stored in the shared node data, so it has the same address for all aliases.
+	 */
+	inline void const * yamlNodeIdentity(YAML::Node const & node) {
+		return &node.Tag();
+	}
+
+	/// The discriminator key of a variant, skipped while decoding the alternative it selected.
+	struct YamlSkippedKey {
+		/// The key to skip, or empty to skip nothing.
+		std::string_view key;
+
+		/// The value the key must have, or empty to accept any value.
+		std::string_view expected;
+
+		/// Check if a property should be skipped rather than reported as unknown property.
+		bool skips(std::string_view property) const {
+			return !key.empty() && property == key;
+		}
+	};
+
+	/// Check the value of a skipped property, if a specific value is expected.
+	/**
+	 * This catches a discriminator key that selects a different variant alternative than the tag of the node.
+	 * The scalar is empty if the value is not a scalar.
+	 */
+	inline std::optional<YamlError> checkSkippedYamlValue(YamlSkippedKey const & skipped, YAML::NodeType::value type, std::string_view scalar) {
+		if (skipped.expected.empty() || (type == YAML::NodeType::Scalar && scalar == skipped.expected)) return std::nullopt;
+		std::string key{skipped.key};
+		return YamlError{"property `" + key + "' selects variant alternative `" + std::string{scalar} + "', but the tag selects `" + std::string{skipped.expected} + "'"}
+			.appendTrace({key, "", type});
+	}
+
+	/// Check if T can be decoded from a map while skipping the discriminator key of a variant, without copying the map.
+	/**
+	 * Specialized for decomposable types in yaml_decompose.hpp,
+	 * with a static `parse(YAML::Node const &, YamlSkippedKey const &)` function.
+	 * Other types are decoded from a copy of the map without the key.
+	 */
+	template<typename T, typename = void>
+	struct skips_yaml_key : std::false_type {};
+}
+
+namespace detail {
+	/// Decode the text of a scalar node as T.
+	/**
+	 * This is used by the YAML conversions of bool, std::string, std::string_view and the arithmetic types,
+	 * so other node representations can decode scalars the same way.
+	 *
+	 * The text must be followed by a null character, like the scalars of a YAML::Node.
+	 * A decoded std::string_view points into the text.
+	 */
+	template<typename T>
+	YamlResult<T> parseYamlScalar(std::string_view raw);
+
+#define DECLARE_YAML_SCALAR(TYPE) template<> YamlResult<TYPE> parseYamlScalar<TYPE>(std::string_view raw)
+	DECLARE_YAML_SCALAR(bool);
+	DECLARE_YAML_SCALAR(char);
+	DECLARE_YAML_SCALAR(short);
+	DECLARE_YAML_SCALAR(int);
+	DECLARE_YAML_SCALAR(long);
+	DECLARE_YAML_SCALAR(long long);
+	DECLARE_YAML_SCALAR(unsigned char);
+	DECLARE_YAML_SCALAR(unsigned short);
+	DECLARE_YAML_SCALAR(unsigned int);
+	DECLARE_YAML_SCALAR(unsigned long);
+	DECLARE_YAML_SCALAR(unsigned long long);
+	DECLARE_YAML_SCALAR(float);
+	DECLARE_YAML_SCALAR(double);
+	DECLARE_YAML_SCALAR(long double);
+	DECLARE_YAML_SCALAR(std::string);
+	DECLARE_YAML_SCALAR(std::string_view);
+#undef DECLARE_YAML_SCALAR
+}
+
 /// Test if a node is a map, and if not, return a YamlError with a descriptive error message.
 std::optional<YamlError> expectMap(YAML::Node const & node);
 
@@ -103,6 +483,8 @@ std::string toString(YAML::NodeType::value);
 /**
  * This should be preferred over YAML::LoadFile(...),
  * because this function has much better error reporting.
+ *
+ * Files with a `.json` extension are read with the faster JSON reader from json.hpp.
  */
 estd::result<YAML::Node, estd::error> readYamlFile(std::string const & path);
 
@@ -114,6 +496,17 @@ inline YamlResult<void> mergeYamlNodes(YAML::Node && map_a, YAML::Node map_b) {
 	return mergeYamlNodes(map_a, map_b);
 }
 
+/// Check if two YAML node trees are structurally equal.
+/**
+ * Scalars are compared by their text, sequences element by element and maps entry by entry regardless of order.
+ * Tags are compared too, except that the non-specific tags `?` and `!` are considered equal to each other.
+ *
+ * Maps with their entries in the same order are compared in linear time.
+ * Otherwise, the entries are sorted by key, unless a key is not a scalar:
+ * then each key is searched for, which takes quadratic time in the size of the map.
+ */
+bool yamlEqual(YAML::Node const & a, YAML::Node const & b);
+
 /// Set a variable to a subkey of a node if it exists.
 /**
  * This function is deprecated and should not be used.
@@ -202,7 +595,7 @@ struct conversion<YAML::Node, dr::YamlResult<std::array<T, N>>> {
 	static constexpr bool possible = dr::can_parse_yaml<T>;
 
 	static dr::YamlResult<std::array<T, N>> perform(YAML::Node const & node) noexcept {
-		if (auto error = dr::expectSequence(node, N)) return *error;
+		if (auto error = dr::expectSequence(node, N)) return std::move(*error);
 
 		std::array<T, N> result;
 
@@ -210,7 +603,7 @@ struct conversion<YAML::Node, dr::YamlResult<std::array<T, N>>> {
 		for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
 			if (index >= N) return dr::YamlError{"sequence too long, expected " + std::to_string(N) + ", now at index " + std::to_string(index)};
 			dr::YamlResult<T> element = dr::parseYaml<T>(*i);
-			if (!element) return element.error().appendTrace({std::to_string(index), "", i->Type()});
+			if (!element) return std::move(element.error()).appendTrace(index, i->Type());
 			result[index++] = std::move(*element);
 		}
 
@@ -227,32 +620,68 @@ struct conversion<std::array<T, N>, YAML::Node> {
 		for (auto const & value : data) {
 			result.push_back(dr::encodeYaml(value));
 		}
+		// Emit sequences of numbers on a single line.
+		if constexpr (std::is_arithmetic_v<T>) {
+			if (!data.empty()) result.SetStyle(YAML::EmitterStyle::Flow);
+		}
 		return result;
 	}
 };
 
-// conversion for std::vector
-template<typename T>
-struct conversion<YAML::Node, dr::YamlResult<std::vector<T>>> {
-	static constexpr bool possible = dr::can_parse_yaml<T>;
-
-	static dr::YamlResult<std::vector<T>> perform(YAML::Node const & node) {
+namespace detail {
+	// conversion for std::vector<T>
+	template<typename T>
+	dr::YamlResult<std::vector<T>> parseYamlVector(YAML::Node const & node) {
 		if (node.IsNull()) return std::vector<T>{};
-		if (auto error = dr::expectSequence(node)) return *error;
+		if (auto error = dr::expectSequence(node)) return std::move(*error);
+		if (auto error = dr::detail::checkYamlLength(node)) return std::move(*error);
 
 		std::vector<T> result;
 		result.reserve(node.size());
 
-		int index = 0;
+		std::size_t index = 0;
 		for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
 			dr::YamlResult<T> element = dr::parseYaml<T>(*i);
-			if (!element) return element.error().appendTrace({std::to_string(index), "", i->Type()});
+			if (!element) return std::move(element.error()).appendTrace(index, i->Type());
 			result.push_back(std::move(*element));
 			++index;
 		}
 
 		return result;
 	}
+
+	template<typename T>
+	YAML::Node encodeYamlVector(std::vector<T> const & data) {
+		YAML::Node result;
+		for (auto const & value : data) {
+			result.push_back(dr::encodeYaml(value));
+		}
+		// Emit sequences of numbers on a single line.
+		if constexpr (std::is_arithmetic_v<T>) {
+			if (!data.empty()) result.SetStyle(YAML::EmitterStyle::Flow);
+		}
+		return result;
+	}
+
+	// conversion for std::optional<T>
+	template<typename T>
+	dr::YamlResult<std::optional<T>> parseYamlOptional(YAML::Node const & node) {
+		if (node.IsNull()) return std::optional<T>{};
+
+		dr::YamlResult<T> element = dr::parseYaml<T>(node);
+		if (!element) return std::move(element.error());
+		return {estd::in_place_valid, std::optional<T>{std::move(*element)}};
+	}
+}
+
+// conversion for std::vector
+template<typename T>
+struct conversion<YAML::Node, dr::YamlResult<std::vector<T>>> {
+	static constexpr bool possible = dr::can_parse_yaml<T>;
+
+	static dr::YamlResult<std::vector<T>> perform(YAML::Node const & node) {
+		return detail::parseYamlVector<T>(node);
+	}
 };
 
 template<typename T>
@@ -260,11 +689,7 @@ struct conversion<std::vector<T>, YAML::Node> {
 	static constexpr bool possible = dr::can_encode_yaml<T>;
 
 	static YAML::Node perform(std::vector<T> const & data) noexcept {
-		YAML::Node result;
-		for (auto const & value : data) {
-			result.push_back(dr::encodeYaml(value));
-		}
-		return result;
+		return detail::encodeYamlVector<T>(data);
 	}
 };
 
@@ -274,11 +699,7 @@ struct conversion<YAML::Node, dr::YamlResult<std::optional<T>>> {
 	static constexpr bool possible = dr::can_parse_yaml<T>;
 
 	static dr::YamlResult<std::optional<T>> perform(YAML::Node const & node) {
-		if (node.IsNull()) return std::optional<T>{};
-
-		dr::YamlResult<T> element = dr::parseYaml<T>(node);
-		if (!element) return element.error();
-		return {estd::in_place_valid, std::optional<T>{std::move(*element)}};
+		return detail::parseYamlOptional<T>(node);
 	}
 };
 
@@ -293,73 +714,263 @@ struct conversion<std::optional<T>, YAML::Node> {
 	}
 };
 
+// conversion for std::shared_ptr<T const>
+template<typename T>
+struct conversion<YAML::Node, dr::YamlResult<std::shared_ptr<T const>>> {
+	static constexpr bool possible = dr::can_parse_yaml<T>;
+
+	static dr::YamlResult<std::shared_ptr<T const>> perform(YAML::Node const & node) {
+		if (node.IsNull()) return std::shared_ptr<T const>{};
+
+		// Share the value with other aliases of the same node, if decoding is memoized.
+		dr::detail::YamlAliasMemo * memo = dr::detail::current_yaml_alias_memo;
+		return dr::detail::parseYamlShared<T>(node, memo, memo ? memo->aliasedIdentity(node) : nullptr);
+	}
+};
+
+template<typename T>
+struct conversion<std::shared_ptr<T const>, YAML::Node> {
+	static constexpr bool possible = dr::can_encode_yaml<T>;
+
+	static YAML::Node perform(std::shared_ptr<T const> const & data) noexcept {
+		if (!data) return YAML::Node();
+		return dr::encodeYaml(*data);
+	}
+};
+
+// conversion for std::variant<Ts...>
+template<typename... Ts>
+struct conversion<YAML::Node, dr::YamlResult<std::variant<Ts...>>> {
+	using Variant = std::variant<Ts...>;
+
+	static constexpr bool possible = ((dr::can_parse_yaml<Ts> && dr::has_yaml_variant_name<Ts>) && ...);
+
+	static dr::YamlResult<Variant> perform(YAML::Node const & node) {
+		return perform(node, std::index_sequence_for<Ts...>{});
+	}
+
+private:
+	static constexpr std::string_view discriminator = dr::yaml_variant_discriminator<Variant>::value;
+
+	/// Parse an alternative, without the discriminator key.
+	/**
+	 * If the alternative was selected by tag, the map only loses the discriminator key for decomposable types,
+	 * and only if they have no member with the same name.
+	 * The key must then name the same alternative as the tag.
+	 * Other types may hold the key as regular entry, which happens if they are encoded with a tag.
+	 */
+	template<std::size_t I>
+	static dr::YamlResult<Variant> parseAlternative(YAML::Node const & node, bool tagged) {
+		using T = std::variant_alternative_t<I, Variant>;
+		dr::YamlResult<T> result = [&] () -> dr::YamlResult<T> {
+			if constexpr (dr::detail::skips_yaml_key<T>::value) {
+				// Decomposable types skip the key themselves, so the map does not need to be copied.
+				// The key is passed explicitly rather than through parseYaml(),
+				// so the result is not memoized for aliased nodes that are also decoded outside of the variant.
+				// If the tag selected the alternative, the skipped key must select the same alternative.
+				if (discriminator.empty()) return dr::parseYaml<T>(node);
+				if (dr::detail::YamlDecodeBudget * budget = dr::detail::current_yaml_decode_budget) {
+					if (std::optional<dr::YamlError> error = budget->addNode()) return std::move(*error);
+				}
+				return dr::detail::skips_yaml_key<T>::parse(node, {discriminator, tagged ? dr::yaml_variant_name<T>::value : std::string_view{}});
+			} else {
+				if (tagged || discriminator.empty()) return dr::parseYaml<T>(node);
+				return dr::parseYaml<T>(dr::detail::removeYamlKey(node, discriminator));
+			}
+		}();
+		if (!result) return std::move(result.error());
+		return {estd::in_place_valid, std::in_place_index<I>, std::move(*result)};
+	}
+
+	template<std::size_t... I>
+	static dr::YamlResult<Variant> perform(YAML::Node const & node, std::index_sequence<I...>) {
+		using Parser = dr::YamlResult<Variant> (*)(YAML::Node const &, bool tagged);
+		static constexpr dr::param::StringTable<sizeof...(Ts)> names{{dr::yaml_variant_name<Ts>::value...}};
+		static constexpr std::array<Parser, sizeof...(Ts)> parsers{{&parseAlternative<I>...}};
+
+		// An explicit tag always selects the alternative.
+		if (std::optional<std::string_view> name = dr::detail::yamlTagName(node)) {
+			std::optional<std::size_t> index = names.find(*name);
+			if (!index) return dr::YamlError{"unknown variant alternative `" + std::string{*name} + "'"};
+			return parsers[*index](node, true);
+		}
+
+		if (discriminator.empty()) return dr::YamlError{"missing YAML tag to select variant alternative"};
+		if (auto error = dr::expectMap(node)) return std::move(*error);
+
+		std::string key{discriminator};
+		YAML::Node name_node = node[key];
+		if (!name_node) return dr::YamlError{"missing YAML tag or property `" + key + "' to select variant alternative"};
+		if (auto error = dr::expectScalar(name_node)) return std::move(*error).appendTrace({key, "", name_node.Type()});
+
+		std::optional<std::size_t> index = names.find(name_node.Scalar());
+		if (!index) return dr::YamlError{"unknown variant alternative `" + name_node.Scalar() + "'"}.appendTrace({key, "", name_node.Type()});
+		return parsers[*index](node, false);
+	}
+};
+
+template<typename... Ts>
+struct conversion<std::variant<Ts...>, YAML::Node> {
+	using Variant = std::variant<Ts...>;
+
+	static constexpr bool possible = ((dr::can_encode_yaml<Ts> && dr::has_yaml_variant_name<Ts>) && ...);
+
+	static YAML::Node perform(Variant const & variant) {
+		return std::visit([] (auto const & value) {
+			using T = std::decay_t<decltype(value)>;
+			constexpr std::string_view name = dr::yaml_variant_name<T>::value;
+			constexpr std::string_view discriminator = dr::yaml_variant_discriminator<Variant>::value;
+
+			YAML::Node result = dr::encodeYaml(value);
+			// Use a tag if the alternative has its own property with the name of the discriminator key.
+			YAML::Node const & view = result;
+			if (!discriminator.empty() && result.IsMap() && !view[std::string{discriminator}]) {
+				result[std::string{discriminator}] = std::string{name};
+			} else {
+				result.SetTag("!" + std::string{name});
+			}
+			return result;
+		}, variant);
+	}
+};
+
 namespace detail {
-	// conversion for std::map<Key, Value>
-	template<typename Key, typename Value>
-	dr::YamlResult<std::map<Key, Value>> parseYamlMap(YAML::Node const & node) {
-		if (auto error = dr::expectMap(node)) return *error;
+	/// Check if a type can be used as key of a map decoded from YAML.
+	template<typename Key>
+	constexpr bool is_yaml_map_key = std::is_same_v<Key, std::string> || std::is_same_v<Key, std::string_view> || std::is_integral_v<Key> || std::is_enum_v<Key>;
 
-		std::map<Key, Value> result;
+	/// Create the error for a key that occurs more than once in a map.
+	inline dr::YamlError duplicateYamlKey(YAML::Node const & key) {
+		return dr::YamlError{"duplicate key"}.appendTrace({key.Scalar(), "", key.Type()});
+	}
 
-		for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
-			std::string const & name = i->first.Scalar();
+	// conversion for std::map<Key, Value> and std::unordered_map<Key, Value>
+	template<typename Key, typename Value, typename Map = std::map<Key, Value>>
+	dr::YamlResult<Map> parseYamlMap(YAML::Node const & node) {
+		if (auto error = dr::expectMap(node)) return std::move(*error);
+		if (auto error = dr::detail::checkYamlLength(node)) return std::move(*error);
+
+		Map result;
+		if constexpr (dr::param::detail::is_std_unordered_map<Map>::value) result.reserve(node.size());
 
+		for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
 			dr::YamlResult<Key> key = dr::parseYaml<Key>(i->first);
-			if (!key) return key.error().appendTrace({name, "", i->first.Type()});
+			if (!key) return std::move(key.error()).appendTrace({i->first.Scalar(), "", i->first.Type()});
 
 			dr::YamlResult<Value> value = dr::parseYaml<Value>(i->second);
-			if (!value) return value.error().appendTrace({name, "", i->second.Type()});
+			if (!value) return std::move(value.error()).appendTrace({i->first.Scalar(), "", i->second.Type()});
 
-			result.emplace(std::move(*key), std::move(*value));
+			if (!result.emplace(std::move(*key), std::move(*value)).second) return duplicateYamlKey(i->first);
 		}
 
 		return result;
 	}
-}
 
-// conversion for std::map<std::string, T>
-template<typename T>
-struct conversion<YAML::Node, dr::YamlResult<std::map<std::string, T>>> {
-	static constexpr bool possible = dr::can_parse_yaml<T>;
+	// conversion for dr::FlatMap<Key, Value, Compare>
+	template<typename Key, typename Value, typename Compare>
+	dr::YamlResult<dr::FlatMap<Key, Value, Compare>> parseYamlFlatMap(YAML::Node const & node) {
+		if (auto error = dr::expectMap(node)) return std::move(*error);
+		if (auto error = dr::detail::checkYamlLength(node)) return std::move(*error);
 
-	static dr::YamlResult<std::map<std::string, T>> perform(YAML::Node const & node) {
-		return detail::parseYamlMap<std::string, T>(node);
-	}
-};
+		std::vector<std::pair<Key, Value>> entries;
+		entries.reserve(node.size());
 
-template<typename T>
-struct conversion<std::map<std::string, T>, YAML::Node> {
-	static constexpr bool possible = dr::can_encode_yaml<T>;
+		for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
+			dr::YamlResult<Key> key = dr::parseYaml<Key>(i->first);
+			if (!key) return std::move(key.error()).appendTrace({i->first.Scalar(), "", i->first.Type()});
+
+			dr::YamlResult<Value> value = dr::parseYaml<Value>(i->second);
+			if (!value) return std::move(value.error()).appendTrace({i->first.Scalar(), "", i->second.Type()});
+
+			entries.emplace_back(std::move(*key), std::move(*value));
+		}
 
-	static YAML::Node perform(std::map<std::string, T> const & map) {
+		// Sort all entries at once, so duplicate keys end up next to each other.
+		Compare compare;
+		auto duplicate = dr::detail::sortFlatMapEntries(entries, compare);
+		if (duplicate != entries.end()) {
+			// Only on error, look up the second occurrence of the key in the document for the trace.
+			bool seen = false;
+			for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
+				// Decoding again can still fail, for example when the limits of a YamlLimitsScope are exceeded.
+				dr::YamlResult<Key> key = dr::parseYaml<Key>(i->first);
+				if (!key) return std::move(key.error()).appendTrace({i->first.Scalar(), "", i->first.Type()});
+				if (compare(*key, duplicate->first) || compare(duplicate->first, *key)) continue;
+				if (seen) return duplicateYamlKey(i->first);
+				seen = true;
+			}
+		}
+
+		return dr::FlatMap<Key, Value, Compare>::fromSorted(std::move(entries), std::move(compare));
+	}
+
+	/// Encode a map with unique keys.
+	template<typename Map>
+	YAML::Node encodeYamlMap(Map const & map) {
 		YAML::Node result;
+		// The keys are already unique, so skip the linear search for an existing key.
 		for (auto & [key, value] : map) {
-			result[key] = dr::encodeYaml(value);
+			result.force_insert(dr::encodeYaml(key), dr::encodeYaml(value));
 		}
 		return result;
 	}
+}
+
+// conversion for std::map<Key, T> with string, integral or enum keys
+// The keys of a std::map<std::string_view, T> point into the scalars of the node tree, see YamlDocument for keeping them alive.
+template<typename Key, typename T>
+struct conversion<YAML::Node, dr::YamlResult<std::map<Key, T>>> {
+	static constexpr bool possible = detail::is_yaml_map_key<Key> && dr::can_parse_yaml<Key> && dr::can_parse_yaml<T>;
+
+	static dr::YamlResult<std::map<Key, T>> perform(YAML::Node const & node) {
+		return detail::parseYamlMap<Key, T>(node);
+	}
 };
 
-// conversion for std::map<int, T>
-template<typename T>
-struct conversion<YAML::Node, dr::YamlResult<std::map<int, T>>> {
-	static constexpr bool possible = dr::can_parse_yaml<T>;
+template<typename Key, typename T>
+struct conversion<std::map<Key, T>, YAML::Node> {
+	static constexpr bool possible = detail::is_yaml_map_key<Key> && dr::can_encode_yaml<Key> && dr::can_encode_yaml<T>;
 
-	static dr::YamlResult<std::map<int, T>> perform(YAML::Node const & node) {
-		return detail::parseYamlMap<int, T>(node);
+	static YAML::Node perform(std::map<Key, T> const & map) {
+		return detail::encodeYamlMap(map);
 	}
 };
 
-template<typename T>
-struct conversion<std::map<int, T>, YAML::Node> {
-	static constexpr bool possible = dr::can_encode_yaml<T>;
+// conversion for std::unordered_map<Key, T> with string, integral or enum keys
+template<typename Key, typename T>
+struct conversion<YAML::Node, dr::YamlResult<std::unordered_map<Key, T>>> {
+	static constexpr bool possible = detail::is_yaml_map_key<Key> && dr::can_parse_yaml<Key> && dr::can_parse_yaml<T>;
 
-	static YAML::Node perform(std::map<int, T> const & map) {
-		YAML::Node result;
-		for (auto & [key, value] : map) {
-			result[std::to_string(key)] = dr::encodeYaml(value);
-		}
-		return result;
+	static dr::YamlResult<std::unordered_map<Key, T>> perform(YAML::Node const & node) {
+		return detail::parseYamlMap<Key, T, std::unordered_map<Key, T>>(node);
+	}
+};
+
+template<typename Key, typename T>
+struct conversion<std::unordered_map<Key, T>, YAML::Node> {
+	static constexpr bool possible = detail::is_yaml_map_key<Key> && dr::can_encode_yaml<Key> && dr::can_encode_yaml<T>;
+
+	static YAML::Node perform(std::unordered_map<Key, T> const & map) {
+		return detail::encodeYamlMap(map);
+	}
+};
+
+// conversion for dr::FlatMap<Key, T, Compare> with string, integral or enum keys
+template<typename Key, typename T, typename Compare>
+struct conversion<YAML::Node, dr::YamlResult<dr::FlatMap<Key, T, Compare>>> {
+	static constexpr bool possible = detail::is_yaml_map_key<Key> && dr::can_parse_yaml<Key> && dr::can_parse_yaml<T>;
+
+	static dr::YamlResult<dr::FlatMap<Key, T, Compare>> perform(YAML::Node const & node) {
+		return detail::parseYamlFlatMap<Key, T, Compare>(node);
+	}
+};
+
+template<typename Key, typename T, typename Compare>
+struct conversion<dr::FlatMap<Key, T, Compare>, YAML::Node> {
+	static constexpr bool possible = detail::is_yaml_map_key<Key> && dr::can_encode_yaml<Key> && dr::can_encode_yaml<T>;
+
+	static YAML::Node perform(dr::FlatMap<Key, T, Compare> const & map) {
+		return detail::encodeYamlMap(map);
 	}
 };
 
@@ -0,0 +1,331 @@
+#pragma once
+#include "decompose.hpp"
+#include "type_traits.hpp"
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "yaml_path.hpp"
+
+#include <estd/tuple/for_each.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <vector>
+
+/**
+ * This header implements access to single members of an object by path.
+ *
+ * A path is compiled once into a chain of type-erased steps, following the decomposition of the types along the path.
+ * The compiled accessor can then read or write the member at the end of the path without touching any other member,
+ * for example to let a user interface tune a single parameter of a live object.
+ */
+
+namespace dr {
+
+/// A single step of a compiled path.
+struct YamlAccessorStep {
+	/// Select the child of an object, or return null if the child does not exist.
+	/**
+	 * If `create` is true, an empty std::optional is value initialized instead.
+	 */
+	void * (*select)(YamlAccessorStep const & step, void * object, bool create);
+
+	/// The member info from the decomposition, for member steps.
+	void const * info;
+
+	/// The index of the element, for sequence steps, or the key of the entry, for maps with integral or enum keys.
+	std::size_t index;
+
+	/// The key of the entry, for map steps.
+	std::string key;
+
+	/// Reset an std::optional that was value initialized by `select`, for optional steps.
+	void (*reset)(void * object);
+};
+
+/// The type-erased part of a compiled path, independent of the type of the root object.
+class YamlAccessorChain {
+protected:
+	/// The path the accessor was compiled from.
+	std::string path_;
+
+	/// The steps from the root object to the member at the end of the path.
+	std::vector<YamlAccessorStep> steps_;
+
+	/// The decompositions that the member steps refer to, for types that do not cache their decomposition.
+	std::vector<std::shared_ptr<void const>> decompositions_;
+
+	/// The type of the member at the end of the path.
+	std::type_index type_ = typeid(void);
+
+	/// Encode the member at the end of the path.
+	YAML::Node (*encode_)(void const * object) = nullptr;
+
+	/// Decode a node and assign it to the member at the end of the path in a root object.
+	std::optional<YamlError> (*decode_)(YamlAccessorChain const & chain, void * root, YAML::Node const & node) = nullptr;
+
+	/// Follow the steps from the root object, or return null if an element along the path does not exist.
+	/**
+	 * If `create` is true, empty std::optional values along the path are value initialized.
+	 * If an element further along the path does not exist, they are reset again before returning null.
+	 */
+	void * resolve(void * root, bool create) const;
+
+	/// Encode the member at the end of the path.
+	YamlResult<YAML::Node> getYaml(void const * root) const;
+
+	/// Decode a node and assign it to the member at the end of the path.
+	std::optional<YamlError> setYaml(void * root, YAML::Node const & node) const;
+
+	/// Create the error for an element along the path that does not exist in an object.
+	YamlError missingError() const;
+
+public:
+	/// Get the path the accessor was compiled from.
+	std::string const & path() const { return path_; }
+
+	/// Get the type of the member at the end of the path.
+	std::type_index type() const { return type_; }
+
+	template<typename T> friend std::optional<YamlError> compileYamlAccessorSteps(YamlAccessorChain & chain, std::string_view const * steps, std::size_t count);
+};
+
+namespace detail {
+	/// Create the error for a path that can not be compiled.
+	YamlError invalidYamlAccessorPath(std::string_view path, std::string_view reason);
+
+	template<typename T, typename Info>
+	void * selectYamlAccessorMember(YamlAccessorStep const & step, void * object, bool) {
+		Info const & member_info = *static_cast<Info const *>(step.info);
+		return &member_info.access(*static_cast<T *>(object));
+	}
+
+	template<typename T>
+	void * selectYamlAccessorElement(YamlAccessorStep const & step, void * object, bool) {
+		T & sequence = *static_cast<T *>(object);
+		if (step.index >= sequence.size()) return nullptr;
+		return &sequence[step.index];
+	}
+
+	template<typename T>
+	void * selectYamlAccessorEntry(YamlAccessorStep const & step, void * object, bool) {
+		T & map = *static_cast<T *>(object);
+		auto found = map.find(step.key);
+		if (found == map.end()) return nullptr;
+		return &found->second;
+	}
+
+	template<typename T>
+	void * selectYamlAccessorIntegralEntry(YamlAccessorStep const & step, void * object, bool) {
+		T & map = *static_cast<T *>(object);
+		auto found = map.find(static_cast<typename T::key_type>(step.index));
+		if (found == map.end()) return nullptr;
+		return &found->second;
+	}
+
+	template<typename T>
+	void * selectYamlAccessorOptional(YamlAccessorStep const &, void * object, bool create) {
+		T & optional = *static_cast<T *>(object);
+		if constexpr (std::is_default_constructible_v<typename T::value_type>) {
+			if (!optional && create) optional.emplace();
+		}
+		if (!optional) return nullptr;
+		return &*optional;
+	}
+
+	template<typename T>
+	void resetYamlAccessorOptional(void * object) {
+		static_cast<T *>(object)->reset();
+	}
+}
+
+/// Compile the remaining steps of a path, starting at a value of type T.
+template<typename T>
+std::optional<YamlError> compileYamlAccessorSteps(YamlAccessorChain & chain, std::string_view const * steps, std::size_t count) {
+	// The end of the path, remember how to read and write the value.
+	if (count == 0) {
+		chain.type_ = typeid(T);
+		if constexpr (can_encode_yaml<T>) {
+			chain.encode_ = [] (void const * object) {
+				return encodeYaml(*static_cast<T const *>(object));
+			};
+		}
+		if constexpr (can_parse_yaml<T> && std::is_move_assignable_v<T>) {
+			chain.decode_ = [] (YamlAccessorChain const & chain, void * root, YAML::Node const & node) -> std::optional<YamlError> {
+				// Decode before resolving the path, so a failed decode does not create empty optionals along the path.
+				YamlResult<T> result = parseYaml<T>(node);
+				if (!result) return std::move(result.error());
+				void * object = chain.resolve(root, true);
+				if (!object) return chain.missingError();
+				*static_cast<T *>(object) = std::move(*result);
+				return std::nullopt;
+			};
+		}
+		return std::nullopt;
+	}
+
+	std::string_view step = steps[0];
+
+	if constexpr (param::detail::is_std_optional<T>::value) {
+		// Optional values are transparent in paths.
+		chain.steps_.push_back({&detail::selectYamlAccessorOptional<T>, nullptr, 0, {}, &detail::resetYamlAccessorOptional<T>});
+		return compileYamlAccessorSteps<typename T::value_type>(chain, steps, count);
+	} else if constexpr (param::can_decompose<T> && !param::constructs_from_decomposition<T>) {
+		std::optional<YamlError> error;
+		auto const & members = [&] () -> auto const & {
+			if constexpr (param::caches_decomposition<T>) {
+				return param::cachedDecompose<T>();
+			} else {
+				auto decomposition = std::make_shared<decltype(param::decompose<T>()) const>(param::decompose<T>());
+				chain.decompositions_.push_back(decomposition);
+				return *decomposition;
+			}
+		}();
+		std::size_t found_at = estd::for_each(members, [&] (auto const & member) {
+			if (step != member.name) return true;
+			using Info = std::decay_t<decltype(member)>;
+			using member_type = std::decay_t<decltype(member.access(std::declval<T &>()))>;
+			chain.steps_.push_back({&detail::selectYamlAccessorMember<T, Info>, &member, 0, {}, nullptr});
+			error = compileYamlAccessorSteps<member_type>(chain, steps + 1, count - 1);
+			return false;
+		});
+		if (found_at == estd::size(members)) return detail::invalidYamlAccessorPath(chain.path_, "unknown property `" + std::string{step} + "'");
+		return error;
+	} else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+		// The elements of std::vector<bool> do not have an address.
+		return detail::invalidYamlAccessorPath(chain.path_, "can not select `" + std::string{step} + "' in a std::vector<bool>");
+	} else if constexpr (param::detail::is_std_vector<T>::value || param::detail::is_std_array<T>::value) {
+		std::size_t index = 0;
+		auto [end, parse_error] = std::from_chars(step.data(), step.data() + step.size(), index);
+		if (parse_error != std::errc{} || end != step.data() + step.size()) {
+			return detail::invalidYamlAccessorPath(chain.path_, "invalid sequence index `" + std::string{step} + "'");
+		}
+		chain.steps_.push_back({&detail::selectYamlAccessorElement<T>, nullptr, index, {}, nullptr});
+		return compileYamlAccessorSteps<typename T::value_type>(chain, steps + 1, count - 1);
+	} else if constexpr (param::detail::is_std_map<T>::value || param::detail::is_std_unordered_map<T>::value || param::detail::is_flat_map<T>::value) {
+		using Key = typename T::key_type;
+		if constexpr (std::is_same_v<Key, std::string> || std::is_same_v<Key, std::string_view>) {
+			chain.steps_.push_back({&detail::selectYamlAccessorEntry<T>, nullptr, 0, std::string{step}, nullptr});
+		} else if constexpr ((std::is_integral_v<Key> || std::is_enum_v<Key>) && can_parse_yaml<Key>) {
+			// Integral and enum keys are decoded once and stored in the index of the step.
+			YamlResult<Key> key = parseYaml<Key>(YAML::Node{std::string{step}});
+			if (!key) return detail::invalidYamlAccessorPath(chain.path_, "invalid key `" + std::string{step} + "': " + key.error().message());
+			chain.steps_.push_back({&detail::selectYamlAccessorIntegralEntry<T>, nullptr, static_cast<std::size_t>(*key), {}, nullptr});
+		} else {
+			return detail::invalidYamlAccessorPath(chain.path_, "can not select `" + std::string{step} + "' in a map with this key type");
+		}
+		return compileYamlAccessorSteps<typename T::mapped_type>(chain, steps + 1, count - 1);
+	} else {
+		return detail::invalidYamlAccessorPath(chain.path_, "can not select `" + std::string{step} + "' in a value without members");
+	}
+}
+
+/// Compiled path to a member of an object of type T.
+/**
+ * The path uses the same syntax as YamlError::formatTrace(), for example `controller.gains[2].kp`.
+ * Compiling the path looks up each step in the decomposition of the types along the path once.
+ * Accessing the member then only follows the compiled steps, without any lookup by name.
+ *
+ * Paths can step through decomposable types, std::optional, std::vector, std::array,
+ * and std::map, std::unordered_map and FlatMap with string, integral or enum keys.
+ * Steps into sequences and maps are checked when the accessor is used,
+ * since the elements and entries of an object can change after the path is compiled.
+ *
+ * An empty std::optional along the path is treated as a missing element when reading the member.
+ * When writing the member, it is value initialized first, like parseYamlPaths() does,
+ * unless decoding fails or an element further along the path does not exist.
+ * Missing elements of sequences and maps are never created.
+ */
+template<typename T>
+class YamlAccessor : public YamlAccessorChain {
+	YamlAccessor() = default;
+
+public:
+	/// Compile a path.
+	static YamlResult<YamlAccessor> compile(std::string_view path) {
+		YamlResult<std::vector<std::string_view>> steps = splitYamlPath(path);
+		if (!steps) return std::move(steps.error());
+
+		YamlAccessor accessor;
+		accessor.path_ = path;
+		if (auto error = compileYamlAccessorSteps<T>(accessor, steps->data(), steps->size())) return std::move(*error);
+		return accessor;
+	}
+
+	/// Get a pointer to the member at the end of the path.
+	/**
+	 * Returns null if the member is not of type V, or if an element along the path does not exist in the object.
+	 */
+	template<typename V>
+	V * get(T & object) const {
+		if (type_ != typeid(V)) return nullptr;
+		return static_cast<V *>(resolve(&object, false));
+	}
+
+	/// Get a pointer to the member at the end of the path.
+	template<typename V>
+	V const * get(T const & object) const {
+		return get<V>(const_cast<T &>(object));
+	}
+
+	/// Encode the member at the end of the path as YAML node.
+	YamlResult<YAML::Node> getYaml(T const & object) const {
+		return YamlAccessorChain::getYaml(&object);
+	}
+
+	/// Decode a YAML node and assign it to the member at the end of the path.
+	/**
+	 * Empty std::optional values along the path are value initialized first.
+	 * If decoding fails or an element along the path does not exist, the object is left untouched.
+	 */
+	std::optional<YamlError> setYaml(T & object, YAML::Node const & node) const {
+		return YamlAccessorChain::setYaml(&object, node);
+	}
+};
+
+/// Registry of compiled paths for objects of type T.
+/**
+ * Each path is compiled on first use, and the compiled accessor is reused for all later uses of the same path.
+ * The registry is not thread-safe.
+ */
+template<typename T>
+class YamlAccessorRegistry {
+	/// The compiled accessors, by path.
+	std::map<std::string, YamlAccessor<T>, std::less<>> accessors_;
+
+public:
+	/// Get the compiled accessor for a path, compiling it if needed.
+	/**
+	 * The returned accessor remains valid for as long as the registry exists.
+	 */
+	YamlResult<YamlAccessor<T> const *> find(std::string_view path) {
+		auto found = accessors_.find(path);
+		if (found != accessors_.end()) return &found->second;
+
+		YamlResult<YamlAccessor<T>> accessor = YamlAccessor<T>::compile(path);
+		if (!accessor) return std::move(accessor.error());
+		return &accessors_.emplace(std::string{path}, std::move(*accessor)).first->second;
+	}
+
+	/// Encode the member at a path as YAML node.
+	YamlResult<YAML::Node> getYaml(T const & object, std::string_view path) {
+		YamlResult<YamlAccessor<T> const *> accessor = find(path);
+		if (!accessor) return std::move(accessor.error());
+		return (*accessor)->getYaml(object);
+	}
+
+	/// Decode a YAML node and assign it to the member at a path.
+	std::optional<YamlError> setYaml(T & object, std::string_view path, YAML::Node const & node) {
+		YamlResult<YamlAccessor<T> const *> accessor = find(path);
+		if (!accessor) return std::move(accessor.error());
+		return (*accessor)->setYaml(object, node);
+	}
+};
+
+}
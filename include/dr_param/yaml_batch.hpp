@@ -0,0 +1,68 @@
+#pragma once
+#include "parallel.hpp"
+#include "yaml.hpp"
+#include "yaml_preprocess.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * This header defines utilities to load many YAML files at once.
+ */
+
+namespace dr {
+
+/// Preprocess and parse a number of YAML files in parallel.
+/**
+ * Each file is preprocessed with preprocessYamlFile() and then parsed with parseYaml<T>().
+ * The files are processed on a work-stealing thread pool with `threads` workers,
+ * or one worker per hardware thread if `threads` is 0.
+ *
+ * All files share a single YamlIncludeCache,
+ * so files included by multiple files are read and parsed only once.
+ *
+ * The `limits` apply to each file separately, both while preprocessing it and while parsing it.
+ * They are installed on the worker thread for each file, since a YamlLimitsScope only applies to the thread that created it.
+ *
+ * The returned vector holds the result for each path, in the same order as `paths`,
+ * regardless of the order in which the files were processed.
+ */
+template<typename T>
+std::vector<YamlResult<T>> loadYamlFiles(
+	std::vector<std::string> const & paths,
+	std::map<std::string, std::string> const & variables,
+	std::size_t threads = 0,
+	YamlLimits const & limits = {}
+) {
+	static_assert(can_parse_yaml<T>, "No YAML conversion defined for T");
+
+	YamlIncludeCache cache;
+	YamlPreprocessOptions options;
+	options.cache  = &cache;
+	options.limits = limits;
+	std::vector<std::optional<YamlResult<T>>> results(paths.size());
+
+	param::parallelFor(paths.size(), [&] (std::size_t index) {
+		try {
+			estd::result<YAML::Node, estd::error> node = preprocessYamlFile(paths[index], variables, options);
+			if (!node) {
+				results[index].emplace(YamlError{node.error().format()});
+			} else {
+				results[index].emplace(parseYaml<T>(*node, limits));
+			}
+		} catch (std::exception const & e) {
+			results[index].emplace(YamlError{paths[index] + ": " + e.what()});
+		}
+	}, threads);
+
+	std::vector<YamlResult<T>> output;
+	output.reserve(results.size());
+	for (std::optional<YamlResult<T>> & result : results) output.push_back(std::move(*result));
+	return output;
+}
+
+}
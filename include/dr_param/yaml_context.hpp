@@ -0,0 +1,83 @@
+#pragma once
+#include "yaml.hpp"
+
+#include <istream>
+#include <streambuf>
+#include <string_view>
+
+/**
+ * This header defines a reusable context for decoding many small YAML documents at a high rate.
+ */
+
+namespace dr {
+
+namespace detail {
+	/// Stream buffer that reads from a borrowed buffer without copying it.
+	class YamlBufferStream : public std::streambuf {
+	public:
+		/// Start reading from a new buffer.
+		void reset(std::string_view data);
+	};
+}
+
+/// Reusable state for parsing YAML documents from memory.
+/**
+ * Decoding a document from a string normally copies the string into a stream,
+ * and sets up a new stream for every document.
+ * A context reads the documents directly from the caller's buffer through a stream that is reused for every document.
+ *
+ * Together with the cached decompositions used by parseYaml<T>(),
+ * decoding the loaded node tree of a well-formed document adds no allocations besides the decoded object itself.
+ * Loading still allocates the node tree, and yaml-cpp creates new parser state for every document.
+ * Error messages and error traces are only built when decoding fails.
+ *
+ * A context is not thread-safe. Use threadLocal() to get a separate context for each thread.
+ */
+class YamlParseContext {
+	/// The stream buffer for the current document.
+	detail::YamlBufferStream buffer_;
+
+	/// The stream that reads from the stream buffer.
+	std::istream stream_;
+
+public:
+	/// Create a new parse context.
+	YamlParseContext();
+
+	YamlParseContext(YamlParseContext const &) = delete;
+	YamlParseContext & operator=(YamlParseContext const &) = delete;
+
+	/// Get the parse context of the calling thread.
+	static YamlParseContext & threadLocal();
+
+	/// Load a YAML document from a buffer.
+	/**
+	 * The buffer only needs to stay valid for the duration of the call.
+	 * Syntax errors are reported as YamlError with the line and column of the error.
+	 */
+	YamlResult<YAML::Node> load(std::string_view data);
+
+	/// Load a YAML document from a buffer and decode it as T.
+	template<typename T>
+	YamlResult<T> parse(std::string_view data) {
+		static_assert(can_parse_yaml<T>, "No YAML conversion defined for T");
+		YamlResult<YAML::Node> node = load(data);
+		if (!node) return std::move(node.error());
+		return parseYaml<T>(*node);
+	}
+};
+
+/// Load a YAML document from a buffer and decode it as T.
+/**
+ * The document is read directly from the buffer with the parse context of the calling thread,
+ * so the buffer does not need to be copied into a std::string first.
+ *
+ * Syntax errors are reported as YamlError with the line and column of the error,
+ * and decoding errors have the same trace as when calling parseYaml<T>() on the loaded node.
+ */
+template<typename T>
+YamlResult<T> parseYamlBuffer(std::string_view data) {
+	return YamlParseContext::threadLocal().parse<T>(data);
+}
+
+}
@@ -8,8 +8,12 @@
 #include <estd/tuple/transform.hpp>
 
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <optional>
 
@@ -17,20 +21,22 @@
  * This header implements YAML conversions for decomposable types (see decompose.hpp).
  *
  * It implements a YAML conversion that simply converts each member in turn.
+ * Enums with an enum decomposition are converted to and from the names of their values.
  */
 
 namespace dr {
 
 /// Marker to indicate if the default conversion from YAML::Node to YamlResult<T> should work by decomposition.
 /**
- * Defaults to true if T can be decomposed with dr::param::decompose<T>().
+ * Defaults to true if T can be decomposed with dr::param::decompose<T>(),
+ * or if T is an enum with a dr::param::EnumDecomposition.
  * Otherwise, defaults to false.
  *
  * This is mainly intended to explicitly disable YAML conversion through dr::param::decompose() without
  * providing a more specialized conversion.
  */
 template<typename T>
-struct enable_yaml_conversion_with_decompose : std::integral_constant<bool, param::can_decompose<T>> {};
+struct enable_yaml_conversion_with_decompose : std::integral_constant<bool, param::can_decompose<T> || param::can_decompose_enum<T>> {};
 
 /// Convert a decomposable type to YAML::Node.
 /**
@@ -41,8 +47,8 @@ YAML::Node encodeDecomposableAsYaml(T const & object) {
 	static_assert(param::can_decompose<T>, "no decomposition available for type T");
 	YAML::Node result;
 
-	// Make tuple with member information.
-	auto members = param::decompose<T>();
+	// Get tuple with member information.
+	auto const & members = param::cachedDecompose<T>();
 
 	estd::for_each(members, [&] (auto const & member) {
 		using member_type = std::decay_t<decltype(member.access(object))>;
@@ -53,33 +59,69 @@ YAML::Node encodeDecomposableAsYaml(T const & object) {
 	return result;
 }
 
+namespace detail {
+	/// Decode the properties of a YAML map into the members of an object.
+	/**
+	 * Node is a YAML::Node or a YamlDomNode.
+	 *
+	 * For each property, `decode_member(key, value, error)` must decode the member with that name and set `error` if that fails.
+	 * It must return false if there is no member with that name.
+	 * Such properties are reported as unknown property,
+	 * except for the `skipped` discriminator key of a variant that selected the object.
+	 *
+	 * Checking for missing members is left to the caller.
+	 */
+	template<typename Node, typename DecodeMember>
+	std::optional<YamlError> parseYamlMembers(Node const & node, YamlSkippedKey const & skipped, DecodeMember && decode_member) {
+		if (auto error = expectMap(node)) return error;
+
+		auto decode_property = [&] (std::string_view key, Node const & value, YAML::NodeType::value type, std::string_view scalar) -> std::optional<YamlError> {
+			// Storage for possible errors that may occur when parsing a child node.
+			std::optional<YamlError> error = std::nullopt;
+			if (decode_member(key, value, error)) return error;
+
+			// The discriminator key of a variant that selected this type is not a member.
+			if (skipped.skips(key)) return checkSkippedYamlValue(skipped, type, scalar);
+			return YamlError{"unknown property `" + std::string{key} + "'"};
+		};
+
+		if constexpr (std::is_same_v<Node, YAML::Node>) {
+			for (auto child : node) {
+				YAML::Node const & value = child.second;
+				std::string_view scalar = value.IsScalar() ? std::string_view{value.Scalar()} : std::string_view{};
+				if (auto error = decode_property(child.first.Scalar(), value, value.Type(), scalar)) return error;
+			}
+		} else {
+			for (auto child : node.entries()) {
+				if (auto error = decode_property(child.key.scalar(), child.value, child.value.type(), child.value.scalar())) return error;
+			}
+		}
+
+		return std::nullopt;
+	}
+}
+
 /// Convert a YAML::Node to a decomposable type.
 /**
  * The YAML node must be a map with each required member in the decomposition of T.
- * The YAML node may not contain any children not listed in the decomposition of T.
+ * The YAML node may not contain any children not listed in the decomposition of T,
+ * except for the `skipped` discriminator key of a variant that selected T.
  */
 template<typename T>
-std::optional<YamlError> parseDecomposableFromYaml(YAML::Node const & node, T & object) {
+std::optional<YamlError> parseDecomposableFromYaml(YAML::Node const & node, T & object, detail::YamlSkippedKey const & skipped = {}) {
 	static_assert(param::can_decompose<T>, "no decomposition available for type T");
-	if (auto error = expectMap(node)) return error;
+	static_assert(!param::constructs_from_decomposition<T>, "types with a constructor decomposition can only be decoded as a whole");
 
 	// Make tuple of the member info with flag to remember if it was parsed.
-	auto members = estd::tuple_transform_decay(param::decompose<T>(), [] (auto const & member) {
-		return std::make_tuple(std::move(member), false);
+	auto const & decomposition = param::cachedDecompose<T>();
+	auto members = estd::tuple_transform_decay(decomposition, [] (auto const & member) {
+		return std::make_tuple(&member, false);
 	});
 
-	// Loop over all child nodes in the YAML struct.
-	for (auto child : node) {
-		// Extract struct key and value.
-		std::string const & key  = child.first.Scalar();
-		YAML::Node const & value = child.second;
-
-		// Storage for possible errors that may occur when parsing a child node.
-		std::optional<YamlError> error = std::nullopt;
-
+	auto decode_member = [&] (std::string_view key, YAML::Node const & value, std::optional<YamlError> & error) {
 		// Try each of the decomposed member description for a matching name.
 		std::size_t found_at = estd::for_each(members, [&] (auto & description) mutable {
-			auto const & member_info = std::get<0>(description);
+			auto const & member_info = *std::get<0>(description);
 			bool & parsed            = std::get<1>(description);
 
 			// Compare the YAML key with the member name.
@@ -92,7 +134,7 @@ std::optional<YamlError> parseDecomposableFromYaml(YAML::Node const & node, T &
 			// Try parsing the member from the YAML value.
 			auto result = parseYaml<member_type>(value);
 			if (!result) {
-				error = result.error().appendTrace({member_info.name, member_info.type, value.Type()});
+				error = std::move(result.error()).appendTrace({member_info.name, member_info.type, value.Type()});
 			} else {
 				member_info.access(object) = std::move(*result);
 				parsed = true;
@@ -101,18 +143,14 @@ std::optional<YamlError> parseDecomposableFromYaml(YAML::Node const & node, T &
 			// Stop looping over the decomposed members, we already got a match.
 			return false;
 		});
-
-		// If we looped over all decomposed members without finding a match, the property is unknown.
-		if (found_at == estd::size(members)) return YamlError{"unknown property `" + key + "'"};
-
-		// If we did find it but parsing it failed, return that error.
-		if (error) return error;
-	}
+		return found_at != estd::size(members);
+	};
+	if (auto error = detail::parseYamlMembers(node, skipped, decode_member)) return error;
 
 	// Check if all required decomposed members were actually parsed.
 	std::optional<YamlError> error;
 	estd::for_each(members, [&] (auto const & description) {
-		auto const & member_info = std::get<0>(description);
+		auto const & member_info = *std::get<0>(description);
 		bool parsed              = std::get<1>(description);
 		if (!parsed && member_info.required) {
 			error = YamlError{"missing property `" + member_info.name + "'"};
@@ -124,18 +162,292 @@ std::optional<YamlError> parseDecomposableFromYaml(YAML::Node const & node, T &
 	return error;
 }
 
-/// Convert a YAML::Node to a decomposable type.
+namespace detail {
+	/// Construct a T from the decoded values of its members.
+	/**
+	 * T is constructed with parentheses if possible, and with braces otherwise to support aggregates.
+	 */
+	template<typename T, typename... Args>
+	YamlResult<T> constructFromMembers(Args && ... args) {
+		if constexpr (std::is_constructible_v<T, Args && ...>) {
+			return {estd::in_place_valid, std::forward<Args>(args)...};
+		} else {
+			return {estd::in_place_valid, T{std::forward<Args>(args)...}};
+		}
+	}
+}
+
+/// Convert a YAML::Node to a type with a constructor decomposition.
 /**
+ * All members are decoded into local storage first.
+ * The object is then constructed once, by moving the decoded values into the constructor.
+ * This means T need not be default constructible or assignable.
+ *
  * The YAML node must be a map with each required member in the decomposition of T.
- * The YAML node may not contain any children not listed in the decomposition of T.
+ * The YAML node may not contain any children not listed in the decomposition of T,
+ * except for the `skipped` discriminator key of a variant that selected T.
+ * Missing optional members are value initialized.
+ * Missing members that are not default constructible are reported as missing, even if they are optional.
+ */
+template<typename T>
+YamlResult<T> parseDecomposableFromYamlByConstructor(YAML::Node const & node, detail::YamlSkippedKey const & skipped = {}) {
+	static_assert(param::constructs_from_decomposition<T>, "no constructor decomposition available for type T");
+
+	// Make tuple of the member info with storage for the decoded value.
+	auto const & decomposition = param::cachedDecompose<T>();
+	auto members = estd::tuple_transform_decay(decomposition, [] (auto const & member) {
+		using member_type = std::decay_t<decltype(member.access(std::declval<T const &>()))>;
+		return std::make_tuple(&member, std::optional<member_type>{});
+	});
+
+	auto decode_member = [&] (std::string_view key, YAML::Node const & value, std::optional<YamlError> & error) {
+		// Try each of the decomposed member description for a matching name.
+		std::size_t found_at = estd::for_each(members, [&] (auto & description) mutable {
+			auto const & member_info = *std::get<0>(description);
+			auto & decoded           = std::get<1>(description);
+
+			// Compare the YAML key with the member name.
+			// If it doesn't match, continue with the next decomposed member.
+			if (key != member_info.name) return true;
+
+			// Try parsing the member from the YAML value.
+			using member_type = typename std::decay_t<decltype(decoded)>::value_type;
+			auto result = parseYaml<member_type>(value);
+			if (!result) {
+				error = std::move(result.error()).appendTrace({member_info.name, member_info.type, value.Type()});
+			} else {
+				decoded.emplace(std::move(*result));
+			}
+
+			// Stop looping over the decomposed members, we already got a match.
+			return false;
+		});
+		return found_at != estd::size(members);
+	};
+	if (auto error = detail::parseYamlMembers(node, skipped, decode_member)) return std::move(*error);
+
+	// Check if all required decomposed members were actually parsed, and value initialize the missing optional ones.
+	std::optional<YamlError> error;
+	estd::for_each(members, [&] (auto & description) {
+		auto const & member_info = *std::get<0>(description);
+		auto & decoded           = std::get<1>(description);
+		using member_type = typename std::decay_t<decltype(decoded)>::value_type;
+		if (decoded) return true;
+		if constexpr (std::is_default_constructible_v<member_type>) {
+			if (!member_info.required) {
+				decoded.emplace();
+				return true;
+			}
+		}
+		// Members that can not be value initialized are required, even if marked optional.
+		error = YamlError{"missing property `" + member_info.name + "'"};
+		return false;
+	});
+	if (error) return std::move(*error);
+
+	return std::apply([] (auto & ... description) {
+		return detail::constructFromMembers<T>(std::move(*std::get<1>(description))...);
+	}, members);
+}
+
+/// Convert a YAML::Node to a decomposable type.
+/**
+ * Types with a constructor decomposition are decoded with parseDecomposableFromYamlByConstructor(),
+ * other types are default constructed and decoded member by member.
+ */
+template<typename T>
+YamlResult<T> parseDecomposableFromYaml(YAML::Node const & node, detail::YamlSkippedKey const & skipped = {}) {
+	if constexpr (param::constructs_from_decomposition<T>) {
+		return parseDecomposableFromYamlByConstructor<T>(node, skipped);
+	} else {
+		T object;
+		if (auto error = parseDecomposableFromYaml<T>(node, object, skipped)) return std::move(*error);
+		return {estd::in_place_valid, std::move(object)};
+	}
+}
+
+/// Convert an enum value to YAML::Node using the enum decomposition.
+/**
+ * The resulting node is a scalar with the name of the value.
+ * Values without a name are encoded as their underlying integer value.
+ */
+template<typename T>
+YAML::Node encodeEnumAsYaml(T value) {
+	static_assert(param::can_decompose_enum<T>, "no enum decomposition available for type T");
+	if (std::optional<std::string_view> name = param::enumName(value)) return YAML::Node(std::string{*name});
+	return encodeYaml(static_cast<std::underlying_type_t<T>>(value));
+}
+
+namespace detail {
+	/// Decode the text of a scalar node as an enum value using the enum decomposition.
+	template<typename T>
+	YamlResult<T> parseYamlEnumScalar(std::string_view raw) {
+		if (std::optional<T> value = param::enumValue<T>(raw)) return *value;
+
+		// Values without a name are encoded as their underlying integer value, so accept those too.
+		using Underlying = std::underlying_type_t<T>;
+		using Integer    = std::conditional_t<std::is_signed_v<Underlying>, long long, unsigned long long>;
+		if (YamlResult<Integer> integer = parseYamlScalar<Integer>(raw)) {
+			bool in_range = *integer >= std::numeric_limits<Underlying>::lowest() && *integer <= std::numeric_limits<Underlying>::max();
+			if (in_range && !param::enumName(T(*integer))) return T(*integer);
+		}
+
+		constexpr auto const & table = param::EnumDecomposition<T>::table;
+		std::string message = "invalid value `" + std::string{raw} + "', expected one of: ";
+		for (std::size_t i = 0; i < table.size(); ++i) {
+			if (i != 0) message += ", ";
+			message += table.name(i);
+		}
+		return YamlError{std::move(message)};
+	}
+}
+
+/// Convert a YAML::Node to an enum value using the enum decomposition.
+/**
+ * The YAML node must be a scalar holding the name of one of the values in the decomposition,
+ * or the integer value of a value without a name, as written by encodeEnumAsYaml().
  */
 template<typename T>
-YamlResult<T> parseDecomposableFromYaml(YAML::Node const & node) {
+YamlResult<T> parseEnumFromYaml(YAML::Node const & node) {
+	static_assert(param::can_decompose_enum<T>, "no enum decomposition available for type T");
+	if (auto error = expectScalar(node)) return std::move(*error);
+	return detail::parseYamlEnumScalar<T>(node.Scalar());
+}
+
+/// Type-erased description of a single member of a decomposable type.
+/**
+ * Used by YamlMemberTable to decode decomposable types with a single small loop,
+ * rather than with code that is unrolled for each member.
+ */
+struct YamlMemberEntry {
+	/// The name of the member.
+	std::string_view name;
+
+	/// A human readable terse description of the type of the member.
+	std::string_view type;
+
+	/// True if the member is required to form a valid whole object.
+	bool required;
+
+	/// The member info from the decomposition, passed to `decode`.
+	void const * info;
+
+	/// Decode the member from a node and assign it to the member of the object.
+	std::optional<YamlError> (*decode)(void const * info, YAML::Node const & node, void * object);
+};
+
+/// Flat table of type-erased member descriptions of a decomposable type.
+/**
+ * The table is built once per type by yamlMemberTable<T>().
+ * Decoding with the table is driven by a single loop that is not instantiated per type,
+ * which greatly reduces code size for types with many members.
+ */
+struct YamlMemberTable {
+	/// The members, in the order of the decomposition.
+	std::vector<YamlMemberEntry> entries;
+
+	/// The member names with their index in `entries`, sorted by name for lookup.
+	std::vector<std::pair<std::string_view, std::size_t>> sorted_names;
+
+	/// Create a table from a list of entries.
+	explicit YamlMemberTable(std::vector<YamlMemberEntry> entries);
+
+	/// Find the index of a member by name.
+	std::optional<std::size_t> find(std::string_view name) const;
+
+	/// Decode the members of an object from a YAML map.
+	/**
+	 * This has the same behaviour and error messages as parseDecomposableFromYaml().
+	 */
+	std::optional<YamlError> parse(YAML::Node const & node, void * object, detail::YamlSkippedKey const & skipped = {}) const;
+};
+
+namespace detail {
+	template<typename T, typename Info>
+	std::optional<YamlError> decodeYamlMember(void const * info, YAML::Node const & node, void * object) {
+		Info const & member_info = *static_cast<Info const *>(info);
+		T & typed_object = *static_cast<T *>(object);
+
+		using member_type = std::decay_t<decltype(member_info.access(typed_object))>;
+		YamlResult<member_type> result = parseYaml<member_type>(node);
+		if (!result) return std::move(result.error());
+		member_info.access(typed_object) = std::move(*result);
+		return std::nullopt;
+	}
+
+	template<typename T, typename Members, std::size_t... I>
+	YamlMemberTable makeYamlMemberTable(Members const & members, std::index_sequence<I...>) {
+		return YamlMemberTable{{
+			YamlMemberEntry{
+				std::get<I>(members).name,
+				std::get<I>(members).type,
+				std::get<I>(members).required,
+				&std::get<I>(members),
+				&decodeYamlMember<T, std::tuple_element_t<I, Members>>,
+			}...
+		}};
+	}
+}
+
+/// Get the member table of a decomposable type.
+/**
+ * The table and the decomposition it refers to are created on first use.
+ */
+template<typename T>
+YamlMemberTable const & yamlMemberTable() {
+	static_assert(param::can_decompose<T>, "no decomposition available for type T");
+	static_assert(!param::constructs_from_decomposition<T>, "the member table does not support constructor decompositions");
+	// The table refers to the decomposition, so it is kept for the lifetime of the table.
+	static auto const members = param::decompose<T>();
+	using Members = std::decay_t<decltype(members)>;
+	static YamlMemberTable const table = detail::makeYamlMemberTable<T>(members, std::make_index_sequence<std::tuple_size_v<Members>>{});
+	return table;
+}
+
+/// Convert a YAML::Node to a decomposable type using the member table of the type.
+/**
+ * This is an alternative to parseDecomposableFromYaml() with the same behaviour.
+ * It produces much less code for types with many members, at the cost of an indirect call per member.
+ */
+template<typename T>
+std::optional<YamlError> parseDecomposableFromYamlTable(YAML::Node const & node, T & object, detail::YamlSkippedKey const & skipped = {}) {
+	return yamlMemberTable<T>().parse(node, &object, skipped);
+}
+
+/// Convert a YAML::Node to a decomposable type using the member table of the type.
+/**
+ * This is an alternative to parseDecomposableFromYaml() with the same behaviour.
+ * It produces much less code for types with many members, at the cost of an indirect call per member.
+ */
+template<typename T>
+YamlResult<T> parseDecomposableFromYamlTable(YAML::Node const & node, detail::YamlSkippedKey const & skipped = {}) {
 	T object;
-	if (auto error = parseDecomposableFromYaml<T>(node, object)) return std::move(*error);
+	if (auto error = parseDecomposableFromYamlTable<T>(node, object, skipped)) return std::move(*error);
 	return {estd::in_place_valid, std::move(object)};
 }
 
+/// Marker to indicate if the default conversion from YAML::Node for a decomposable type should use the member table.
+/**
+ * Defaults to false, in which case parseDecomposableFromYaml() is used.
+ * Specialize this to true for large types to use parseDecomposableFromYamlTable() instead.
+ */
+template<typename T>
+struct use_yaml_member_table : std::false_type {};
+
+namespace detail {
+	/// Decomposable types skip the discriminator key of a variant that selected them.
+	template<typename T>
+	struct skips_yaml_key<T, std::enable_if_t<param::can_decompose<T> && enable_yaml_conversion_with_decompose<T>::value>> : std::true_type {
+		static YamlResult<T> parse(YAML::Node const & node, YamlSkippedKey const & skipped) {
+			if constexpr (use_yaml_member_table<T>::value) {
+				return parseDecomposableFromYamlTable<T>(node, skipped);
+			} else {
+				return parseDecomposableFromYaml<T>(node, skipped);
+			}
+		}
+	};
+}
+
 }
 
 // Default conversion to YAML::Node.
@@ -144,7 +456,11 @@ struct estd::conversion<T, YAML::Node> {
 	static constexpr bool possible = dr::enable_yaml_conversion_with_decompose<T>::value;
 
 	static YAML::Node perform(T const & object) {
-		return dr::encodeDecomposableAsYaml(object);
+		if constexpr (dr::param::can_decompose_enum<T>) {
+			return dr::encodeEnumAsYaml(object);
+		} else {
+			return dr::encodeDecomposableAsYaml(object);
+		}
 	}
 };
 
@@ -154,6 +470,56 @@ struct estd::conversion<YAML::Node, dr::YamlResult<T>> {
 	static constexpr bool possible = dr::enable_yaml_conversion_with_decompose<T>::value;
 
 	static dr::YamlResult<T> perform(YAML::Node const & node) {
-		return dr::parseDecomposableFromYaml<T>(node);
+		if constexpr (dr::param::can_decompose_enum<T>) {
+			return dr::parseEnumFromYaml<T>(node);
+		} else if constexpr (dr::use_yaml_member_table<T>::value) {
+			return dr::parseDecomposableFromYamlTable<T>(node);
+		} else {
+			return dr::parseDecomposableFromYaml<T>(node);
+		}
 	}
 };
+
+// These bits are here to keep the explicit instantiation declarations and definitions in sync.
+#define DR_PARAM_YAML_INSTANTIATIONS(PREFIX, TYPE) \
+PREFIX ::dr::YamlResult<TYPE> dr::parseDecomposableFromYaml<TYPE>(::YAML::Node const &, ::dr::detail::YamlSkippedKey const &); \
+PREFIX ::YAML::Node dr::encodeDecomposableAsYaml<TYPE>(TYPE const &); \
+PREFIX ::dr::YamlResult<::std::vector<TYPE>> estd::detail::parseYamlVector<TYPE>(::YAML::Node const &); \
+PREFIX ::YAML::Node estd::detail::encodeYamlVector<TYPE>(::std::vector<TYPE> const &); \
+PREFIX ::dr::YamlResult<::std::optional<TYPE>> estd::detail::parseYamlOptional<TYPE>(::YAML::Node const &); \
+PREFIX ::dr::YamlResult<::std::map<::std::string, TYPE>> estd::detail::parseYamlMap<::std::string, TYPE>(::YAML::Node const &); \
+PREFIX ::dr::YamlResult<::std::map<int, TYPE>> estd::detail::parseYamlMap<int, TYPE>(::YAML::Node const &); \
+PREFIX ::dr::YamlResult<::std::unordered_map<::std::string, TYPE>> estd::detail::parseYamlMap<::std::string, TYPE, ::std::unordered_map<::std::string, TYPE>>(::YAML::Node const &); \
+PREFIX ::dr::YamlResult<::std::unordered_map<int, TYPE>> estd::detail::parseYamlMap<int, TYPE, ::std::unordered_map<int, TYPE>>(::YAML::Node const &)
+
+/// Declare that the YAML conversions of a decomposable type are instantiated in another translation unit.
+/**
+ * This macro must be invoked from the global namespace,
+ * after the decomposition of the type has been defined.
+ *
+ * It suppresses the implicit instantiation of the decoding and encoding functions for the type and std::vector of the type,
+ * and of the decoding functions for std::optional of the type and for std::map and std::unordered_map
+ * with std::string or int keys and the type as values.
+ * Exactly one translation unit must instantiate them with DR_PARAM_INSTANTIATE_YAML.
+ *
+ * Not covered, and still instantiated in every translation unit that uses them, are:
+ *  - parseDecomposableFromYamlTable(), used for types that opt in to use_yaml_member_table,
+ *    because it can not be instantiated for types with a constructor decomposition,
+ *  - the decoding of FlatMap, which requires the type to be move assignable,
+ *  - parseYaml<T>(YamlDomNode) and parseDecomposableFromYaml(YamlDomNode, ...) from yaml_dom.hpp.
+ *
+ * Typical usage, in a header:
+ *   DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(MyStruct, ...);
+ *   DR_PARAM_EXTERN_YAML(MyStruct);
+ */
+#define DR_PARAM_EXTERN_YAML(TYPE) DR_PARAM_YAML_INSTANTIATIONS(extern template, TYPE)
+
+/// Instantiate the YAML conversions of a decomposable type.
+/**
+ * This macro must be invoked from the global namespace, in exactly one source file.
+ * See DR_PARAM_EXTERN_YAML.
+ *
+ * Typical usage, in a source file:
+ *   DR_PARAM_INSTANTIATE_YAML(MyStruct);
+ */
+#define DR_PARAM_INSTANTIATE_YAML(TYPE) DR_PARAM_YAML_INSTANTIATIONS(template, TYPE)
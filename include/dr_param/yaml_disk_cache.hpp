@@ -0,0 +1,111 @@
+#pragma once
+#include <estd/result.hpp>
+
+#include <yaml-cpp/yaml.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * This header defines a persistent cache for preprocessed YAML documents.
+ */
+
+namespace dr {
+
+/// Statistics of a YamlDiskCache.
+struct YamlDiskCacheStats {
+	/// Number of lookups that found a valid cached document.
+	std::uint64_t hits;
+
+	/// Number of lookups that did not find a valid cached document.
+	std::uint64_t misses;
+
+	/// Number of documents stored in the cache.
+	std::uint64_t stores;
+
+	/// Number of files removed from the cache to stay within the size limit.
+	std::uint64_t evictions;
+
+	/// Number of files currently in the cache directory.
+	std::uint64_t files;
+
+	/// Total size in bytes of the files currently in the cache directory.
+	std::uint64_t bytes;
+};
+
+/// Persistent cache for preprocessed YAML documents.
+/**
+ * The cache is a directory with two kinds of files:
+ * an index per root file and set of variables that lists all included files and listed directories,
+ * and the preprocessed documents themselves, named after a hash of the contents of the root file,
+ * the contents of all included files, the entries of all listed directories and the variables.
+ *
+ * A lookup reads the index, hashes the contents of the files and directories and loads the matching document.
+ * If any of the files changed, or files were added to or removed from a directory listed by !include_dir or !include_glob,
+ * the hash no longer matches and the lookup misses.
+ *
+ * All files are written to a temporary file first and then atomically renamed,
+ * so multiple processes and threads can safely share the same cache directory.
+ *
+ * When the total size of the cache exceeds the maximum size after storing a document,
+ * the least recently used files are removed.
+ *
+ * The hit/miss counters in the statistics are kept per YamlDiskCache object, not per directory.
+ */
+class YamlDiskCache {
+	/// The cache directory.
+	std::string directory_;
+
+	/// The maximum total size of the cache directory in bytes.
+	std::uint64_t max_size_;
+
+	std::atomic<std::uint64_t> hits_{0};
+	std::atomic<std::uint64_t> misses_{0};
+	std::atomic<std::uint64_t> stores_{0};
+	std::atomic<std::uint64_t> evictions_{0};
+
+public:
+	/// Create a cache using the given directory, which is created if it does not exist yet.
+	explicit YamlDiskCache(std::string directory, std::uint64_t max_size = 64 * 1024 * 1024);
+
+	/// Get the cache directory.
+	std::string const & directory() const {
+		return directory_;
+	}
+
+	/// Look up the preprocessed document for a file.
+	/**
+	 * If `included_files` is not null and a document is found,
+	 * the paths of the files included by the document are appended to it,
+	 * and likewise for `listed_directories`.
+	 *
+	 * Returns std::nullopt if there is no valid cached document.
+	 */
+	std::optional<YAML::Node> lookup(
+		std::string const & path,
+		std::map<std::string, std::string> const & variables,
+		std::vector<std::string> * included_files = nullptr,
+		std::vector<std::string> * listed_directories = nullptr
+	);
+
+	/// Store the preprocessed document for a file.
+	estd::result<void, estd::error> store(
+		std::string const & path,
+		std::map<std::string, std::string> const & variables,
+		YAML::Node const & document,
+		std::vector<std::string> const & included_files,
+		std::vector<std::string> const & listed_directories = {}
+	);
+
+	/// Remove the least recently used files until the cache is within the maximum size.
+	estd::result<void, estd::error> evict();
+
+	/// Get the statistics of the cache.
+	YamlDiskCacheStats stats() const;
+};
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "yaml.hpp"
+#include "yaml_context.hpp"
+
+#include <string_view>
+#include <utility>
+
+/**
+ * This header defines a decoded value that keeps the YAML document it was decoded from alive.
+ */
+
+namespace dr {
+
+/// A value decoded from a YAML document, together with the document.
+/**
+ * Decoding a `std::string_view` gives a view on the scalar in the YAML node tree, without copying it.
+ * Normally that view dangles as soon as the node tree is destroyed,
+ * so string members have to be decoded as `std::string`, allocating a copy of each string.
+ *
+ * A YamlDocument owns the node tree, and so the memory of all scalars in it.
+ * All `std::string_view` members and map keys of the decoded value remain valid for as long as the document exists.
+ * Copies of a document share the same node tree, so views in the copied value remain valid too.
+ *
+ * The node tree can not be modified through the document, since that could invalidate the views.
+ * Other handles to the same node tree must not modify it either.
+ */
+template<typename T>
+class YamlDocument {
+	/// The node tree the value was decoded from.
+	YAML::Node node_;
+
+	/// The decoded value.
+	T value_;
+
+	YamlDocument(YAML::Node node, T && value) : node_{std::move(node)}, value_{std::move(value)} {}
+
+	template<typename U> friend YamlResult<YamlDocument<U>> parseYamlDocument(YAML::Node const & node);
+
+public:
+	/// Get the decoded value.
+	T const & value() const { return value_; }
+
+	/// Get the decoded value.
+	T const & operator*() const { return value_; }
+
+	/// Access a member of the decoded value.
+	T const * operator->() const { return &value_; }
+
+	/// Get the node tree the value was decoded from.
+	YAML::Node const & node() const { return node_; }
+};
+
+/// Decode a value from a node tree, and keep the node tree alive with the value.
+/**
+ * The document shares the node tree with the given node, it is not copied.
+ */
+template<typename T>
+YamlResult<YamlDocument<T>> parseYamlDocument(YAML::Node const & node) {
+	YamlResult<T> value = parseYaml<T>(node);
+	if (!value) return std::move(value.error());
+	return YamlDocument<T>{node, std::move(*value)};
+}
+
+/// Load a YAML document from a buffer, decode it and keep the node tree alive with the value.
+/**
+ * The buffer is read with the parse context of the calling thread, see parseYamlBuffer().
+ * The buffer itself does not need to stay valid after the call,
+ * since the views in the value point into the node tree owned by the document.
+ */
+template<typename T>
+YamlResult<YamlDocument<T>> parseYamlDocumentBuffer(std::string_view data) {
+	YamlResult<YAML::Node> node = YamlParseContext::threadLocal().load(data);
+	if (!node) return std::move(node.error());
+	return parseYamlDocument<T>(*node);
+}
+
+}
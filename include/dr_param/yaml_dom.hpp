@@ -0,0 +1,489 @@
+#pragma once
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose.hpp"
+#include "type_traits.hpp"
+
+#include <estd/result.hpp>
+#include <estd/tuple/for_each.hpp>
+#include <estd/tuple/transform.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * This header defines a compact read-only representation of YAML documents.
+ *
+ * A YAML::Node tree allocates every node separately, with reference counted memory shared between the nodes.
+ * A YamlDom stores all nodes of a document in a few contiguous arrays instead,
+ * which takes far fewer allocations to build and is much friendlier to the cache when decoding.
+ */
+
+namespace dr {
+
+class YamlDom;
+class YamlDomNode;
+
+namespace detail {
+	class YamlDomBuilder;
+
+	/// A node in a YamlDom.
+	struct YamlDomNodeData {
+		/// The type of the node.
+		YAML::NodeType::value type;
+
+		/// The index of the tag of the node in the tag table.
+		std::uint32_t tag;
+
+		/// The offset of the scalar in the string arena, or of the first child in the child table.
+		std::uint32_t offset;
+
+		/// The length of the scalar, the number of sequence elements or the number of map entries.
+		/**
+		 * Map entries take two slots in the child table, the key followed by the value.
+		 */
+		std::uint32_t size;
+	};
+}
+
+/// An entry of a map in a YamlDom.
+struct YamlDomEntry;
+
+/// Iterator over the elements of a sequence or the entries of a map in a YamlDom.
+template<typename Value>
+class YamlDomIterator {
+	/// The document.
+	YamlDom const * dom_;
+
+	/// The position in the child table of the document.
+	std::uint32_t const * position_;
+
+	/// Map entries take two slots in the child table.
+	static constexpr std::size_t stride = std::is_same_v<Value, YamlDomNode> ? 1 : 2;
+
+public:
+	YamlDomIterator(YamlDom const * dom, std::uint32_t const * position) : dom_{dom}, position_{position} {}
+
+	Value operator*() const;
+
+	YamlDomIterator & operator++() {
+		position_ += stride;
+		return *this;
+	}
+
+	bool operator==(YamlDomIterator const & other) const { return position_ == other.position_; }
+	bool operator!=(YamlDomIterator const & other) const { return position_ != other.position_; }
+};
+
+/// Range of iterators.
+template<typename Iterator>
+struct YamlDomRange {
+	Iterator first;
+	Iterator last;
+
+	Iterator begin() const { return first; }
+	Iterator end() const { return last; }
+};
+
+/// A read-only handle to a node in a YamlDom.
+/**
+ * Handles are cheap to copy.
+ * They refer to the YamlDom object, so they must not be used after it is destroyed or moved.
+ */
+class YamlDomNode {
+	friend class YamlDom;
+	template<typename Value> friend class YamlDomIterator;
+
+	/// The document.
+	YamlDom const * dom_;
+
+	/// The index of the node in the document.
+	std::uint32_t index_;
+
+	YamlDomNode(YamlDom const * dom, std::uint32_t index) : dom_{dom}, index_{index} {}
+
+	/// Get the data of the node.
+	detail::YamlDomNodeData const & data() const;
+
+	/// Get the start of the children of the node in the child table.
+	std::uint32_t const * children() const;
+
+public:
+	/// Get the type of the node.
+	YAML::NodeType::value type() const { return data().type; }
+
+	bool isNull()     const { return type() == YAML::NodeType::Null; }
+	bool isScalar()   const { return type() == YAML::NodeType::Scalar; }
+	bool isSequence() const { return type() == YAML::NodeType::Sequence; }
+	bool isMap()      const { return type() == YAML::NodeType::Map; }
+
+	/// Get the tag of the node.
+	std::string const & tag() const;
+
+	/// Get the value of a scalar node, or an empty string for other nodes.
+	/**
+	 * The returned view is followed by a null character,
+	 * and remains valid for as long as the document exists, even if the document is moved.
+	 */
+	std::string_view scalar() const;
+
+	/// Get the number of elements of a sequence or entries of a map, or zero for other nodes.
+	std::size_t size() const { return isMap() || isSequence() ? data().size : 0; }
+
+	/// Get an element of a sequence.
+	/**
+	 * The node must be a sequence with more than `index` elements.
+	 */
+	YamlDomNode operator[](std::size_t index) const { return {dom_, children()[index]}; }
+
+	/// Get an entry of a map.
+	/**
+	 * The node must be a map with more than `index` entries.
+	 */
+	YamlDomEntry entry(std::size_t index) const;
+
+	/// Find the value of a map entry by key.
+	/**
+	 * This compares the key with each entry in turn.
+	 * Returns std::nullopt if the node is not a map or has no entry with the key.
+	 */
+	std::optional<YamlDomNode> find(std::string_view key) const;
+
+	/// Iterate over the elements of a sequence.
+	YamlDomIterator<YamlDomNode> begin() const { return {dom_, children()}; }
+	YamlDomIterator<YamlDomNode> end() const { return {dom_, children() + (isSequence() ? data().size : 0)}; }
+
+	/// Iterate over the entries of a map.
+	YamlDomRange<YamlDomIterator<YamlDomEntry>> entries() const {
+		return {{dom_, children()}, {dom_, children() + (isMap() ? 2 * data().size : 0)}};
+	}
+
+	/// Get the identity of the node, which is the same for all aliases of the node.
+	void const * identity() const { return &data(); }
+
+	/// Convert the subtree of the node to a YAML::Node tree.
+	/**
+	 * Nodes that are shared through aliases remain shared in the YAML::Node tree.
+	 */
+	YAML::Node toYaml() const;
+};
+
+struct YamlDomEntry {
+	YamlDomNode key;
+	YamlDomNode value;
+};
+
+/// A YAML document stored in contiguous arrays.
+/**
+ * All nodes are stored in a single array, and refer to their children through a shared child table.
+ * Scalars and tags are stored in a shared string arena.
+ * Accessing the children or the scalar of a node takes constant time.
+ *
+ * Aliases are resolved to the node they refer to, so an aliased node is stored only once.
+ *
+ * A YamlDom is read-only, use toYaml() to get a node tree that can be modified.
+ */
+class YamlDom {
+	friend class YamlDomNode;
+	template<typename Value> friend class YamlDomIterator;
+	friend class detail::YamlDomBuilder;
+
+	/// The nodes.
+	std::vector<detail::YamlDomNodeData> nodes_;
+
+	/// The children of all maps and sequences, as node indices.
+	std::vector<std::uint32_t> children_;
+
+	/// The scalars, each followed by a null character.
+	std::vector<char> strings_;
+
+	/// The distinct tags used in the document.
+	std::vector<std::string> tags_;
+
+	/// The index of the root node.
+	std::uint32_t root_ = 0;
+
+public:
+	/// Create a document with a single null node.
+	YamlDom();
+
+	/// Create a document from a YAML::Node tree.
+	/**
+	 * Nodes that are shared through aliases remain shared in the document.
+	 * Throws std::length_error if the scalars of the document take more than 4 GiB.
+	 */
+	explicit YamlDom(YAML::Node const & node);
+
+	/// Get the root node of the document.
+	YamlDomNode root() const { return {this, root_}; }
+
+	/// Get the number of nodes in the document.
+	std::size_t nodeCount() const { return nodes_.size(); }
+
+	/// Convert the document to a YAML::Node tree.
+	YAML::Node toYaml() const { return root().toYaml(); }
+};
+
+inline detail::YamlDomNodeData const & YamlDomNode::data() const {
+	return dom_->nodes_[index_];
+}
+
+inline std::uint32_t const * YamlDomNode::children() const {
+	return dom_->children_.data() + data().offset;
+}
+
+inline std::string const & YamlDomNode::tag() const {
+	return dom_->tags_[data().tag];
+}
+
+inline std::string_view YamlDomNode::scalar() const {
+	if (!isScalar()) return {};
+	return {dom_->strings_.data() + data().offset, data().size};
+}
+
+inline YamlDomEntry YamlDomNode::entry(std::size_t index) const {
+	std::uint32_t const * entry = children() + 2 * index;
+	return {{dom_, entry[0]}, {dom_, entry[1]}};
+}
+
+template<typename Value>
+Value YamlDomIterator<Value>::operator*() const {
+	if constexpr (std::is_same_v<Value, YamlDomNode>) {
+		return YamlDomNode{dom_, position_[0]};
+	} else {
+		return YamlDomEntry{{dom_, position_[0]}, {dom_, position_[1]}};
+	}
+}
+
+/// Load a YAML document from a buffer directly into a YamlDom.
+/**
+ * The document is built from the events of the yaml-cpp parser, without creating a YAML::Node tree.
+ * Syntax errors are reported as YamlError with the line and column of the error.
+ */
+YamlResult<YamlDom> loadYamlDom(std::string_view data);
+
+/// Read a YAML file from a path directly into a YamlDom.
+estd::result<YamlDom, estd::error> readYamlDomFile(std::string const & path);
+
+/// Merge the entries of map_b into map_a and return the merged map as new document.
+/**
+ * This has the same behaviour as mergeYamlNodes(), but leaves both inputs untouched.
+ */
+YamlResult<YamlDom> mergeYamlDoms(YamlDomNode map_a, YamlDomNode map_b);
+
+/// Test if a node is a map, and if not, return a YamlError with a descriptive error message.
+std::optional<YamlError> expectMap(YamlDomNode node);
+
+/// Test if a node is a sequence, and if not, return a YamlError with a descriptive error message.
+std::optional<YamlError> expectSequence(YamlDomNode node);
+
+/// Test if a node is a sequence with a given size, and if not, return a YamlError with a descriptive error message.
+std::optional<YamlError> expectSequence(YamlDomNode node, std::size_t size);
+
+/// Test if a node is a scalar, and if not, return a YamlError with a descriptive error message.
+std::optional<YamlError> expectScalar(YamlDomNode node);
+
+template<typename T>
+YamlResult<T> parseYaml(YamlDomNode node);
+
+/// Convert a YamlDomNode to a decomposable type.
+/**
+ * This has the same behaviour and error messages as parseDecomposableFromYaml() for a YAML::Node.
+ */
+template<typename T>
+std::optional<YamlError> parseDecomposableFromYaml(YamlDomNode node, T & object, detail::YamlSkippedKey const & skipped = {}) {
+	static_assert(param::can_decompose<T>, "no decomposition available for type T");
+	static_assert(!param::constructs_from_decomposition<T>, "types with a constructor decomposition can only be decoded as a whole");
+
+	// Make tuple of the member info with flag to remember if it was parsed.
+	auto const & decomposition = param::cachedDecompose<T>();
+	auto members = estd::tuple_transform_decay(decomposition, [] (auto const & member) {
+		return std::make_tuple(&member, false);
+	});
+
+	auto decode_member = [&] (std::string_view key, YamlDomNode const & value, std::optional<YamlError> & error) {
+		std::size_t found_at = estd::for_each(members, [&] (auto & description) mutable {
+			auto const & member_info = *std::get<0>(description);
+			bool & parsed            = std::get<1>(description);
+			if (key != member_info.name) return true;
+
+			using member_type = std::decay_t<decltype(member_info.access(object))>;
+			auto result = parseYaml<member_type>(value);
+			if (!result) {
+				error = std::move(result.error()).appendTrace({member_info.name, member_info.type, value.type()});
+			} else {
+				member_info.access(object) = std::move(*result);
+				parsed = true;
+			}
+			return false;
+		});
+		return found_at != estd::size(members);
+	};
+	if (auto error = detail::parseYamlMembers(node, skipped, decode_member)) return error;
+
+	// Check if all required decomposed members were actually parsed.
+	std::optional<YamlError> error;
+	estd::for_each(members, [&] (auto const & description) {
+		auto const & member_info = *std::get<0>(description);
+		bool parsed              = std::get<1>(description);
+		if (!parsed && member_info.required) {
+			error = YamlError{"missing property `" + member_info.name + "'"};
+			return false;
+		}
+		return true;
+	});
+
+	return error;
+}
+
+/// Parse a YamlDomNode into a type T.
+/**
+ * Scalars, the standard containers with conversions in yaml.hpp, enums and decomposable types
+ * are decoded directly from the document, with the same behaviour and error messages as for a YAML::Node.
+ * All other types are decoded with their YAML::Node conversion, from a YAML::Node copy of the subtree.
+ *
+ * Decoded `std::string_view` values and map keys point into the document,
+ * and remain valid for as long as the document exists.
+ *
+ * Resource limits set with YamlLimitsScope apply, but YamlAliasScope does not.
+ */
+template<typename T>
+YamlResult<T> parseYaml(YamlDomNode node) {
+	static_assert(can_parse_yaml<T>, "No YAML conversion defined for T");
+	using namespace param::detail;
+
+	detail::YamlDecodeBudget * budget = detail::current_yaml_decode_budget;
+	if (budget) {
+		if (std::optional<YamlError> error = budget->addNode()) return std::move(*error);
+	}
+	if constexpr (!std::is_same_v<T, YAML::Node>) {
+		// Deferred includes hold the path of the included file, which must not be mistaken for its contents.
+		if (node.isScalar() && detail::isYamlDeferredIncludeTag(node.tag())) return detail::unresolvedYamlInclude(node.scalar());
+	}
+
+	// Check the length of a container against the decode budget.
+	auto check_length = [&] () -> std::optional<YamlError> {
+		if (budget && node.size() > budget->limits.max_sequence_length) return budget->tooLong(node.size());
+		return std::nullopt;
+	};
+
+	if constexpr (std::is_same_v<T, YAML::Node>) {
+		return node.toYaml();
+	} else if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+		if (auto error = expectScalar(node)) return std::move(*error);
+		return detail::parseYamlScalar<T>(node.scalar());
+	} else if constexpr (is_std_vector<T>::value) {
+		using Element = typename T::value_type;
+		if (node.isNull()) return T{};
+		if (auto error = expectSequence(node)) return std::move(*error);
+		if (auto error = check_length()) return std::move(*error);
+
+		T result;
+		result.reserve(node.size());
+		for (std::size_t i = 0; i < node.size(); ++i) {
+			YamlResult<Element> element = parseYaml<Element>(node[i]);
+			if (!element) return std::move(element.error()).appendTrace(i, node[i].type());
+			result.push_back(std::move(*element));
+		}
+		return result;
+	} else if constexpr (is_std_array<T>::value) {
+		using Element = typename T::value_type;
+		if (auto error = expectSequence(node, std::tuple_size_v<T>)) return std::move(*error);
+
+		T result;
+		for (std::size_t i = 0; i < node.size(); ++i) {
+			YamlResult<Element> element = parseYaml<Element>(node[i]);
+			if (!element) return std::move(element.error()).appendTrace(i, node[i].type());
+			result[i] = std::move(*element);
+		}
+		return result;
+	} else if constexpr (is_std_optional<T>::value) {
+		if (node.isNull()) return T{};
+		YamlResult<typename T::value_type> value = parseYaml<typename T::value_type>(node);
+		if (!value) return std::move(value.error());
+		return {estd::in_place_valid, T{std::move(*value)}};
+	} else if constexpr (is_std_shared_ptr<T>::value) {
+		using Element = std::remove_const_t<typename T::element_type>;
+		if (node.isNull()) return T{};
+		YamlResult<Element> value = parseYaml<Element>(node);
+		if (!value) return std::move(value.error());
+		return T{std::make_shared<Element const>(std::move(*value))};
+	} else if constexpr (is_std_map<T>::value || is_std_unordered_map<T>::value || is_flat_map<T>::value) {
+		using Key   = typename T::key_type;
+		using Value = typename T::mapped_type;
+		if (auto error = expectMap(node)) return std::move(*error);
+		if (auto error = check_length()) return std::move(*error);
+
+		auto duplicate_key = [] (YamlDomNode key) {
+			return YamlError{"duplicate key"}.appendTrace({std::string{key.scalar()}, "", key.type()});
+		};
+
+		// Flat maps are sorted once after collecting all entries.
+		std::conditional_t<is_flat_map<T>::value, std::vector<std::pair<Key, Value>>, T> result;
+		if constexpr (!is_std_map<T>::value) result.reserve(node.size());
+
+		for (YamlDomEntry entry : node.entries()) {
+			YamlResult<Key> key = parseYaml<Key>(entry.key);
+			if (!key) return std::move(key.error()).appendTrace({std::string{entry.key.scalar()}, "", entry.key.type()});
+
+			YamlResult<Value> value = parseYaml<Value>(entry.value);
+			if (!value) return std::move(value.error()).appendTrace({std::string{entry.key.scalar()}, "", entry.value.type()});
+
+			if constexpr (is_flat_map<T>::value) {
+				result.emplace_back(std::move(*key), std::move(*value));
+			} else if (!result.emplace(std::move(*key), std::move(*value)).second) {
+				return duplicate_key(entry.key);
+			}
+		}
+
+		if constexpr (is_flat_map<T>::value) {
+			typename T::key_compare compare;
+			auto duplicate = detail::sortFlatMapEntries(result, compare);
+			if (duplicate != result.end()) {
+				// Only on error, look up the second occurrence of the key in the document for the trace.
+				bool seen = false;
+				for (YamlDomEntry entry : node.entries()) {
+					// Decoding again can still fail, for example when the limits of a YamlLimitsScope are exceeded.
+					YamlResult<Key> key = parseYaml<Key>(entry.key);
+					if (!key) return std::move(key.error()).appendTrace({std::string{entry.key.scalar()}, "", entry.key.type()});
+					if (compare(*key, duplicate->first) || compare(duplicate->first, *key)) continue;
+					if (seen) return duplicate_key(entry.key);
+					seen = true;
+				}
+			}
+			return T::fromSorted(std::move(result), std::move(compare));
+		} else {
+			return result;
+		}
+	} else if constexpr (param::can_decompose_enum<T> && enable_yaml_conversion_with_decompose<T>::value) {
+		if (auto error = expectScalar(node)) return std::move(*error);
+		return detail::parseYamlEnumScalar<T>(node.scalar());
+	} else if constexpr (
+		param::can_decompose<T>
+		&& enable_yaml_conversion_with_decompose<T>::value
+		&& !param::constructs_from_decomposition<T>
+		&& !use_yaml_member_table<T>::value
+	) {
+		T object;
+		if (auto error = parseDecomposableFromYaml<T>(node, object)) return std::move(*error);
+		return {estd::in_place_valid, std::move(object)};
+	} else {
+		// Fall back to the YAML::Node conversion of T.
+		return estd::parse<T, YamlError>(node.toYaml());
+	}
+}
+
+/// Parse a whole YamlDom into a type T.
+template<typename T>
+YamlResult<T> parseYaml(YamlDom const & dom) {
+	return parseYaml<T>(dom.root());
+}
+
+}
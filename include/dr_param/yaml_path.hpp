@@ -0,0 +1,226 @@
+#pragma once
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "type_traits.hpp"
+
+#include <estd/tuple/for_each.hpp>
+#include <estd/tuple/tuple.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * This header implements decoding of selected parts of a YAML document.
+ *
+ * Parts of a document are selected with paths in the same syntax as printed by YamlError::formatTrace(),
+ * for example `robots[3].tool.calibration`.
+ * Only the selected subtrees are decoded, all other subtrees are skipped without looking at them.
+ */
+
+namespace dr {
+
+/// Split a path into its steps.
+/**
+ * A path consists of map keys separated by a dot, and sequence indices enclosed in square brackets,
+ * like `robots[3].tool.calibration`.
+ * The first step may be a map key without a leading dot, or a sequence index.
+ *
+ * The returned steps refer to the memory of the path, so the path must outlive them.
+ * Keys that contain a dot or a square bracket can not be expressed in a path.
+ */
+YamlResult<std::vector<std::string_view>> splitYamlPath(std::string_view path);
+
+/// Select the node at the end of a path.
+/**
+ * For a map, a step selects the value of the key with the same name.
+ * For a sequence, a step selects the element at the index.
+ *
+ * If the path does not exist in the node tree, the error trace points to the last node that does exist.
+ */
+YamlResult<YAML::Node> selectYamlPath(YAML::Node const & root, std::vector<std::string_view> const & steps);
+
+/// Select the node at the end of a path.
+YamlResult<YAML::Node> selectYamlPath(YAML::Node const & root, std::string_view path);
+
+namespace detail {
+	/// Select the child of a map or sequence node with a single path step.
+	std::optional<YamlError> selectYamlChild(YAML::Node const & node, std::string_view step, YAML::Node & child);
+
+	/// Add the nodes along a path to the trace of an error that occured at the end of the path.
+	YamlError & appendYamlPathTrace(YamlError & error, YAML::Node const & root, std::vector<std::string_view> const & steps);
+
+	template<typename T>
+	std::optional<YamlError> parseYamlPathInto(YAML::Node const & node, T & object, std::string_view const * steps, std::size_t count);
+
+	/// Decode the rest of a path into a new, value initialized value, and pass it to `insert` only if that succeeds.
+	/**
+	 * This is used for values that do not exist in the object yet,
+	 * so they are only added to the object once the value at the end of the path is decoded.
+	 */
+	template<typename Value, typename Insert>
+	std::optional<YamlError> parseYamlPathIntoNew(YAML::Node const & node, std::string_view const * steps, std::size_t count, Insert && insert) {
+		Value value{};
+		if (auto error = parseYamlPathInto(node, value, steps, count)) return error;
+		insert(std::move(value));
+		return std::nullopt;
+	}
+
+	/// Decode the value at the end of a path through a node tree into the matching part of an object.
+	/**
+	 * The object is only modified if decoding succeeds.
+	 */
+	template<typename T>
+	std::optional<YamlError> parseYamlPathInto(YAML::Node const & node, T & object, std::string_view const * steps, std::size_t count) {
+		// The end of the path, decode the whole subtree.
+		if (count == 0) {
+			if constexpr (std::is_move_assignable_v<T>) {
+				YamlResult<T> result = parseYaml<T>(node);
+				if (!result) return std::move(result.error());
+				object = std::move(*result);
+				return std::nullopt;
+			} else {
+				return YamlError{"can not assign to the selected value"};
+			}
+		}
+
+		std::string_view step = steps[0];
+		YAML::Node child;
+
+		if constexpr (param::detail::is_std_optional<T>::value) {
+			// Optional values are transparent in paths.
+			using Value = typename T::value_type;
+			if (object) return parseYamlPathInto(node, *object, steps, count);
+			if constexpr (std::is_default_constructible_v<Value>) {
+				return parseYamlPathIntoNew<Value>(node, steps, count, [&] (Value && value) {
+					object.emplace(std::move(value));
+				});
+			} else {
+				return YamlError{"can not select `" + std::string{step} + "' in an empty value"};
+			}
+		} else if constexpr (param::can_decompose<T> && !param::constructs_from_decomposition<T>) {
+			if (auto error = expectMap(node)) return error;
+
+			// Find the decomposed member for the step, and recurse into it.
+			std::optional<YamlError> error;
+			auto const & members = param::cachedDecompose<T>();
+			std::size_t found_at = estd::for_each(members, [&] (auto const & member) {
+				if (step != member.name) return true;
+				error = selectYamlChild(node, step, child);
+				if (error) return false;
+				error = parseYamlPathInto(child, member.access(object), steps + 1, count - 1);
+				if (error) error->appendTrace({member.name, member.type, child.Type()});
+				return false;
+			});
+
+			if (found_at == estd::size(members)) return YamlError{"unknown property `" + std::string{step} + "'"};
+			return error;
+		} else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+			// The elements of std::vector<bool> do not have an address.
+			return YamlError{"can not select `" + std::string{step} + "' in a std::vector<bool>"};
+		} else if constexpr (param::detail::is_std_vector<T>::value || param::detail::is_std_array<T>::value) {
+			using Value = typename T::value_type;
+			if (auto error = expectSequence(node)) return error;
+			if (auto error = selectYamlChild(node, step, child)) return error;
+			std::size_t index = 0;
+			std::from_chars(step.data(), step.data() + step.size(), index);
+
+			std::optional<YamlError> error;
+			if (index < object.size()) {
+				error = parseYamlPathInto(child, object[index], steps + 1, count - 1);
+			} else if constexpr (param::detail::is_std_vector<T>::value && std::is_default_constructible_v<Value>) {
+				// Grow the vector only once the new element is decoded.
+				error = parseYamlPathIntoNew<Value>(child, steps + 1, count - 1, [&] (Value && value) {
+					object.resize(index);
+					object.push_back(std::move(value));
+				});
+			} else {
+				return YamlError{"can not select `" + std::string{step} + "' past the end of the list"};
+			}
+			if (error) error->appendTrace({std::string{step}, "", child.Type()});
+			return error;
+		} else if constexpr (param::detail::is_std_map<T>::value || param::detail::is_std_unordered_map<T>::value || param::detail::is_flat_map<T>::value) {
+			using Key   = typename T::key_type;
+			using Value = typename T::mapped_type;
+			if (auto error = expectMap(node)) return error;
+			if (auto error = selectYamlChild(node, step, child)) return error;
+
+			std::optional<YamlError> error;
+			if constexpr (std::is_same_v<Key, std::string_view> || !std::is_default_constructible_v<Value>) {
+				// A std::string_view key would point into the path instead of the node tree.
+				error = YamlError{"can not select entries of this map in a path"};
+			} else if constexpr (!std::is_same_v<Key, std::string> && !((std::is_integral_v<Key> || std::is_enum_v<Key>) && can_parse_yaml<Key>)) {
+				error = YamlError{"can not select `" + std::string{step} + "' in a map with this key type"};
+			} else {
+				// Integral and enum keys are decoded from the step, like in YamlAccessor.
+				YamlResult<Key> key = [&] () -> YamlResult<Key> {
+					if constexpr (std::is_same_v<Key, std::string>) return std::string{step};
+					else return parseYaml<Key>(YAML::Node{std::string{step}});
+				}();
+				if (!key) {
+					error = std::move(key.error());
+				} else if (auto found = object.find(*key); found != object.end()) {
+					error = parseYamlPathInto(child, found->second, steps + 1, count - 1);
+				} else {
+					// Add the entry only once its value is decoded.
+					error = parseYamlPathIntoNew<Value>(child, steps + 1, count - 1, [&] (Value && value) {
+						object.insert(typename T::value_type{std::move(*key), std::move(value)});
+					});
+				}
+			}
+			if (error) error->appendTrace({std::string{step}, "", child.Type()});
+			return error;
+		} else {
+			return YamlError{"can not select `" + std::string{step} + "' in a value without members"};
+		}
+	}
+}
+
+/// Parse only the value at the end of a path.
+/**
+ * All other parts of the document are skipped without being decoded.
+ * On failure, the error trace contains the full path from the root node.
+ */
+template<typename T>
+YamlResult<T> parseYamlPath(YAML::Node const & root, std::string_view path) {
+	YamlResult<std::vector<std::string_view>> steps = splitYamlPath(path);
+	if (!steps) return std::move(steps.error());
+
+	YamlResult<YAML::Node> node = selectYamlPath(root, *steps);
+	if (!node) return std::move(node.error());
+
+	YamlResult<T> result = parseYaml<T>(*node);
+	if (!result) detail::appendYamlPathTrace(result.error(), root, *steps);
+	return result;
+}
+
+/// Decode only the members of an object selected by a list of paths.
+/**
+ * Each path is followed through the decomposition of T and the YAML node tree at the same time,
+ * and only the value at the end of the path is decoded and assigned to the matching member of the object.
+ * All other members are left untouched, and all other parts of the document are skipped without being decoded.
+ *
+ * Paths can step through decomposable types, std::optional, std::vector, std::array,
+ * and std::map, std::unordered_map and FlatMap.
+ * Maps can be selected by string, integral or enum keys, but not by std::string_view keys.
+ * Stepping into a std::vector index grows the vector if needed, while a std::array index must be in range.
+ * Stepping into an empty std::optional value initializes it, and stepping into a missing map entry adds it.
+ *
+ * Decoding stops at the first error.
+ * The values selected by the paths before the failing path are decoded into the object,
+ * but nothing along the failing path is changed or added to the object.
+ */
+template<typename T>
+std::optional<YamlError> parseYamlPaths(YAML::Node const & root, T & object, std::vector<std::string_view> const & paths) {
+	for (std::string_view path : paths) {
+		YamlResult<std::vector<std::string_view>> steps = splitYamlPath(path);
+		if (!steps) return std::move(steps.error());
+		if (auto error = detail::parseYamlPathInto(root, object, steps->data(), steps->size())) return error;
+	}
+	return std::nullopt;
+}
+
+}
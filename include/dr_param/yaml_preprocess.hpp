@@ -1,10 +1,15 @@
 #pragma once
+#include "yaml.hpp"
+
 #include <estd/result.hpp>
 
 #include <yaml-cpp/yaml.h>
 
 #include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /**
  * This header defines utilities to parse a YAML file with some preprocessing.
@@ -14,6 +19,84 @@
 
 namespace dr {
 
+class YamlDiskCache;
+
+/// Cache for YAML files that are included while preprocessing.
+/**
+ * The cache stores the parsed contents of included files, before any preprocessing.
+ * Each user of the cache receives a deep copy of the cached document,
+ * so the returned nodes can be modified freely.
+ *
+ * The cache is thread-safe, so it can be shared by multiple threads preprocessing different files.
+ * That way, files included from many other files are read and parsed only once.
+ */
+class YamlIncludeCache {
+	/// Mutex to protect the cached documents.
+	std::mutex mutex_;
+
+	/// The cached documents, by normalized path.
+	std::map<std::string, YAML::Node> documents_;
+
+public:
+	/// Read a YAML file through the cache.
+	estd::result<YAML::Node, estd::error> read(std::string const & path);
+};
+
+/// Options for preprocessing YAML files.
+struct YamlPreprocessOptions {
+	/// Cache to read included files through, or null to read included files directly.
+	YamlIncludeCache * cache = nullptr;
+
+	/// Persistent cache for whole preprocessed documents, or null to always preprocess documents.
+	/**
+	 * Only used by preprocessYamlFile().
+	 * If the cache holds a valid document for the file, it is returned without any further preprocessing.
+	 * Otherwise, the preprocessed document is stored in the cache.
+	 */
+	YamlDiskCache * disk_cache = nullptr;
+
+	/// If not null, the normalized path of each included file is appended to this vector.
+	/**
+	 * Files included multiple times are appended multiple times.
+	 * The root file itself is not appended.
+	 */
+	std::vector<std::string> * included_files = nullptr;
+
+	/// If not null, the normalized path of each directory listed by !include_dir and !include_glob is appended to this vector.
+	/**
+	 * Adding or removing files in these directories can change the result of preprocessing,
+	 * even if none of the included files changed.
+	 */
+	std::vector<std::string> * listed_directories = nullptr;
+
+	/// If true, included files are only read when they are needed.
+	/**
+	 * Each !include node is replaced by a deferred include,
+	 * and so is each file matched by !include_dir and !include_glob.
+	 * A deferred include is a scalar node holding the normalized path of the included file,
+	 * with a tag that starts with `!deferred_include` and records the include depth.
+	 * Deferred includes are resolved by resolveYamlPath() and resolveYamlIncludes(),
+	 * so included files that are never accessed cause no I/O at all.
+	 * Decoding a deferred include that was not resolved fails.
+	 *
+	 * The tag also holds a key that is unique to the process,
+	 * so a `!deferred_include` tag written in a document is never mistaken for a deferred include.
+	 * Preprocessing rejects such tags.
+	 *
+	 * The disk cache is not used when this option is enabled.
+	 */
+	bool lazy_includes = false;
+
+	/// Limits on the resources used by preprocessing.
+	/**
+	 * Preprocessing enforces the include depth, the number of bytes read and the number of nodes.
+	 * The limits apply to each call to a preprocessing function as a whole,
+	 * including all files that are preprocessed in parallel.
+	 * Exceeding a limit fails with an error with code std::errc::value_too_large.
+	 */
+	YamlLimits limits;
+};
+
 /// Load a YAML file and preprocess it.
 /**
  * Preprocessing supports a number of tags on YAML nodes:
@@ -23,6 +106,19 @@ namespace dr {
  *     If the path is relative, it is interpreted relative to the parent directory of the file being loaded.
  *     Variables in the path are expanded.
  *
+ *   !include_dir "path"
+ *     Preprocess all files with a `.yaml` or `.yml` extension in a directory,
+ *     and include them as a map with the file stem as key.
+ *     The path is interpreted like the path of !include.
+ *     The files are read and preprocessed in parallel,
+ *     unless the directive itself is in a file that is preprocessed in parallel.
+ *
+ *   !include_glob "path/robot_*.yaml"
+ *     Preprocess all files matching a pattern and include them as a sequence, sorted by file name.
+ *     Only the file name part of the pattern may contain wildcards.
+ *     The files are read and preprocessed in parallel,
+ *     unless the directive itself is in a file that is preprocessed in parallel.
+ *
  *   !expand "string with $variables in it"
  *     Expand a string with variables in it.
  *     The variables are taken from the `variables` parameter.
@@ -30,12 +126,83 @@ namespace dr {
  *
  *     The variables "$DIR" and "$FILE" are always available when processing files,
  *     and contain the parent directory and file path of the file being processed.
+ *
+ * See YamlPreprocessOptions::lazy_includes to read included files only when they are needed.
  */
 estd::result<YAML::Node, estd::error> preprocessYamlFile(
 	std::string const & path,
 	std::map<std::string, std::string> variables
 );
 
+/// Load a YAML file and preprocess it with additional options.
+/**
+ * See preprocessYamlFile(path, variables) for details on the preprocessing.
+ */
+estd::result<YAML::Node, estd::error> preprocessYamlFile(
+	std::string const & path,
+	std::map<std::string, std::string> variables,
+	YamlPreprocessOptions const & options
+);
+
+/// Load a YAML file and preprocess it, using a cache for included files.
+/**
+ * See preprocessYamlFile(path, variables) for details on the preprocessing.
+ */
+estd::result<YAML::Node, estd::error> preprocessYamlFile(
+	std::string const & path,
+	std::map<std::string, std::string> variables,
+	YamlIncludeCache & cache
+);
+
+/// Load a YAML document from a buffer and preprocess it.
+/**
+ * The document is read directly from the buffer, without copying it into a std::string first.
+ * Relative include paths are interpreted relative to `base_dir`, which is also available as the "$DIR" variable.
+ * The "$FILE" variable is not available.
+ *
+ * See preprocessYamlFile(path, variables) for details on the preprocessing.
+ * The disk cache in the options is not used, since the document is not a file.
+ */
+estd::result<YAML::Node, estd::error> preprocessYamlBuffer(
+	std::string_view data,
+	std::string const & base_dir,
+	std::map<std::string, std::string> variables,
+	YamlPreprocessOptions const & options = {}
+);
+
+/// Check if a node is a deferred include, created by preprocessing with `lazy_includes` enabled in this process.
+bool isDeferredYamlInclude(YAML::Node const & node);
+
+/// Resolve all deferred includes in a node tree.
+/**
+ * Each deferred include is replaced in place by the preprocessed contents of the included file.
+ * The included files are preprocessed completely, regardless of the `lazy_includes` option.
+ *
+ * The variables should be the same as used for the original preprocessing.
+ * The "$DIR" and "$FILE" variables are set for each included file.
+ */
+estd::result<void, estd::error> resolveYamlIncludes(
+	YAML::Node & node,
+	std::map<std::string, std::string> variables,
+	YamlPreprocessOptions const & options = {}
+);
+
+/// Resolve the deferred includes along a path and return the node at the end of the path.
+/**
+ * The path uses the same syntax as YamlError::formatTrace(), for example `robots[3].tool`.
+ * Only the deferred includes along the path are resolved in place, and then all deferred includes in the selected node.
+ * All other deferred includes are left untouched.
+ *
+ * Files included by the resolved files are preprocessed with the given options,
+ * so with `lazy_includes` enabled they are deferred again.
+ */
+estd::result<YAML::Node, estd::error> resolveYamlPath(
+	YAML::Node & root,
+	std::string_view path,
+	std::map<std::string, std::string> variables,
+	YamlPreprocessOptions const & options = {}
+);
+
 /// Preprocess a YAML node with path information.
 estd::result<void, estd::error> preprocessYamlWithFilePath(YAML::Node & root,
 	std::string const & file,
@@ -0,0 +1,110 @@
+#pragma once
+#include "schema_hash.hpp"
+#include "yaml.hpp"
+#include "yaml_preprocess.hpp"
+
+#include <estd/result.hpp>
+
+#include <yaml-cpp/yaml.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * This header defines utilities to store preprocessed YAML documents as compact binary snapshots.
+ *
+ * Loading a snapshot skips reading and parsing the YAML text and all preprocessing,
+ * which can significantly reduce the start-up time of short-lived processes.
+ */
+
+namespace dr {
+
+/// Write a preprocessed YAML document to a binary snapshot file.
+/**
+ * The snapshot records the schema hash and a hash of the variables used for preprocessing,
+ * the absolute path, modification time and size of each source file,
+ * and the absolute path and entry names of each directory listed by `!include_dir` or `!include_glob`.
+ * readYamlSnapshot() uses these to detect outdated snapshots.
+ *
+ * Writing fails if the document is nested more than 512 levels deep, since reading would reject it.
+ *
+ * The snapshot is first written to a temporary file,
+ * which is then atomically renamed to `path`.
+ */
+estd::result<void, estd::error> writeYamlSnapshot(
+	std::string const & path,
+	YAML::Node const & document,
+	std::uint64_t schema_hash,
+	std::map<std::string, std::string> const & variables,
+	std::vector<std::string> const & sources,
+	std::vector<std::string> const & listed_directories = {}
+);
+
+/// Read a YAML document from a binary snapshot file.
+/**
+ * The file is memory mapped and the document is reconstructed directly from the mapped data.
+ *
+ * Reading fails if the snapshot was written with a different schema hash or different variables,
+ * if any of the source files was modified since the snapshot was written,
+ * or if a file was added to or removed from any of the listed directories.
+ * If `root_source` is not empty, reading also fails unless it is the first source file of the snapshot.
+ * It also fails for corrupt snapshots, including documents nested too deep to read without risking a stack overflow.
+ */
+estd::result<YAML::Node, estd::error> readYamlSnapshot(
+	std::string const & path,
+	std::uint64_t schema_hash,
+	std::map<std::string, std::string> const & variables,
+	std::string const & root_source = {}
+);
+
+/// Preprocess a YAML file, check that it can be parsed as T, and write it to a binary snapshot file.
+/**
+ * This is meant to be run as a build step, so that loadYamlSnapshot<T>() can later load the snapshot.
+ * The snapshot is only written if the document can be parsed as T.
+ */
+template<typename T>
+estd::result<void, estd::error> compileYamlSnapshot(
+	std::string const & yaml_path,
+	std::string const & snapshot_path,
+	std::map<std::string, std::string> const & variables
+) {
+	std::vector<std::string> sources{yaml_path};
+	std::vector<std::string> listed_directories;
+	YamlPreprocessOptions options;
+	options.included_files     = &sources;
+	options.listed_directories = &listed_directories;
+
+	estd::result<YAML::Node, estd::error> document = preprocessYamlFile(yaml_path, variables, options);
+	if (!document) return document.error_unchecked();
+
+	YamlResult<T> parsed = parseYaml<T>(*document);
+	if (!parsed) return estd::error{std::errc::invalid_argument, yaml_path + ": " + parsed.error().format()};
+
+	return writeYamlSnapshot(snapshot_path, *document, param::schemaHash<T>(), variables, sources, listed_directories);
+}
+
+/// Load a T from a binary snapshot, or from the YAML file if the snapshot can not be used.
+/**
+ * The snapshot is used if it exists, was compiled from `yaml_path`, matches the schema of T and the variables,
+ * none of the source files or listed directories changed, and the document can be parsed as T.
+ * Otherwise, the YAML file is preprocessed and parsed as usual.
+ */
+template<typename T>
+YamlResult<T> loadYamlSnapshot(
+	std::string const & snapshot_path,
+	std::string const & yaml_path,
+	std::map<std::string, std::string> const & variables
+) {
+	if (estd::result<YAML::Node, estd::error> snapshot = readYamlSnapshot(snapshot_path, param::schemaHash<T>(), variables, yaml_path)) {
+		YamlResult<T> result = parseYaml<T>(*snapshot);
+		if (result) return result;
+	}
+
+	estd::result<YAML::Node, estd::error> document = preprocessYamlFile(yaml_path, variables);
+	if (!document) return YamlError{document.error().format()};
+	return parseYaml<T>(*document);
+}
+
+}
@@ -0,0 +1,43 @@
+#include "hash.hpp"
+
+namespace dr::param::detail {
+
+namespace {
+	bool is_non_specific_tag(std::string const & tag) {
+		return tag.empty() || tag == "?" || tag == "!";
+	}
+}
+
+void addYamlNodeHash(StableHash & hash, YAML::Node const & node) {
+	hash.add(std::uint64_t(node.Type()));
+	if (!is_non_specific_tag(node.Tag())) hash.add(std::string_view{node.Tag()});
+
+	switch (node.Type()) {
+		case YAML::NodeType::Scalar:
+			hash.add(std::string_view{node.Scalar()});
+			break;
+		case YAML::NodeType::Sequence:
+			hash.add(std::uint64_t(node.size()));
+			for (auto child : node) addYamlNodeHash(hash, child);
+			break;
+		case YAML::NodeType::Map: {
+			// Maps are equal regardless of the order of their entries,
+			// so combine the hashes of the entries with an operation that does not depend on order.
+			std::uint64_t entries = 0;
+			for (auto child : node) {
+				StableHash entry;
+				addYamlNodeHash(entry, child.first);
+				addYamlNodeHash(entry, child.second);
+				entries += entry.value();
+			}
+			hash.add(std::uint64_t(node.size()));
+			hash.add(entries);
+			break;
+		}
+		case YAML::NodeType::Null:
+		case YAML::NodeType::Undefined:
+			break;
+	}
+}
+
+}
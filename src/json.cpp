@@ -0,0 +1,314 @@
+#include "json.hpp"
+
+#include <fmt/format.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+namespace dr {
+
+namespace {
+	/// Maximum nesting depth of arrays and objects, to protect the stack.
+	constexpr int max_json_depth = 512;
+
+	/// Recursive descent parser for JSON, building a YAML node tree.
+	class JsonReader {
+		std::string_view data_;
+		std::size_t position_ = 0;
+		std::optional<YamlError> error_;
+
+		/// Sequence used to create new nodes in the memory of the document.
+		YAML::Node factory_{YAML::NodeType::Sequence};
+
+		// Tags that yaml-cpp gives to JSON nodes.
+		std::string const plain_tag_  = "?";
+		std::string const quoted_tag_ = "!";
+
+	public:
+		explicit JsonReader(std::string_view data) : data_{data} {}
+
+		YamlResult<YAML::Node> read() {
+			YAML::Node root = createNode();
+			if (readValue(root, 0)) {
+				skipWhitespace();
+				if (position_ == data_.size()) return root;
+				fail("unexpected data after the end of the document");
+			}
+			return std::move(*error_);
+		}
+
+	private:
+		/// Create a new node in the memory of the document.
+		/**
+		 * Nodes that are inserted into a map or sequence have their memory merged into the memory of the parent.
+		 * Creating all nodes in the same memory avoids merging subtrees over and over again on every level.
+		 */
+		YAML::Node createNode() {
+			YAML::Node node = factory_[0];
+			factory_.remove(0);
+			return node;
+		}
+
+		bool fail(std::string_view message) {
+			// Only compute the line and column when an error occurs.
+			std::size_t line = 1;
+			std::size_t column = 1;
+			for (std::size_t i = 0; i < position_ && i < data_.size(); ++i) {
+				if (data_[i] == '\n') {
+					++line;
+					column = 1;
+				} else {
+					++column;
+				}
+			}
+			error_ = YamlError{fmt::format("line {}, column {}: {}", line, column, message)};
+			return false;
+		}
+
+		void skipWhitespace() {
+			while (position_ < data_.size()) {
+				char c = data_[position_];
+				if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+				++position_;
+			}
+		}
+
+		bool consume(std::string_view literal) {
+			if (data_.substr(position_, literal.size()) != literal) return false;
+			position_ += literal.size();
+			return true;
+		}
+
+		/// Read a value into an empty node.
+		bool readValue(YAML::Node node, int depth) {
+			skipWhitespace();
+			if (position_ == data_.size()) return fail("unexpected end of document");
+
+			switch (data_[position_]) {
+				case '{': return readObject(node, depth + 1);
+				case '[': return readArray(node, depth + 1);
+				case '"': {
+					std::string value;
+					if (!readString(value)) return false;
+					node = value;
+					node.SetTag(quoted_tag_);
+					return true;
+				}
+				case 't':
+				case 'f':
+					if (consume("true")) node = "true";
+					else if (consume("false")) node = "false";
+					else return fail("invalid literal");
+					node.SetTag(plain_tag_);
+					return true;
+				case 'n':
+					if (!consume("null")) return fail("invalid literal");
+					// Setting the tag turns the empty node into a null node.
+					node.SetTag("");
+					return true;
+				default:
+					return readNumber(node);
+			}
+		}
+
+		bool readObject(YAML::Node node, int depth) {
+			if (depth > max_json_depth) return fail("nesting too deep");
+			++position_;
+
+			skipWhitespace();
+			if (consume("}")) {
+				node = YAML::Node(YAML::NodeType::Map);
+			} else {
+				while (true) {
+					skipWhitespace();
+					if (position_ == data_.size() || data_[position_] != '"') return fail("expected string as object key");
+					std::string key_value;
+					if (!readString(key_value)) return false;
+					YAML::Node key = createNode();
+					key = key_value;
+					key.SetTag(quoted_tag_);
+
+					skipWhitespace();
+					if (!consume(":")) return fail("expected `:' after object key");
+
+					YAML::Node value = createNode();
+					if (!readValue(value, depth)) return false;
+
+					// Insert without looking for an existing key, which is linear in the size of the map.
+					node.force_insert(key, value);
+
+					skipWhitespace();
+					if (consume(",")) continue;
+					if (consume("}")) break;
+					return fail("expected `,' or `}' in object");
+				}
+			}
+
+			node.SetTag(plain_tag_);
+			node.SetStyle(YAML::EmitterStyle::Flow);
+			return true;
+		}
+
+		bool readArray(YAML::Node node, int depth) {
+			if (depth > max_json_depth) return fail("nesting too deep");
+			++position_;
+
+			skipWhitespace();
+			if (consume("]")) {
+				node = YAML::Node(YAML::NodeType::Sequence);
+			} else {
+				for (std::size_t index = 0; true; ++index) {
+					// Indexing one past the end appends a new element in the memory of the sequence.
+					if (!readValue(node[index], depth)) return false;
+
+					skipWhitespace();
+					if (consume(",")) continue;
+					if (consume("]")) break;
+					return fail("expected `,' or `]' in array");
+				}
+			}
+
+			node.SetTag(plain_tag_);
+			node.SetStyle(YAML::EmitterStyle::Flow);
+			return true;
+		}
+
+		bool readNumber(YAML::Node node) {
+			// Validate the JSON number grammar, but keep the original text as scalar.
+			std::size_t start = position_;
+			auto digits = [&] {
+				std::size_t begin = position_;
+				while (position_ < data_.size() && data_[position_] >= '0' && data_[position_] <= '9') ++position_;
+				return position_ - begin;
+			};
+
+			if (position_ < data_.size() && data_[position_] == '-') ++position_;
+			std::size_t integer_start = position_;
+			std::size_t integer_digits = digits();
+			if (integer_digits == 0) return fail("invalid value");
+			if (integer_digits > 1 && data_[integer_start] == '0') {
+				position_ = integer_start;
+				return fail("invalid number: leading zero");
+			}
+			if (position_ < data_.size() && data_[position_] == '.') {
+				++position_;
+				if (digits() == 0) return fail("invalid number: expected digits after decimal point");
+			}
+			if (position_ < data_.size() && (data_[position_] == 'e' || data_[position_] == 'E')) {
+				++position_;
+				if (position_ < data_.size() && (data_[position_] == '+' || data_[position_] == '-')) ++position_;
+				if (digits() == 0) return fail("invalid number: expected digits in exponent");
+			}
+
+			node = std::string{data_.substr(start, position_ - start)};
+			node.SetTag(plain_tag_);
+			return true;
+		}
+
+		bool readHex4(std::uint32_t & value) {
+			if (data_.size() - position_ < 4) return fail("invalid unicode escape");
+			value = 0;
+			for (int i = 0; i < 4; ++i) {
+				char c = data_[position_++];
+				value <<= 4;
+				if (c >= '0' && c <= '9') value |= c - '0';
+				else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+				else return fail("invalid unicode escape");
+			}
+			return true;
+		}
+
+		static void appendUtf8(std::string & output, std::uint32_t code_point) {
+			if (code_point < 0x80) {
+				output += char(code_point);
+			} else if (code_point < 0x800) {
+				output += char(0xC0 | (code_point >> 6));
+				output += char(0x80 | (code_point & 0x3F));
+			} else if (code_point < 0x10000) {
+				output += char(0xE0 | (code_point >> 12));
+				output += char(0x80 | ((code_point >> 6) & 0x3F));
+				output += char(0x80 | (code_point & 0x3F));
+			} else {
+				output += char(0xF0 | (code_point >> 18));
+				output += char(0x80 | ((code_point >> 12) & 0x3F));
+				output += char(0x80 | ((code_point >> 6) & 0x3F));
+				output += char(0x80 | (code_point & 0x3F));
+			}
+		}
+
+		bool readString(std::string & output) {
+			++position_;
+			while (true) {
+				// Copy runs of characters without escapes at once.
+				std::size_t end = data_.find_first_of("\"\\", position_);
+				if (end == std::string_view::npos) {
+					position_ = data_.size();
+					return fail("unterminated string");
+				}
+				for (std::size_t i = position_; i < end; ++i) {
+					if (static_cast<unsigned char>(data_[i]) < 0x20) {
+						position_ = i;
+						return fail("control character in string");
+					}
+				}
+				output.append(data_.data() + position_, end - position_);
+				position_ = end + 1;
+				if (data_[end] == '"') return true;
+
+				if (position_ == data_.size()) return fail("unterminated string");
+				char escape = data_[position_++];
+				switch (escape) {
+					case '"':  output += '"';  break;
+					case '\\': output += '\\'; break;
+					case '/':  output += '/';  break;
+					case 'b':  output += '\b'; break;
+					case 'f':  output += '\f'; break;
+					case 'n':  output += '\n'; break;
+					case 'r':  output += '\r'; break;
+					case 't':  output += '\t'; break;
+					case 'u': {
+						std::uint32_t code_point = 0;
+						if (!readHex4(code_point)) return false;
+						// Combine surrogate pairs into a single code point.
+						if (code_point >= 0xD800 && code_point < 0xDC00) {
+							std::uint32_t low = 0;
+							if (!consume("\\u") || !readHex4(low) || low < 0xDC00 || low >= 0xE000) return fail("invalid surrogate pair");
+							code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+						} else if (code_point >= 0xDC00 && code_point < 0xE000) {
+							// A low surrogate without a preceding high surrogate does not encode a code point.
+							return fail("invalid surrogate pair");
+						}
+						appendUtf8(output, code_point);
+						break;
+					}
+					default:
+						--position_;
+						return fail("invalid escape sequence");
+				}
+			}
+		}
+	};
+}
+
+YamlResult<YAML::Node> loadJson(std::string_view data) {
+	return JsonReader{data}.read();
+}
+
+estd::result<YAML::Node, estd::error> readJsonFile(std::string const & path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good()) {
+		int error = errno;
+		return estd::error{{error, std::system_category()}, path};
+	}
+	std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+	YamlResult<YAML::Node> node = loadJson(data);
+	if (!node) return estd::error{std::errc::invalid_argument, path + ": " + node.error().format()};
+	return *node;
+}
+
+}
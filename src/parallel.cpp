@@ -0,0 +1,129 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dr::param {
+
+namespace {
+	/// The range of indices still owned by a worker.
+	struct WorkRange {
+		std::mutex mutex;
+		std::size_t begin = 0;
+		std::size_t end   = 0;
+
+		/// Take the next index from the front of the range.
+		bool pop(std::size_t & index) {
+			std::lock_guard<std::mutex> lock{mutex};
+			if (begin == end) return false;
+			index = begin++;
+			return true;
+		}
+
+		/// Steal the back half of the range.
+		bool steal(std::size_t & steal_begin, std::size_t & steal_end) {
+			std::lock_guard<std::mutex> lock{mutex};
+			std::size_t remaining = end - begin;
+			if (remaining == 0) return false;
+			steal_end   = end;
+			steal_begin = end - (remaining + 1) / 2;
+			end = steal_begin;
+			return true;
+		}
+
+		/// Replace the range with a new one.
+		void assign(std::size_t new_begin, std::size_t new_end) {
+			std::lock_guard<std::mutex> lock{mutex};
+			begin = new_begin;
+			end   = new_end;
+		}
+	};
+
+	/// True while the calling thread runs a worker of parallelFor().
+	thread_local bool in_worker = false;
+
+	/// Mark the calling thread as worker for the lifetime of the guard.
+	class WorkerGuard {
+		bool previous_;
+
+	public:
+		WorkerGuard() : previous_{in_worker} {
+			in_worker = true;
+		}
+
+		WorkerGuard(WorkerGuard const &) = delete;
+		WorkerGuard & operator=(WorkerGuard const &) = delete;
+
+		~WorkerGuard() {
+			in_worker = previous_;
+		}
+	};
+
+	void runWorker(std::size_t self, std::vector<std::unique_ptr<WorkRange>> & ranges, std::function<void(std::size_t)> const & task) {
+		WorkerGuard guard;
+		WorkRange & own = *ranges[self];
+		while (true) {
+			std::size_t index;
+			while (own.pop(index)) task(index);
+
+			// Out of work, try to steal from the other workers.
+			bool stolen = false;
+			for (std::size_t offset = 1; offset < ranges.size() && !stolen; ++offset) {
+				std::size_t begin;
+				std::size_t end;
+				if (ranges[(self + offset) % ranges.size()]->steal(begin, end)) {
+					own.assign(begin, end);
+					stolen = true;
+				}
+			}
+
+			// Work is never added, so if there is nothing to steal, we're done.
+			if (!stolen) return;
+		}
+	}
+}
+
+std::size_t defaultThreadCount() {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void parallelFor(std::size_t count, std::function<void(std::size_t index)> const & task, std::size_t threads) {
+	if (threads == 0) threads = defaultThreadCount();
+	threads = std::min(threads, count);
+
+	// Nested calls from a task run serially, so nesting does not multiply the number of threads.
+	if (in_worker) threads = 1;
+
+	if (threads <= 1) {
+		for (std::size_t i = 0; i < count; ++i) task(i);
+		return;
+	}
+
+	std::vector<std::unique_ptr<WorkRange>> ranges;
+	ranges.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i) {
+		ranges.push_back(std::make_unique<WorkRange>());
+		ranges.back()->begin = count * i / threads;
+		ranges.back()->end   = count * (i + 1) / threads;
+	}
+
+	// The calling thread acts as the first worker.
+	// If a thread can not be started, the running workers steal its share of the indices,
+	// and the threads that did start are still joined below.
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (std::size_t i = 1; i < threads; ++i) {
+		try {
+			workers.emplace_back([&ranges, &task, i] { runWorker(i, ranges, task); });
+		} catch (...) {
+			break;
+		}
+	}
+	runWorker(0, ranges, task);
+	for (std::thread & worker : workers) worker.join();
+}
+
+}
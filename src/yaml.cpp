@@ -1,47 +1,125 @@
 #include "yaml.hpp"
+#include "json.hpp"
 #include "yaml_macros.hpp"
 
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <array>
 #include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
+#include <limits>
 #include <sstream>
 
 namespace dr {
 
 using namespace std::string_literals;
 
+namespace detail {
+	/// A frame of the trace of a YamlError.
+	struct YamlTraceFrame {
+		/// The description of the node, without name if it is a sequence element.
+		YamlNodeDescription description;
+
+		/// The index of the node in the parent sequence, or npos if the frame has a name.
+		std::size_t index;
+
+		/// Get the name of the node.
+		std::string name() const {
+			if (index == std::string::npos) return description.name;
+			return std::to_string(index);
+		}
+	};
+
+	struct YamlErrorData {
+		/// A human readable description of the error.
+		std::string message;
+
+		/// The trace from the node that caused the error to the root node.
+		std::vector<YamlTraceFrame> trace;
+	};
+}
+
+namespace {
+	std::string const empty_message;
+}
+
 YamlError::YamlError(std::string message, std::vector<YamlNodeDescription> trace) :
-	message{std::move(message)},
-	trace{std::move(trace)} {}
+	data_{new detail::YamlErrorData{std::move(message), {}}}
+{
+	data_->trace.reserve(trace.size());
+	for (YamlNodeDescription & description : trace) data_->trace.push_back({std::move(description), std::string::npos});
+}
+
+YamlError::YamlError(YamlError const & other) :
+	data_{other.data_ ? new detail::YamlErrorData{*other.data_} : nullptr} {}
+
+YamlError::YamlError(YamlError && other) noexcept = default;
+
+YamlError & YamlError::operator=(YamlError const & other) {
+	if (this != &other) data_.reset(other.data_ ? new detail::YamlErrorData{*other.data_} : nullptr);
+	return *this;
+}
+
+YamlError & YamlError::operator=(YamlError && other) noexcept = default;
+
+YamlError::~YamlError() = default;
+
+std::string const & YamlError::message() const {
+	if (!data_) return empty_message;
+	return data_->message;
+}
+
+std::vector<YamlNodeDescription> YamlError::trace() const {
+	std::vector<YamlNodeDescription> result;
+	if (!data_) return result;
+	result.reserve(data_->trace.size());
+	for (detail::YamlTraceFrame const & frame : data_->trace) {
+		result.push_back({frame.name(), frame.description.user_type, frame.description.node_type});
+	}
+	return result;
+}
 
 YamlError & YamlError::appendTrace(YamlNodeDescription description) & {
-	trace.push_back(std::move(description));
+	if (!data_) data_.reset(new detail::YamlErrorData{});
+	data_->trace.push_back({std::move(description), std::string::npos});
 	return *this;
 }
 
 YamlError && YamlError::appendTrace(YamlNodeDescription description) && {
-	trace.push_back(std::move(description));
-	return std::move(*this);
+	return std::move(appendTrace(std::move(description)));
+}
+
+YamlError & YamlError::appendTrace(std::size_t index, YAML::NodeType::value node_type) & {
+	if (!data_) data_.reset(new detail::YamlErrorData{});
+	data_->trace.push_back({{"", "", node_type}, index});
+	return *this;
+}
+
+YamlError && YamlError::appendTrace(std::size_t index, YAML::NodeType::value node_type) && {
+	return std::move(appendTrace(index, node_type));
 }
 
 std::string YamlError::formatTrace() const {
-	if (trace.empty()) return "";
+	if (!data_ || data_->trace.empty()) return "";
+	std::vector<detail::YamlTraceFrame> const & trace = data_->trace;
 
-	std::string result = trace.back().name;
+	std::string result = trace.back().name();
 
 	for (auto i = trace.rbegin(); i != trace.rend(); ++i) {
 		// Skip the first node (already dealt with it).
 		if (i == trace.rbegin()) continue;
 		auto prev = i - 1;
-		if (prev->node_type == YAML::NodeType::Sequence) {
+		if (prev->description.node_type == YAML::NodeType::Sequence) {
 			result.push_back('[');
-			result.append(i->name);
+			result.append(i->name());
 			result.push_back(']');
 		} else {
 			result.push_back('.');
-			result.append(i->name);
+			result.append(i->name());
 		}
 	}
 
@@ -49,8 +127,66 @@ std::string YamlError::formatTrace() const {
 }
 
 std::string YamlError::format() const {
-	if (trace.empty()) return message;
-	return formatTrace() + ": " + message;
+	if (!data_ || data_->trace.empty()) return message();
+	return formatTrace() + ": " + data_->message;
+}
+
+namespace detail {
+	YamlError YamlDecodeBudget::exceeded() const {
+		if (nodes > limits.max_nodes) return YamlError{fmt::format("decoding limit exceeded: more than {} nodes", limits.max_nodes)};
+		auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(limits.max_decode_time).count();
+		return YamlError{fmt::format("decoding limit exceeded: took more than {} ms", milliseconds)};
+	}
+
+	YamlError YamlDecodeBudget::tooLong(std::size_t length) const {
+		return YamlError{fmt::format("decoding limit exceeded: {} elements, but at most {} are allowed", length, limits.max_sequence_length)};
+	}
+}
+
+namespace detail {
+	YamlAliasMemo::YamlAliasMemo(YAML::Node const & root) : root_{root} {
+		std::unordered_set<void const *> seen;
+		std::vector<YAML::Node> nodes{root};
+		while (!nodes.empty()) {
+			YAML::Node node = nodes.back();
+			nodes.pop_back();
+			if (!node.IsMap() && !node.IsSequence()) continue;
+
+			// Do not descend into a node twice, the children of an aliased node are seen through the first path.
+			void const * identity = yamlNodeIdentity(node);
+			if (!seen.insert(identity).second) {
+				aliased_.insert(identity);
+				continue;
+			}
+
+			if (node.IsMap())      for (auto child : node) nodes.push_back(child.second);
+			if (node.IsSequence()) for (auto child : node) nodes.push_back(child);
+		}
+	}
+
+	void const * YamlAliasMemo::aliasedIdentity(YAML::Node const & node) const {
+		if (aliased_.empty() || (!node.IsMap() && !node.IsSequence())) return nullptr;
+		void const * identity = yamlNodeIdentity(node);
+		return aliased_.count(identity) ? identity : nullptr;
+	}
+}
+
+YamlAliasScope::YamlAliasScope(YAML::Node const & root) : memo_{root}, previous_{detail::current_yaml_alias_memo} {
+	detail::current_yaml_alias_memo = &memo_;
+}
+
+YamlAliasScope::~YamlAliasScope() {
+	detail::current_yaml_alias_memo = previous_;
+}
+
+YamlLimitsScope::YamlLimitsScope(YamlLimits const & limits) : budget_{limits, 0, std::chrono::steady_clock::time_point::max()}, previous_{detail::current_yaml_decode_budget} {
+	auto now = std::chrono::steady_clock::now();
+	if (limits.max_decode_time < std::chrono::steady_clock::time_point::max() - now) budget_.deadline = now + limits.max_decode_time;
+	detail::current_yaml_decode_budget = &budget_;
+}
+
+YamlLimitsScope::~YamlLimitsScope() {
+	detail::current_yaml_decode_budget = previous_;
 }
 
 std::string toString(YAML::NodeType::value type) {
@@ -94,7 +230,34 @@ std::optional<YamlError> expectScalar(YAML::Node const & node) {
 	return YamlError{fmt::format("invalid node type: expected scalar, got {}", toString(node.Type()))};
 }
 
+namespace detail {
+	std::optional<std::string_view> yamlTagName(YAML::Node const & node) {
+		std::string const & tag = node.Tag();
+		if (tag.empty() || tag == "?" || tag == "!") return std::nullopt;
+		std::string_view name = tag;
+		if (name.front() == '!') name.remove_prefix(1);
+		return name;
+	}
+
+	YamlError unresolvedYamlInclude(std::string_view path) {
+		return YamlError{"unresolved deferred include of `" + std::string{path} + "', resolve it with resolveYamlPath() or resolveYamlIncludes() first"};
+	}
+
+	YAML::Node removeYamlKey(YAML::Node const & node, std::string_view key) {
+		YAML::Node result{YAML::NodeType::Map};
+		for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
+			if (i->first.IsScalar() && i->first.Scalar() == key) continue;
+			result.force_insert(i->first, i->second);
+		}
+		return result;
+	}
+}
+
 estd::result<YAML::Node, estd::error> readYamlFile(std::string const & path) {
+	// JSON is a subset of YAML, but the JSON reader is much faster.
+	std::string_view extension = ".json";
+	if (path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0) return readJsonFile(path);
+
 	std::ifstream file(path);
 	if (!file.good()) {
 		int error = errno;
@@ -130,6 +293,83 @@ YamlResult<void> mergeYamlNodes(YAML::Node & map_a, YAML::Node map_b) {
 	return estd::in_place_valid;
 }
 
+namespace {
+	bool is_non_specific_tag(std::string const & tag) {
+		return tag.empty() || tag == "?" || tag == "!";
+	}
+
+	/// Compare the entries of two maps with the same size, regardless of their order.
+	bool yaml_map_entries_equal(YAML::Node const & a, YAML::Node const & b) {
+		// Maps are usually written in the same order, so first compare the entries pairwise.
+		YAML::const_iterator i = a.begin();
+		YAML::const_iterator j = b.begin();
+		for (; i != a.end() && yamlEqual(i->first, j->first); ++i, ++j) {
+			if (!yamlEqual(i->second, j->second)) return false;
+		}
+		if (i == a.end()) return true;
+
+		// Sort the remaining entries by key, rather than searching for each key.
+		// Sort pointers to the entries, since assigning a YAML::Node assigns to the node it refers to.
+		using Entry = std::pair<YAML::Node, YAML::Node>;
+		auto collect = [] (YAML::const_iterator begin, YAML::const_iterator end, std::vector<Entry> & entries, std::vector<Entry const *> & sorted) {
+			for (; begin != end; ++begin) {
+				if (!begin->first.IsScalar()) return false;
+				entries.emplace_back(begin->first, begin->second);
+			}
+			for (Entry const & entry : entries) sorted.push_back(&entry);
+			std::stable_sort(sorted.begin(), sorted.end(), [] (Entry const * x, Entry const * y) {
+				return x->first.Scalar() < y->first.Scalar();
+			});
+			return true;
+		};
+
+		std::vector<Entry> entries_a;
+		std::vector<Entry> entries_b;
+		std::vector<Entry const *> sorted_a;
+		std::vector<Entry const *> sorted_b;
+		if (collect(i, a.end(), entries_a, sorted_a) && collect(j, b.end(), entries_b, sorted_b)) {
+			for (std::size_t k = 0; k < sorted_a.size(); ++k) {
+				if (!yamlEqual(sorted_a[k]->first, sorted_b[k]->first)) return false;
+				if (!yamlEqual(sorted_a[k]->second, sorted_b[k]->second)) return false;
+			}
+			return true;
+		}
+
+		// Keys that are not scalars have no order, so search for them instead.
+		for (; i != a.end(); ++i) {
+			auto found = std::find_if(b.begin(), b.end(), [&] (auto const & entry_b) {
+				return yamlEqual(i->first, entry_b.first);
+			});
+			if (found == b.end() || !yamlEqual(i->second, found->second)) return false;
+		}
+		return true;
+	}
+}
+
+bool yamlEqual(YAML::Node const & a, YAML::Node const & b) {
+	if (a.is(b)) return true;
+	if (a.Type() != b.Type()) return false;
+	if (a.Tag() != b.Tag() && !(is_non_specific_tag(a.Tag()) && is_non_specific_tag(b.Tag()))) return false;
+
+	switch (a.Type()) {
+		case YAML::NodeType::Scalar:
+			return a.Scalar() == b.Scalar();
+		case YAML::NodeType::Sequence:
+			if (a.size() != b.size()) return false;
+			for (std::size_t i = 0; i < a.size(); ++i) {
+				if (!yamlEqual(a[i], b[i])) return false;
+			}
+			return true;
+		case YAML::NodeType::Map:
+			if (a.size() != b.size()) return false;
+			return yaml_map_entries_equal(a, b);
+		case YAML::NodeType::Null:
+		case YAML::NodeType::Undefined:
+			return true;
+	}
+	return false;
+}
+
 
 }
 
@@ -139,71 +379,133 @@ using namespace dr;
 namespace {
 
 	template<typename T>
-	YamlResult<T> convert_signed_integral(YAML::Node const & node) {
-		if (auto error = expectScalar(node)) return *error;
-
-		std::string const & raw = node.Scalar();
-		std::size_t parsed = 0;
-		long long value = 0;
-		try {
-			value = std::stoll(raw, &parsed);
-		} catch (std::invalid_argument &e) {
-			return YamlError{"invalid integer value: " + raw};
-		} catch (std::range_error const & e) {
-			return YamlError{"integer value out of range: " + raw};
-		}
+	YamlResult<T> convert_signed_integral(std::string_view raw) {
+		char * end = nullptr;
+		errno = 0;
+		long long value = std::strtoll(raw.data(), &end, 10);
+
+		if (end == raw.data() || end != raw.data() + raw.size()) return YamlError{"invalid integer value: " + std::string{raw}};
+		if (errno == ERANGE) return YamlError{"integer value out of range: " + std::string{raw}};
+		if (value > std::numeric_limits<T>::max())    return YamlError{"integer value out of range: " + std::string{raw}};
+		if (value < std::numeric_limits<T>::lowest()) return YamlError{"integer value out of range: " + std::string{raw}};
+		return T(value);
+	}
 
-		if (parsed != raw.size()) return YamlError{"invalid integer value: " + raw};
-		if (value > std::numeric_limits<T>::max())    YamlError{"integer value out of range: " + raw};
-		if (value < std::numeric_limits<T>::lowest()) YamlError{"integer value out of range: " + raw};
+	template<typename T>
+	YamlResult<T> convert_unsigned_integral(std::string_view raw) {
+		char * end = nullptr;
+		errno = 0;
+		unsigned long long value = std::strtoull(raw.data(), &end, 10);
+
+		if (end == raw.data() || end != raw.data() + raw.size()) return YamlError{"invalid integer value: " + std::string{raw}};
+		if (errno == ERANGE) return YamlError{"integer value out of range: " + std::string{raw}};
+		// std::strtoull accepts and negates negative values.
+		if (raw.find('-') != std::string_view::npos) return YamlError{"integer value out of range: " + std::string{raw}};
+		if (value > std::numeric_limits<T>::max()) return YamlError{"integer value out of range: " + std::string{raw}};
 		return T(value);
 	}
 
+	float       parse_floating_point(char const * data, char * * end, float       *) { return std::strtof(data, end); }
+	double      parse_floating_point(char const * data, char * * end, double      *) { return std::strtod(data, end); }
+	long double parse_floating_point(char const * data, char * * end, long double *) { return std::strtold(data, end); }
+
+	/// Parse the YAML spelling of infinity and NaN.
 	template<typename T>
-	YamlResult<T> convert_unsigned_integral(YAML::Node const & node) {
-		if (auto error = expectScalar(node)) return *error;
-
-		std::string const & raw = node.Scalar();
-		std::size_t parsed = 0;
-		unsigned long long value = 0;
-		try {
-			value = std::stoull(raw, &parsed);
-		} catch (std::invalid_argument &e) {
-			return YamlError{"invalid integer value: " + raw};
-		} catch (std::range_error const & e) {
-			return YamlError{"integer value out of range: " + raw};
+	std::optional<T> parse_special_floating_point(std::string_view raw) {
+		std::string_view value = raw;
+		bool negative = false;
+		if (!value.empty() && (value.front() == '-' || value.front() == '+')) {
+			negative = value.front() == '-';
+			value.remove_prefix(1);
+		}
+		if (value == ".inf" || value == ".Inf" || value == ".INF") {
+			return negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
 		}
+		if (raw == ".nan" || raw == ".NaN" || raw == ".NAN") return std::numeric_limits<T>::quiet_NaN();
+		return std::nullopt;
+	}
 
-		if (parsed != raw.size()) return YamlError{"invalid integer value: " + raw};
-		if (value > std::numeric_limits<T>::max())    YamlError{"integer value out of range: " + raw};
-		if (value < std::numeric_limits<T>::lowest()) YamlError{"integer value out of range: " + raw};
-		return T(value);
+	template<typename T>
+	YamlResult<T> convert_floating_point(std::string_view raw) {
+		if (std::optional<T> special = parse_special_floating_point<T>(raw)) return *special;
+
+		// Parse directly as T rather than through a wider type,
+		// to avoid double rounding and to guarantee that encoded values round trip exactly.
+		char * end = nullptr;
+		errno = 0;
+		T value = parse_floating_point(raw.data(), &end, static_cast<T *>(nullptr));
+
+		if (end == raw.data() || end != raw.data() + raw.size()) return YamlError{"invalid floating point value: " + std::string{raw}};
+		if (errno == ERANGE && std::isinf(value)) return YamlError{"floating point value out of range: " + std::string{raw}};
+		return value;
 	}
 
+	/// Encode an integer as a YAML scalar.
 	template<typename T>
-	YamlResult<T> convert_floating_point(YAML::Node const & node) {
-		if (auto error = expectScalar(node)) return *error;
-
-		std::string const & raw = node.Scalar();
-		std::size_t parsed = 0;
-		long double value = 0;
-		try {
-			value = std::stold(raw, &parsed);
-		} catch (std::invalid_argument &e) {
-			return YamlError{"invalid floating point value: " + raw};
-		} catch (std::range_error const & e) {
-			return YamlError{"floating point value out of range: " + raw};
-		}
+	YAML::Node encode_integral(T value) {
+		std::array<char, std::numeric_limits<T>::digits10 + 3> buffer;
+		std::to_chars_result result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+		return YAML::Node(std::string(buffer.data(), result.ptr));
+	}
 
-		if (parsed != raw.size()) return YamlError{"invalid floating point value: " + raw};
-		return T(value);
+	/// Encode a floating point value as a YAML scalar.
+	/**
+	 * The value is formatted as the shortest string that parses back to exactly the same value.
+	 * Infinity and NaN use the YAML spelling.
+	 */
+	template<typename T>
+	YAML::Node encode_floating_point(T value) {
+		if (std::isnan(value)) return YAML::Node(".nan");
+		if (std::isinf(value)) return YAML::Node(value < 0 ? "-.inf" : ".inf");
+
+		std::array<char, 64> buffer;
+		std::to_chars_result result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+		return YAML::Node(std::string(buffer.data(), result.ptr));
 	}
 
 }
 
+namespace dr::detail {
+	template<> YamlResult<std::string> parseYamlScalar<std::string>(std::string_view raw) { return std::string{raw}; }
+	template<> YamlResult<std::string_view> parseYamlScalar<std::string_view>(std::string_view raw) { return raw; }
+
+	template<> YamlResult<bool> parseYamlScalar<bool>(std::string_view raw) {
+		std::string lower{raw};
+		std::transform(lower.begin(), lower.end(), lower.begin(), [] (char c) { return std::tolower(c); });
+
+		if (lower == "y" || lower == "yes" || lower == "true"  || lower == "on"  || lower == "1") return true;
+		if (lower == "n" || lower == "no"  || lower == "false" || lower == "off" || lower == "0") return false;
+		return dr::YamlError{"invalid boolean value: " + std::string{raw}};
+	}
+
+	template<> YamlResult<char     > parseYamlScalar<char     >(std::string_view raw) { return convert_signed_integral<char     >(raw); }
+	template<> YamlResult<short    > parseYamlScalar<short    >(std::string_view raw) { return convert_signed_integral<short    >(raw); }
+	template<> YamlResult<int      > parseYamlScalar<int      >(std::string_view raw) { return convert_signed_integral<int      >(raw); }
+	template<> YamlResult<long     > parseYamlScalar<long     >(std::string_view raw) { return convert_signed_integral<long     >(raw); }
+	template<> YamlResult<long long> parseYamlScalar<long long>(std::string_view raw) { return convert_signed_integral<long long>(raw); }
+
+	template<> YamlResult<unsigned char     > parseYamlScalar<unsigned char     >(std::string_view raw) { return convert_unsigned_integral<unsigned char     >(raw); }
+	template<> YamlResult<unsigned short    > parseYamlScalar<unsigned short    >(std::string_view raw) { return convert_unsigned_integral<unsigned short    >(raw); }
+	template<> YamlResult<unsigned int      > parseYamlScalar<unsigned int      >(std::string_view raw) { return convert_unsigned_integral<unsigned int      >(raw); }
+	template<> YamlResult<unsigned long     > parseYamlScalar<unsigned long     >(std::string_view raw) { return convert_unsigned_integral<unsigned long     >(raw); }
+	template<> YamlResult<unsigned long long> parseYamlScalar<unsigned long long>(std::string_view raw) { return convert_unsigned_integral<unsigned long long>(raw); }
+
+	template<> YamlResult<float      > parseYamlScalar<float      >(std::string_view raw) { return convert_floating_point<float      >(raw); }
+	template<> YamlResult<double     > parseYamlScalar<double     >(std::string_view raw) { return convert_floating_point<double     >(raw); }
+	template<> YamlResult<long double> parseYamlScalar<long double>(std::string_view raw) { return convert_floating_point<long double>(raw); }
+}
+
+namespace {
+	/// Decode a scalar node with dr::detail::parseYamlScalar().
+	template<typename T>
+	YamlResult<T> convert_scalar(YAML::Node const & node) {
+		if (auto error = expectScalar(node)) return std::move(*error);
+		return detail::parseYamlScalar<T>(node.Scalar());
+	}
+}
+
 DR_PARAM_DEFINE_YAML_DECODE(std::string, node) {
-	if (auto error = expectScalar(node)) return *error;
-	return node.Scalar();
+	return convert_scalar<std::string>(node);
 }
 
 DR_PARAM_DEFINE_YAML_ENCODE(std::string, value) {
@@ -211,8 +513,7 @@ DR_PARAM_DEFINE_YAML_ENCODE(std::string, value) {
 }
 
 DR_PARAM_DEFINE_YAML_DECODE(std::string_view, node) {
-	if (auto error = expectScalar(node)) return *error;
-	return std::string_view{node.Scalar()};
+	return convert_scalar<std::string_view>(node);
 }
 
 DR_PARAM_DEFINE_YAML_ENCODE(std::string_view, value) {
@@ -220,50 +521,43 @@ DR_PARAM_DEFINE_YAML_ENCODE(std::string_view, value) {
 }
 
 DR_PARAM_DEFINE_YAML_DECODE(bool, node) {
-	if (auto error = expectScalar(node)) return *error;
-
-	std::string raw = node.Scalar();
-	std::transform(raw.begin(), raw.end(), raw.begin(), [] (char c) { return std::tolower(c); });
-
-	if (raw == "y" || raw == "yes" || raw == "true"  || raw == "on"  || raw == "1") return true;
-	if (raw == "n" || raw == "no"  || raw == "false" || raw == "off" || raw == "0") return false;
-	return dr::YamlError{"invalid boolean value: " + node.Scalar()};
+	return convert_scalar<bool>(node);
 }
 
 YAML::Node estd::conversion<bool, YAML::Node>::perform(bool value) { return YAML::Node(value); }
 
-DR_PARAM_DEFINE_YAML_DECODE(char     , node) { return convert_signed_integral<char     >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(short    , node) { return convert_signed_integral<short    >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(int      , node) { return convert_signed_integral<int      >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(long     , node) { return convert_signed_integral<long     >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(long long, node) { return convert_signed_integral<long long>(node); }
+DR_PARAM_DEFINE_YAML_DECODE(char     , node) { return convert_scalar<char     >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(short    , node) { return convert_scalar<short    >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(int      , node) { return convert_scalar<int      >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(long     , node) { return convert_scalar<long     >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(long long, node) { return convert_scalar<long long>(node); }
 
-DR_PARAM_DEFINE_YAML_DECODE(unsigned char     , node) { return convert_unsigned_integral<unsigned char     >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(unsigned short    , node) { return convert_unsigned_integral<unsigned short    >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(unsigned int      , node) { return convert_unsigned_integral<unsigned int      >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(unsigned long     , node) { return convert_unsigned_integral<unsigned long     >(node); }
-DR_PARAM_DEFINE_YAML_DECODE(unsigned long long, node) { return convert_unsigned_integral<unsigned long long>(node); }
+DR_PARAM_DEFINE_YAML_DECODE(unsigned char     , node) { return convert_scalar<unsigned char     >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(unsigned short    , node) { return convert_scalar<unsigned short    >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(unsigned int      , node) { return convert_scalar<unsigned int      >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(unsigned long     , node) { return convert_scalar<unsigned long     >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(unsigned long long, node) { return convert_scalar<unsigned long long>(node); }
 
-DR_PARAM_DEFINE_YAML_DECODE(float      , node) { return convert_floating_point<float>      (node); }
-DR_PARAM_DEFINE_YAML_DECODE(double     , node) { return convert_floating_point<double>     (node); }
-DR_PARAM_DEFINE_YAML_DECODE(long double, node) { return convert_floating_point<long double>(node); }
+DR_PARAM_DEFINE_YAML_DECODE(float      , node) { return convert_scalar<float      >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(double     , node) { return convert_scalar<double     >(node); }
+DR_PARAM_DEFINE_YAML_DECODE(long double, node) { return convert_scalar<long double>(node); }
 
 DR_PARAM_DEFINE_YAML_DECODE(YAML::Node, node) { return node; }
 
-YAML::Node estd::conversion<char,      YAML::Node>::perform(char      value) { return YAML::Node(value); }
-YAML::Node estd::conversion<short,     YAML::Node>::perform(short     value) { return YAML::Node(value); }
-YAML::Node estd::conversion<int,       YAML::Node>::perform(int       value) { return YAML::Node(value); }
-YAML::Node estd::conversion<long,      YAML::Node>::perform(long      value) { return YAML::Node(value); }
-YAML::Node estd::conversion<long long, YAML::Node>::perform(long long value) { return YAML::Node(value); }
-
-YAML::Node estd::conversion<unsigned char,      YAML::Node>::perform(unsigned char      value) { return YAML::Node(value); }
-YAML::Node estd::conversion<unsigned short,     YAML::Node>::perform(unsigned short     value) { return YAML::Node(value); }
-YAML::Node estd::conversion<unsigned int,       YAML::Node>::perform(unsigned int       value) { return YAML::Node(value); }
-YAML::Node estd::conversion<unsigned long,      YAML::Node>::perform(unsigned long      value) { return YAML::Node(value); }
-YAML::Node estd::conversion<unsigned long long, YAML::Node>::perform(unsigned long long value) { return YAML::Node(value); }
-
-YAML::Node estd::conversion<float,       YAML::Node>::perform(float       value) { return YAML::Node(value); }
-YAML::Node estd::conversion<double,      YAML::Node>::perform(double      value) { return YAML::Node(value); }
-YAML::Node estd::conversion<long double, YAML::Node>::perform(long double value) { return YAML::Node(value); }
+YAML::Node estd::conversion<char,      YAML::Node>::perform(char      value) { return encode_integral(value); }
+YAML::Node estd::conversion<short,     YAML::Node>::perform(short     value) { return encode_integral(value); }
+YAML::Node estd::conversion<int,       YAML::Node>::perform(int       value) { return encode_integral(value); }
+YAML::Node estd::conversion<long,      YAML::Node>::perform(long      value) { return encode_integral(value); }
+YAML::Node estd::conversion<long long, YAML::Node>::perform(long long value) { return encode_integral(value); }
+
+YAML::Node estd::conversion<unsigned char,      YAML::Node>::perform(unsigned char      value) { return encode_integral(value); }
+YAML::Node estd::conversion<unsigned short,     YAML::Node>::perform(unsigned short     value) { return encode_integral(value); }
+YAML::Node estd::conversion<unsigned int,       YAML::Node>::perform(unsigned int       value) { return encode_integral(value); }
+YAML::Node estd::conversion<unsigned long,      YAML::Node>::perform(unsigned long      value) { return encode_integral(value); }
+YAML::Node estd::conversion<unsigned long long, YAML::Node>::perform(unsigned long long value) { return encode_integral(value); }
+
+YAML::Node estd::conversion<float,       YAML::Node>::perform(float       value) { return encode_floating_point(value); }
+YAML::Node estd::conversion<double,      YAML::Node>::perform(double      value) { return encode_floating_point(value); }
+YAML::Node estd::conversion<long double, YAML::Node>::perform(long double value) { return encode_floating_point(value); }
 
 YAML::Node estd::conversion<YAML::Node, YAML::Node>::perform(YAML::Node value) { return value; }
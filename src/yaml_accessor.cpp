@@ -0,0 +1,53 @@
+#include "yaml_accessor.hpp"
+
+#include <fmt/format.h>
+
+namespace dr {
+
+namespace detail {
+	YamlError invalidYamlAccessorPath(std::string_view path, std::string_view reason) {
+		return YamlError{fmt::format("invalid path `{}': {}", path, reason)};
+	}
+}
+
+void * YamlAccessorChain::resolve(void * root, bool create) const {
+	// The outermost optional created along the path, which holds all optionals created after it.
+	YamlAccessorStep const * created = nullptr;
+	void * created_in = nullptr;
+
+	void * object = root;
+	for (YamlAccessorStep const & step : steps_) {
+		void * child = step.select(step, object, false);
+		if (!child && create && step.reset) {
+			child = step.select(step, object, true);
+			if (child && !created) {
+				created    = &step;
+				created_in = object;
+			}
+		}
+		if (!child) {
+			if (created) created->reset(created_in);
+			return nullptr;
+		}
+		object = child;
+	}
+	return object;
+}
+
+YamlError YamlAccessorChain::missingError() const {
+	return YamlError{fmt::format("path `{}' does not exist in the object", path_)};
+}
+
+YamlResult<YAML::Node> YamlAccessorChain::getYaml(void const * root) const {
+	if (!encode_) return YamlError{fmt::format("no YAML conversion available for `{}'", path_)};
+	void const * object = resolve(const_cast<void *>(root), false);
+	if (!object) return missingError();
+	return encode_(object);
+}
+
+std::optional<YamlError> YamlAccessorChain::setYaml(void * root, YAML::Node const & node) const {
+	if (!decode_) return YamlError{fmt::format("no YAML conversion available for `{}'", path_)};
+	return decode_(*this, root, node);
+}
+
+}
@@ -0,0 +1,30 @@
+#include "yaml_context.hpp"
+
+#include <fmt/format.h>
+
+namespace dr {
+
+void detail::YamlBufferStream::reset(std::string_view data) {
+	// The get area is never written to, so casting away the const is safe.
+	char * begin = const_cast<char *>(data.data());
+	setg(begin, begin, begin + data.size());
+}
+
+YamlParseContext::YamlParseContext() : stream_{&buffer_} {}
+
+YamlParseContext & YamlParseContext::threadLocal() {
+	thread_local YamlParseContext context;
+	return context;
+}
+
+YamlResult<YAML::Node> YamlParseContext::load(std::string_view data) {
+	buffer_.reset(data);
+	stream_.clear();
+	try {
+		return YAML::Load(stream_);
+	} catch (YAML::ParserException const & e) {
+		return YamlError{fmt::format("line {}, column {}: {}", e.mark.line + 1, e.mark.column + 1, e.msg)};
+	}
+}
+
+}
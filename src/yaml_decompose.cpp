@@ -0,0 +1,55 @@
+#include "yaml_decompose.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace dr {
+
+YamlMemberTable::YamlMemberTable(std::vector<YamlMemberEntry> entries) : entries{std::move(entries)} {
+	sorted_names.reserve(this->entries.size());
+	for (std::size_t i = 0; i < this->entries.size(); ++i) sorted_names.emplace_back(this->entries[i].name, i);
+	std::sort(sorted_names.begin(), sorted_names.end());
+}
+
+std::optional<std::size_t> YamlMemberTable::find(std::string_view name) const {
+	auto found = std::lower_bound(sorted_names.begin(), sorted_names.end(), name, [] (auto const & entry, std::string_view name) {
+		return entry.first < name;
+	});
+	if (found == sorted_names.end() || found->first != name) return std::nullopt;
+	return found->second;
+}
+
+std::optional<YamlError> YamlMemberTable::parse(YAML::Node const & node, void * object, detail::YamlSkippedKey const & skipped) const {
+	// Bit set to remember which members were parsed, on the stack for all but huge types.
+	std::uint64_t small_parsed[4] = {0, 0, 0, 0};
+	std::vector<std::uint64_t> large_parsed;
+	std::uint64_t * parsed = small_parsed;
+	if (entries.size() > 4 * 64) {
+		large_parsed.resize((entries.size() + 63) / 64);
+		parsed = large_parsed.data();
+	}
+
+	auto decode_member = [&] (std::string_view key, YAML::Node const & value, std::optional<YamlError> & error) {
+		std::optional<std::size_t> index = find(key);
+		if (!index) return false;
+
+		YamlMemberEntry const & entry = entries[*index];
+		if (auto decode_error = entry.decode(entry.info, value, object)) {
+			error = std::move(decode_error->appendTrace({std::string{entry.name}, std::string{entry.type}, value.Type()}));
+		} else {
+			parsed[*index / 64] |= std::uint64_t(1) << (*index % 64);
+		}
+		return true;
+	};
+	if (auto error = detail::parseYamlMembers(node, skipped, decode_member)) return error;
+
+	// Check if all required members were actually parsed.
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		bool was_parsed = parsed[i / 64] & (std::uint64_t(1) << (i % 64));
+		if (!was_parsed && entries[i].required) return YamlError{"missing property `" + std::string{entries[i].name} + "'"};
+	}
+
+	return std::nullopt;
+}
+
+}
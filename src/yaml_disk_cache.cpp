@@ -0,0 +1,248 @@
+#include "yaml_disk_cache.hpp"
+#include "schema_hash.hpp"
+#include "yaml_snapshot.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+namespace dr {
+
+namespace {
+	namespace fs = boost::filesystem;
+
+	/// Extension of index files.
+	constexpr char const * index_extension = ".index";
+
+	/// Extension of document files.
+	constexpr char const * document_extension = ".document";
+
+	std::string hexHash(std::uint64_t hash) {
+		char buffer[17];
+		std::snprintf(buffer, sizeof(buffer), "%016" PRIx64, hash);
+		return buffer;
+	}
+
+	std::uint64_t indexKey(std::string const & path, std::map<std::string, std::string> const & variables) {
+		param::StableHash hash;
+		hash.add(std::string_view{fs::absolute(path).lexically_normal().native()});
+		for (auto const & [name, value] : variables) {
+			hash.add(std::string_view{name});
+			hash.add(std::string_view{value});
+		}
+		return hash.value();
+	}
+
+	estd::result<void, estd::error> addFileContents(param::StableHash & hash, std::string const & path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file.good()) {
+			int error = errno;
+			return estd::error{{error, std::system_category()}, path};
+		}
+
+		char buffer[16 * 1024];
+		std::uint64_t size = 0;
+		while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+			for (std::streamsize i = 0; i < file.gcount(); ++i) hash.add(std::uint8_t(buffer[i]));
+			size += std::uint64_t(file.gcount());
+		}
+		hash.add(size);
+		return estd::in_place_valid;
+	}
+
+	estd::result<void, estd::error> addDirectoryEntries(param::StableHash & hash, std::string const & directory) {
+		boost::system::error_code error;
+		std::vector<std::string> names;
+		for (fs::directory_iterator i{directory, error}, end; !error && i != end; i.increment(error)) names.push_back(i->path().filename().native());
+		if (error) return estd::error{{error.value(), std::system_category()}, directory};
+
+		std::sort(names.begin(), names.end());
+		for (std::string const & name : names) hash.add(std::string_view{name});
+		hash.add(std::uint64_t(names.size()));
+		return estd::in_place_valid;
+	}
+
+	estd::result<std::uint64_t, estd::error> documentKey(
+		std::string const & path,
+		std::map<std::string, std::string> const & variables,
+		std::vector<std::string> const & included_files,
+		std::vector<std::string> const & listed_directories
+	) {
+		// The expansion of $DIR, $FILE and relative includes depends on the location of the root file, not only its contents.
+		param::StableHash hash;
+		hash.add(std::string_view{fs::absolute(path).lexically_normal().native()});
+		for (auto const & [name, value] : variables) {
+			hash.add(std::string_view{name});
+			hash.add(std::string_view{value});
+		}
+
+		if (estd::result<void, estd::error> added = addFileContents(hash, path); !added) return added.error_unchecked();
+		for (std::string const & included : included_files) {
+			hash.add(std::string_view{included});
+			if (estd::result<void, estd::error> added = addFileContents(hash, included); !added) return added.error_unchecked();
+		}
+		for (std::string const & directory : listed_directories) {
+			hash.add(std::string_view{directory});
+			if (estd::result<void, estd::error> added = addDirectoryEntries(hash, directory); !added) return added.error_unchecked();
+		}
+		return hash.value();
+	}
+
+	/// Check if a path is an index or document file of the cache.
+	/**
+	 * Temporary files of concurrent writers are not considered part of the cache.
+	 */
+	bool isCacheFile(fs::path const & path) {
+		return path.extension() == index_extension || path.extension() == document_extension;
+	}
+
+	/// Mark a file as recently used for the eviction policy.
+	void touch(fs::path const & path) {
+		boost::system::error_code error;
+		fs::last_write_time(path, std::time(nullptr), error);
+	}
+}
+
+YamlDiskCache::YamlDiskCache(std::string directory, std::uint64_t max_size) :
+	directory_{std::move(directory)},
+	max_size_{max_size}
+{
+	boost::system::error_code error;
+	fs::create_directories(directory_, error);
+}
+
+std::optional<YAML::Node> YamlDiskCache::lookup(
+	std::string const & path,
+	std::map<std::string, std::string> const & variables,
+	std::vector<std::string> * included_files,
+	std::vector<std::string> * listed_directories
+) {
+	// Read the list of included files and listed directories from the index.
+	fs::path index_path = fs::path{directory_} / (hexHash(indexKey(path, variables)) + index_extension);
+	estd::result<YAML::Node, estd::error> index = readYamlSnapshot(index_path.native(), 0, {});
+	if (!index || !index->IsMap() || !(*index)["files"].IsSequence() || !(*index)["directories"].IsSequence()) {
+		++misses_;
+		return std::nullopt;
+	}
+
+	std::vector<std::string> included;
+	std::vector<std::string> directories;
+	for (YAML::Node const & file : (*index)["files"]) included.push_back(file.Scalar());
+	for (YAML::Node const & directory : (*index)["directories"]) directories.push_back(directory.Scalar());
+
+	// Hash the current contents of all files and directories and load the matching document.
+	estd::result<std::uint64_t, estd::error> key = documentKey(path, variables, included, directories);
+	if (!key) {
+		++misses_;
+		return std::nullopt;
+	}
+
+	fs::path document_path = fs::path{directory_} / (hexHash(*key) + document_extension);
+	estd::result<YAML::Node, estd::error> document = readYamlSnapshot(document_path.native(), 0, {});
+	if (!document) {
+		++misses_;
+		return std::nullopt;
+	}
+
+	touch(index_path);
+	touch(document_path);
+	++hits_;
+	if (included_files) included_files->insert(included_files->end(), included.begin(), included.end());
+	if (listed_directories) listed_directories->insert(listed_directories->end(), directories.begin(), directories.end());
+	return *document;
+}
+
+estd::result<void, estd::error> YamlDiskCache::store(
+	std::string const & path,
+	std::map<std::string, std::string> const & variables,
+	YAML::Node const & document,
+	std::vector<std::string> const & included_files,
+	std::vector<std::string> const & listed_directories
+) {
+	// Store absolute paths, so the index remains valid from a different working directory.
+	std::vector<std::string> absolute_included;
+	absolute_included.reserve(included_files.size());
+	for (std::string const & included : included_files) absolute_included.push_back(fs::absolute(included).lexically_normal().native());
+
+	std::vector<std::string> absolute_directories;
+	absolute_directories.reserve(listed_directories.size());
+	for (std::string const & directory : listed_directories) absolute_directories.push_back(fs::absolute(directory).lexically_normal().native());
+
+	estd::result<std::uint64_t, estd::error> key = documentKey(path, variables, absolute_included, absolute_directories);
+	if (!key) return key.error_unchecked();
+
+	// Write the document before the index, so a valid index never refers to a missing document.
+	fs::path document_path = fs::path{directory_} / (hexHash(*key) + document_extension);
+	if (estd::result<void, estd::error> written = writeYamlSnapshot(document_path.native(), document, 0, {}, {}); !written) return written;
+
+	YAML::Node index{YAML::NodeType::Map};
+	index["files"]       = YAML::Node{YAML::NodeType::Sequence};
+	index["directories"] = YAML::Node{YAML::NodeType::Sequence};
+	for (std::string const & included : absolute_included) index["files"].push_back(included);
+	for (std::string const & directory : absolute_directories) index["directories"].push_back(directory);
+	fs::path index_path = fs::path{directory_} / (hexHash(indexKey(path, variables)) + index_extension);
+	if (estd::result<void, estd::error> written = writeYamlSnapshot(index_path.native(), index, 0, {}, {}); !written) return written;
+
+	++stores_;
+	return evict();
+}
+
+estd::result<void, estd::error> YamlDiskCache::evict() {
+	struct Entry {
+		fs::path path;
+		std::time_t time;
+		std::uint64_t size;
+	};
+
+	boost::system::error_code error;
+	std::vector<Entry> entries;
+	std::uint64_t total = 0;
+	for (fs::directory_iterator i{directory_, error}, end; !error && i != end; i.increment(error)) {
+		if (!isCacheFile(i->path())) continue;
+		boost::system::error_code file_error;
+		std::uint64_t size = fs::file_size(i->path(), file_error);
+		std::time_t time   = fs::last_write_time(i->path(), file_error);
+		if (file_error) continue;
+		entries.push_back(Entry{i->path(), time, size});
+		total += size;
+	}
+	if (error) return estd::error{{error.value(), std::system_category()}, directory_};
+	if (total <= max_size_) return estd::in_place_valid;
+
+	// Remove the least recently used files first.
+	std::sort(entries.begin(), entries.end(), [] (Entry const & a, Entry const & b) {
+		return a.time < b.time;
+	});
+
+	for (Entry const & entry : entries) {
+		if (total <= max_size_) break;
+		// Another process may have removed the file already, which is fine.
+		boost::system::error_code file_error;
+		if (fs::remove(entry.path, file_error)) ++evictions_;
+		total -= entry.size;
+	}
+
+	return estd::in_place_valid;
+}
+
+YamlDiskCacheStats YamlDiskCache::stats() const {
+	YamlDiskCacheStats result{hits_, misses_, stores_, evictions_, 0, 0};
+
+	boost::system::error_code error;
+	for (fs::directory_iterator i{directory_, error}, end; !error && i != end; i.increment(error)) {
+		if (!isCacheFile(i->path())) continue;
+		boost::system::error_code file_error;
+		std::uint64_t size = fs::file_size(i->path(), file_error);
+		if (file_error) continue;
+		result.files += 1;
+		result.bytes += size;
+	}
+
+	return result;
+}
+
+}
@@ -0,0 +1,392 @@
+#include "yaml_dom.hpp"
+#include "yaml_context.hpp"
+
+#include <fmt/format.h>
+#include <yaml-cpp/eventhandler.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+
+namespace dr {
+
+namespace detail {
+	/// Builder that appends nodes to a YamlDom.
+	/**
+	 * Children are collected on a stack while their map or sequence is open,
+	 * and moved to the child table of the document when it is closed.
+	 * That way the children of each node are contiguous in the child table.
+	 */
+	class YamlDomBuilder {
+		/// The document being built.
+		YamlDom dom_;
+
+		/// The children of the open maps and sequences.
+		std::vector<std::uint32_t> pending_;
+
+		/// The open maps and sequences, with the position of their first child in `pending_`.
+		std::vector<std::pair<std::uint32_t, std::size_t>> open_;
+
+		/// Copied maps and sequences, by the identity of the source node.
+		std::unordered_map<void const *, std::uint32_t> copied_;
+
+		/// True if the document does not fit in the 32 bit offsets of the nodes.
+		bool too_large_ = false;
+
+		/// Get the index of a tag in the tag table, adding it if needed.
+		std::uint32_t tagIndex(std::string_view tag) {
+			auto found = std::find(dom_.tags_.begin(), dom_.tags_.end(), tag);
+			if (found != dom_.tags_.end()) return std::uint32_t(found - dom_.tags_.begin());
+			dom_.tags_.emplace_back(tag);
+			return std::uint32_t(dom_.tags_.size() - 1);
+		}
+
+		/// Check that an offset or size fits in the nodes.
+		std::uint32_t checked(std::size_t value) {
+			if (value > std::numeric_limits<std::uint32_t>::max()) too_large_ = true;
+			return std::uint32_t(value);
+		}
+
+		/// Add a new node as child of the innermost open map or sequence.
+		std::uint32_t addNode(YAML::NodeType::value type, std::string_view tag, std::uint32_t offset, std::uint32_t size) {
+			std::uint32_t index = checked(dom_.nodes_.size());
+			dom_.nodes_.push_back({type, tagIndex(tag), offset, size});
+			addChild(index);
+			return index;
+		}
+
+	public:
+		YamlDomBuilder() {
+			dom_.nodes_.clear();
+			// The tags that yaml-cpp gives to untagged nodes.
+			dom_.tags_ = {"", "?", "!"};
+		}
+
+		/// Add an existing node as child of the innermost open map or sequence.
+		void addChild(std::uint32_t index) {
+			if (!open_.empty()) pending_.push_back(index);
+		}
+
+		/// Add a null node.
+		std::uint32_t addNull(std::string_view tag = "") {
+			return addNode(YAML::NodeType::Null, tag, 0, 0);
+		}
+
+		/// Add a scalar node.
+		std::uint32_t addScalar(std::string_view tag, std::string_view value) {
+			std::uint32_t offset = checked(dom_.strings_.size());
+			dom_.strings_.insert(dom_.strings_.end(), value.begin(), value.end());
+			dom_.strings_.push_back('\0');
+			return addNode(YAML::NodeType::Scalar, tag, offset, checked(value.size()));
+		}
+
+		/// Open a new map or sequence.
+		std::uint32_t start(YAML::NodeType::value type, std::string_view tag) {
+			std::uint32_t index = addNode(type, tag, 0, 0);
+			open_.emplace_back(index, pending_.size());
+			return index;
+		}
+
+		/// Close the innermost open map or sequence.
+		void end() {
+			auto [index, first] = open_.back();
+			open_.pop_back();
+
+			YamlDomNodeData & node = dom_.nodes_[index];
+			std::size_t count = pending_.size() - first;
+			node.offset = checked(dom_.children_.size());
+			node.size   = checked(node.type == YAML::NodeType::Map ? count / 2 : count);
+			dom_.children_.insert(dom_.children_.end(), pending_.begin() + first, pending_.end());
+			pending_.resize(first);
+		}
+
+		/// Copy a YAML::Node tree.
+		std::uint32_t copy(YAML::Node const & node) {
+			switch (node.Type()) {
+				case YAML::NodeType::Scalar:
+					return addScalar(node.Tag(), node.Scalar());
+				case YAML::NodeType::Sequence:
+				case YAML::NodeType::Map: {
+					// Keep nodes that are shared through aliases shared.
+					// The tag is stored in the node data shared by all aliases, so its address identifies the node.
+					void const * identity = &node.Tag();
+					if (auto found = copied_.find(identity); found != copied_.end()) {
+						addChild(found->second);
+						return found->second;
+					}
+					std::uint32_t index = start(node.Type(), node.Tag());
+					copied_.emplace(identity, index);
+					if (node.IsMap()) {
+						for (auto child : node) {
+							copy(child.first);
+							copy(child.second);
+						}
+					} else {
+						for (auto child : node) copy(child);
+					}
+					end();
+					return index;
+				}
+				case YAML::NodeType::Null:
+				case YAML::NodeType::Undefined:
+					break;
+			}
+			return addNull(node.IsNull() ? node.Tag() : "");
+		}
+
+		/// Copy a node from another YamlDom.
+		std::uint32_t copy(YamlDomNode node) {
+			switch (node.type()) {
+				case YAML::NodeType::Scalar:
+					return addScalar(node.tag(), node.scalar());
+				case YAML::NodeType::Sequence:
+				case YAML::NodeType::Map: {
+					void const * identity = node.identity();
+					if (auto found = copied_.find(identity); found != copied_.end()) {
+						addChild(found->second);
+						return found->second;
+					}
+					std::uint32_t index = start(node.type(), node.tag());
+					copied_.emplace(identity, index);
+					if (node.isMap()) {
+						for (YamlDomEntry entry : node.entries()) {
+							copy(entry.key);
+							copy(entry.value);
+						}
+					} else {
+						for (YamlDomNode child : node) copy(child);
+					}
+					end();
+					return index;
+				}
+				case YAML::NodeType::Null:
+				case YAML::NodeType::Undefined:
+					break;
+			}
+			return addNull(node.tag());
+		}
+
+		/// Finish the document with the given root node.
+		/**
+		 * If no node was added, the root is a null node.
+		 */
+		YamlResult<YamlDom> finish(std::uint32_t root = 0) {
+			if (too_large_) return YamlError{"document too large, it does not fit in 32 bit offsets"};
+			if (dom_.nodes_.empty()) addNull();
+			dom_.root_ = root;
+			return std::move(dom_);
+		}
+	};
+}
+
+namespace {
+	/// Event handler that builds a YamlDom from the events of the yaml-cpp parser.
+	class YamlDomEventHandler : public YAML::EventHandler {
+		detail::YamlDomBuilder & builder_;
+
+		/// The nodes with an anchor, by anchor.
+		std::vector<std::uint32_t> anchors_;
+
+		void setAnchor(YAML::anchor_t anchor, std::uint32_t index) {
+			if (anchor == YAML::NullAnchor) return;
+			if (anchors_.size() <= anchor) anchors_.resize(anchor + 1);
+			anchors_[anchor] = index;
+		}
+
+	public:
+		explicit YamlDomEventHandler(detail::YamlDomBuilder & builder) : builder_{builder} {}
+
+		void OnDocumentStart(YAML::Mark const &) override {}
+		void OnDocumentEnd() override {}
+
+		void OnNull(YAML::Mark const &, YAML::anchor_t anchor) override {
+			setAnchor(anchor, builder_.addNull());
+		}
+
+		void OnAlias(YAML::Mark const &, YAML::anchor_t anchor) override {
+			builder_.addChild(anchors_.at(anchor));
+		}
+
+		void OnScalar(YAML::Mark const &, std::string const & tag, YAML::anchor_t anchor, std::string const & value) override {
+			setAnchor(anchor, builder_.addScalar(tag, value));
+		}
+
+		void OnSequenceStart(YAML::Mark const &, std::string const & tag, YAML::anchor_t anchor, YAML::EmitterStyle::value) override {
+			setAnchor(anchor, builder_.start(YAML::NodeType::Sequence, tag));
+		}
+
+		void OnSequenceEnd() override {
+			builder_.end();
+		}
+
+		void OnMapStart(YAML::Mark const &, std::string const & tag, YAML::anchor_t anchor, YAML::EmitterStyle::value) override {
+			setAnchor(anchor, builder_.start(YAML::NodeType::Map, tag));
+		}
+
+		void OnMapEnd() override {
+			builder_.end();
+		}
+	};
+
+	/// Convert a node of a YamlDom to a YAML::Node, keeping shared nodes shared.
+	YAML::Node toYaml(YamlDomNode node, std::unordered_map<void const *, YAML::Node> & converted) {
+		if (node.isMap() || node.isSequence()) {
+			if (auto found = converted.find(node.identity()); found != converted.end()) return found->second;
+		}
+
+		YAML::Node result{node.isScalar() ? YAML::NodeType::Null : node.type()};
+		if (node.isScalar()) result = std::string{node.scalar()};
+		if (!node.tag().empty()) result.SetTag(node.tag());
+
+		if (node.isSequence()) {
+			converted.emplace(node.identity(), result);
+			for (YamlDomNode child : node) result.push_back(toYaml(child, converted));
+		} else if (node.isMap()) {
+			converted.emplace(node.identity(), result);
+			for (YamlDomEntry entry : node.entries()) result.force_insert(toYaml(entry.key, converted), toYaml(entry.value, converted));
+		}
+		return result;
+	}
+}
+
+namespace {
+	/// Write the result of merging maps on top of each other.
+	/**
+	 * The first layer is the base, which is merged with each later layer in turn.
+	 * A single layer is copied as is.
+	 */
+	std::optional<YamlError> writeMerged(detail::YamlDomBuilder & builder, std::vector<YamlDomNode> const & layers) {
+		if (layers.size() == 1) {
+			builder.copy(layers[0]);
+			return std::nullopt;
+		}
+		if (!layers[0].isMap() && !layers[0].isNull()) return YamlError{"tried to merge into a YAML node that is not a map"};
+
+		/// An entry of the merged map, with the layers of its value.
+		struct Entry {
+			YamlDomNode key;
+			std::vector<YamlDomNode> layers;
+		};
+		std::vector<Entry> entries;
+		for (YamlDomEntry entry : layers[0].entries()) entries.push_back({entry.key, {entry.value}});
+
+		for (std::size_t i = 1; i < layers.size(); ++i) {
+			for (YamlDomEntry entry : layers[i].entries()) {
+				std::string_view key = entry.key.scalar();
+				auto found = std::find_if(entries.begin(), entries.end(), [&] (Entry const & existing) {
+					return existing.key.scalar() == key;
+				});
+				if (found == entries.end()) {
+					entries.push_back({entry.key, {entry.value}});
+				} else if (entry.value.isMap()) {
+					found->layers.push_back(entry.value);
+				} else {
+					found->layers = {entry.value};
+				}
+			}
+		}
+
+		builder.start(YAML::NodeType::Map, layers[0].tag());
+		for (Entry const & entry : entries) {
+			builder.copy(entry.key);
+			if (std::optional<YamlError> error = writeMerged(builder, entry.layers)) {
+				return std::move(error->appendTrace({std::string{entry.key.scalar()}, "", YAML::NodeType::Map}));
+			}
+		}
+		builder.end();
+		return std::nullopt;
+	}
+}
+
+YamlDom::YamlDom() {
+	nodes_.push_back({YAML::NodeType::Null, 0, 0, 0});
+	tags_.emplace_back();
+}
+
+YamlDom::YamlDom(YAML::Node const & node) {
+	detail::YamlDomBuilder builder;
+	std::uint32_t root = builder.copy(node);
+	YamlResult<YamlDom> result = builder.finish(root);
+	if (!result) throw std::length_error{result.error().message()};
+	*this = std::move(*result);
+}
+
+YAML::Node YamlDomNode::toYaml() const {
+	std::unordered_map<void const *, YAML::Node> converted;
+	return dr::toYaml(*this, converted);
+}
+
+YamlResult<YamlDom> loadYamlDom(std::string_view data) {
+	detail::YamlDomBuilder builder;
+	YamlDomEventHandler handler{builder};
+
+	// Read directly from the caller's buffer, without copying it into a string stream.
+	detail::YamlBufferStream buffer;
+	buffer.reset(data);
+	std::istream stream{&buffer};
+	try {
+		YAML::Parser parser{stream};
+		parser.HandleNextDocument(handler);
+	} catch (YAML::ParserException const & e) {
+		return YamlError{fmt::format("line {}, column {}: {}", e.mark.line + 1, e.mark.column + 1, e.msg)};
+	}
+
+	// The root is always the first node of the document.
+	return builder.finish(0);
+}
+
+estd::result<YamlDom, estd::error> readYamlDomFile(std::string const & path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good()) {
+		int error = errno;
+		return estd::error{{error, std::system_category()}, path};
+	}
+	std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+	YamlResult<YamlDom> dom = loadYamlDom(data);
+	if (!dom) return estd::error{std::errc::invalid_argument, path + ": " + dom.error().format()};
+	return std::move(*dom);
+}
+
+YamlResult<YamlDom> mergeYamlDoms(YamlDomNode map_a, YamlDomNode map_b) {
+	if (!map_a.isMap() && !map_a.isNull()) return YamlError{"tried to merge into a YAML node that is not a map"};
+	if (!map_b.isMap() && !map_b.isNull()) return YamlError{"tried to merge from a YAML node that is not a map"};
+
+	detail::YamlDomBuilder builder;
+	if (std::optional<YamlError> error = writeMerged(builder, {map_a, map_b})) return std::move(*error);
+	return builder.finish();
+}
+
+std::optional<YamlDomNode> YamlDomNode::find(std::string_view key) const {
+	for (YamlDomEntry entry : entries()) {
+		if (entry.key.isScalar() && entry.key.scalar() == key) return entry.value;
+	}
+	return std::nullopt;
+}
+
+std::optional<YamlError> expectMap(YamlDomNode node) {
+	if (node.isMap()) return std::nullopt;
+	return YamlError{fmt::format("invalid node type: expected map, got {}", toString(node.type()))};
+}
+
+std::optional<YamlError> expectSequence(YamlDomNode node) {
+	if (node.isSequence()) return std::nullopt;
+	return YamlError{fmt::format("invalid node type: expected list, got {}", toString(node.type()))};
+}
+
+std::optional<YamlError> expectSequence(YamlDomNode node, std::size_t size) {
+	if (auto error = expectSequence(node)) return error;
+	if (node.size() == size) return std::nullopt;
+	return YamlError{fmt::format("invalid list size: expected {} elements, got {}", size, node.size())};
+}
+
+std::optional<YamlError> expectScalar(YamlDomNode node) {
+	if (node.isScalar()) return std::nullopt;
+	return YamlError{fmt::format("invalid node type: expected scalar, got {}", toString(node.type()))};
+}
+
+}
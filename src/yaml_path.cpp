@@ -0,0 +1,110 @@
+#include "yaml_path.hpp"
+
+#include <fmt/format.h>
+
+#include <charconv>
+
+namespace dr {
+
+namespace {
+	YamlError invalid_path(std::string_view path, std::string_view reason) {
+		return YamlError{fmt::format("invalid path `{}': {}", path, reason)};
+	}
+}
+
+YamlResult<std::vector<std::string_view>> splitYamlPath(std::string_view path) {
+	std::vector<std::string_view> steps;
+	std::size_t i = 0;
+
+	while (i < path.size()) {
+		if (path[i] == '[') {
+			std::size_t end = path.find(']', i);
+			if (end == std::string_view::npos) return invalid_path(path, "missing closing bracket");
+			std::string_view index = path.substr(i + 1, end - i - 1);
+			if (index.empty() || index.find_first_not_of("0123456789") != std::string_view::npos) {
+				return invalid_path(path, fmt::format("invalid sequence index `{}'", index));
+			}
+			steps.push_back(index);
+			i = end + 1;
+			continue;
+		}
+
+		// A key must be preceded by a dot, unless it is the first step.
+		if (!steps.empty()) {
+			if (path[i] != '.') return invalid_path(path, "expected `.' or `['");
+			++i;
+		}
+
+		std::size_t end = std::min(path.find_first_of(".[", i), path.size());
+		if (end == i) return invalid_path(path, "empty key");
+		steps.push_back(path.substr(i, end - i));
+		i = end;
+	}
+
+	if (steps.empty()) return invalid_path(path, "empty path");
+	return steps;
+}
+
+namespace detail {
+	std::optional<YamlError> selectYamlChild(YAML::Node const & node, std::string_view step, YAML::Node & child) {
+		if (node.IsMap()) {
+			for (auto entry : node) {
+				if (entry.first.Scalar() == step) {
+					child.reset(entry.second);
+					return std::nullopt;
+				}
+			}
+			return YamlError{fmt::format("missing property `{}'", step)};
+		}
+
+		if (node.IsSequence()) {
+			std::size_t index = 0;
+			auto [end, error] = std::from_chars(step.data(), step.data() + step.size(), index);
+			if (error != std::errc{} || end != step.data() + step.size()) return YamlError{fmt::format("invalid sequence index `{}'", step)};
+			if (index >= node.size()) return YamlError{fmt::format("sequence index {} out of range, sequence has {} elements", index, node.size())};
+			child.reset(node[index]);
+			return std::nullopt;
+		}
+
+		return YamlError{fmt::format("invalid node type: expected map or sequence, got {}", toString(node.Type()))};
+	}
+
+	YamlError & appendYamlPathTrace(YamlError & error, YAML::Node const & root, std::vector<std::string_view> const & steps) {
+		// Collect the nodes along the path first, since the trace is ordered from the leaf to the root.
+		std::vector<YAML::Node> nodes;
+		nodes.reserve(steps.size());
+		YAML::Node node = root;
+		for (std::string_view step : steps) {
+			YAML::Node child;
+			if (selectYamlChild(node, step, child)) break;
+			nodes.push_back(child);
+			node.reset(child);
+		}
+
+		for (std::size_t i = nodes.size(); i-- > 0;) {
+			error.appendTrace({std::string{steps[i]}, "", nodes[i].Type()});
+		}
+		return error;
+	}
+}
+
+YamlResult<YAML::Node> selectYamlPath(YAML::Node const & root, std::vector<std::string_view> const & steps) {
+	YAML::Node node = root;
+	for (std::size_t i = 0; i < steps.size(); ++i) {
+		YAML::Node child;
+		if (std::optional<YamlError> error = detail::selectYamlChild(node, steps[i], child)) {
+			std::vector<std::string_view> parents{steps.begin(), steps.begin() + i};
+			return std::move(detail::appendYamlPathTrace(*error, root, parents));
+		}
+		node.reset(child);
+	}
+	return node;
+}
+
+YamlResult<YAML::Node> selectYamlPath(YAML::Node const & root, std::string_view path) {
+	YamlResult<std::vector<std::string_view>> steps = splitYamlPath(path);
+	if (!steps) return std::move(steps.error());
+	return selectYamlPath(root, *steps);
+}
+
+}
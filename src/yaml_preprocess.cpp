@@ -1,10 +1,24 @@
+#include "parallel.hpp"
 #include "yaml.hpp"
+#include "yaml_context.hpp"
+#include "yaml_disk_cache.hpp"
+#include "yaml_path.hpp"
 #include "yaml_preprocess.hpp"
 
 #include <dr_util/expand.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <fmt/format.h>
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <random>
+#include <set>
+
 namespace dr {
 
 using namespace std::string_literals;
@@ -28,6 +42,47 @@ namespace {
 	struct Work {
 		PathInfo path_info;
 		std::vector<YAML::Node> nodes;
+
+		/// The number of includes between the root file and the nodes.
+		std::size_t depth;
+	};
+
+	/// Resources used so far by a preprocessing call, shared by all threads working on it.
+	struct Budget {
+		YamlLimits const & limits;
+		std::atomic<std::uint64_t> bytes_read{0};
+		std::atomic<std::size_t> nodes{0};
+
+		explicit Budget(YamlLimits const & limits) : limits{limits} {}
+
+		/// Account for reading a number of bytes.
+		std::optional<estd::error> addBytes(std::uint64_t size) {
+			if ((bytes_read += size) > limits.max_bytes_read) return estd::error{std::errc::value_too_large, fmt::format("preprocessing limit exceeded: more than {} bytes read", limits.max_bytes_read)};
+			return std::nullopt;
+		}
+
+		/// Account for reading a file, before it is read.
+		std::optional<estd::error> addFile(fs::path const & path) {
+			// Only look at the file size if there is a limit to check it against.
+			if (limits.max_bytes_read == std::numeric_limits<std::uint64_t>::max()) return std::nullopt;
+			boost::system::error_code error;
+			std::uint64_t size = fs::file_size(path, error);
+			// Let reading the file report the error.
+			if (error) return std::nullopt;
+			return addBytes(size);
+		}
+
+		/// Account for visiting a node.
+		std::optional<estd::error> addNode() {
+			if (++nodes > limits.max_nodes) return estd::error{std::errc::value_too_large, fmt::format("preprocessing limit exceeded: more than {} nodes", limits.max_nodes)};
+			return std::nullopt;
+		}
+
+		/// Check the depth of an include.
+		std::optional<estd::error> checkDepth(std::size_t depth) const {
+			if (depth > limits.max_include_depth) return estd::error{std::errc::value_too_large, fmt::format("preprocessing limit exceeded: includes nested more than {} deep", limits.max_include_depth)};
+			return std::nullopt;
+		}
 	};
 
 	void updateVariables(std::map<std::string, std::string> & variables, PathInfo const & path_info) {
@@ -36,22 +91,214 @@ namespace {
 		else variables.erase("FILE");
 	}
 
-	estd::result<void, estd::error> includeFile(YAML::Node & node, std::vector<Work> & work, PathInfo const & path_info, std::map<std::string, std::string> const & variables) {
+	/// Key in the tag of the deferred includes created by this process.
+	/**
+	 * Documents can not know the key, so a `!deferred_include` tag written in a document is never trusted as deferred include.
+	 */
+	std::string const & deferredIncludeKey() {
+		static std::string const key = [] {
+			std::random_device random;
+			return fmt::format("{:08x}{:08x}", random(), random());
+		}();
+		return key;
+	}
+
+	/// Replace a node by a deferred include of a file.
+	/**
+	 * The tag records the include depth of the file, so that resolving it continues counting from there.
+	 */
+	void deferInclude(YAML::Node & node, fs::path const & path, std::size_t depth) {
+		node = path.native();
+		node.SetTag(fmt::format("{}:{}:{}", detail::yaml_deferred_include_tag, deferredIncludeKey(), depth));
+	}
+
+	/// Get the include depth of a deferred include created by this process, or std::nullopt if the node is no deferred include.
+	std::optional<std::size_t> deferredIncludeDepth(YAML::Node const & node) {
+		if (!node.IsScalar()) return std::nullopt;
+		std::string const & tag = node.Tag();
+		std::string prefix = fmt::format("{}:{}:", detail::yaml_deferred_include_tag, deferredIncludeKey());
+		if (tag.size() <= prefix.size() || tag.compare(0, prefix.size(), prefix) != 0) return std::nullopt;
+
+		std::size_t depth;
+		char const * end = tag.data() + tag.size();
+		std::from_chars_result parsed = std::from_chars(tag.data() + prefix.size(), end, depth);
+		if (parsed.ec != std::errc{} || parsed.ptr != end) return std::nullopt;
+		return depth;
+	}
+
+	estd::result<fs::path, estd::error> includePath(YAML::Node const & node, PathInfo const & path_info, std::map<std::string, std::string> const & variables) {
 		if (!node.IsScalar()) return estd::error{std::errc::invalid_argument, "!include needs a string"};
 
 		// Expand variables in path and normalize path.
 		boost::filesystem::path path = expandVariables(node.as<std::string>(), variables);
 		if (path.empty()) return estd::error{std::errc::invalid_argument, "tried to include empty path"};
 		if (path.is_relative()) path = path_info.dir / path;
-		auto normal_path = path.lexically_normal();
+		return path.lexically_normal();
+	}
+
+	estd::result<YAML::Node, estd::error> readIncluded(fs::path const & path, YamlPreprocessOptions const & options, Budget & budget) {
+		if (auto error = budget.addFile(path)) return *error;
+		estd::result<YAML::Node, estd::error> included = options.cache ? options.cache->read(path.native()) : readYamlFile(path.native());
+		if (!included) return included.error_unchecked();
+		if (options.included_files) options.included_files->push_back(path.native());
+		return included;
+	}
+
+	estd::result<void, estd::error> includeFile(YAML::Node & node, std::vector<Work> & work, PathInfo const & path_info, std::size_t depth, std::map<std::string, std::string> const & variables, YamlPreprocessOptions const & options, Budget & budget) {
+		estd::result<fs::path, estd::error> path = includePath(node, path_info, variables);
+		if (!path) return path.error_unchecked();
+		if (auto error = budget.checkDepth(depth + 1)) return *error;
+
+		// Only remember the path of the included file, it is read when the deferred include is resolved.
+		if (options.lazy_includes) {
+			deferInclude(node, *path, depth + 1);
+			return estd::in_place_valid;
+		}
 
 		// Parse node, process tags and overwrite original.
+		estd::result<YAML::Node, estd::error> included = readIncluded(*path, options, budget);
+		if (!included) return included.error_unchecked();
 		node.SetTag("");
-		node = readYamlFile(normal_path.native()).value();
+		node = *included;
 
 		// Queue node for reprocessing.
-		work.push_back(Work{PathInfo{normal_path.parent_path(), normal_path}, {node}});
+		work.push_back(Work{PathInfo::forFile(path->native()), {node}, depth + 1});
+
+		return estd::in_place_valid;
+	}
+
+	estd::result<void, estd::error> processRecursive(YAML::Node & root, PathInfo const & path_info, std::size_t depth, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options, Budget & budget);
+
+	estd::result<void, estd::error> processRecursive(YAML::Node & root, PathInfo const & path_info, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options = {}) {
+		Budget budget{options.limits};
+		return processRecursive(root, path_info, 0, std::move(variables), options, budget);
+	}
+
+	/// List the YAML files in a directory, sorted by name.
+	/**
+	 * If a pattern is given, only files with a matching name are listed.
+	 * Otherwise, all files with a `.yaml` or `.yml` extension are listed.
+	 */
+	estd::result<std::vector<fs::path>, estd::error> listFiles(fs::path const & directory, std::optional<std::string> const & pattern) {
+		boost::system::error_code error;
+		fs::directory_iterator i{directory, error};
+		if (error) return estd::error{std::error_code{error.value(), std::system_category()}, directory.native()};
+
+		std::vector<fs::path> files;
+		for (; i != fs::directory_iterator{}; i.increment(error)) {
+			if (error) return estd::error{std::error_code{error.value(), std::system_category()}, directory.native()};
+			if (!fs::is_regular_file(i->status())) continue;
+			std::string name = i->path().filename().native();
+			if (pattern) {
+				if (fnmatch(pattern->c_str(), name.c_str(), FNM_PERIOD) != 0) continue;
+			} else {
+				std::string extension = i->path().extension().native();
+				if (extension != ".yaml" && extension != ".yml") continue;
+			}
+			files.push_back(i->path().lexically_normal());
+		}
+		if (error) return estd::error{std::error_code{error.value(), std::system_category()}, directory.native()};
+
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	/// Read and preprocess a list of files in parallel.
+	/**
+	 * On failure, the error of the first file in the list that failed is returned.
+	 */
+	estd::result<std::vector<YAML::Node>, estd::error> readIncludedFiles(std::vector<fs::path> const & files, std::size_t depth, std::map<std::string, std::string> const & variables, YamlPreprocessOptions const & options, Budget & budget) {
+		std::vector<YAML::Node> documents(files.size());
+		if (auto error = budget.checkDepth(depth + 1)) return *error;
+
+		// Only remember the paths of the included files, they are read when the deferred includes are resolved.
+		if (options.lazy_includes) {
+			for (std::size_t i = 0; i < files.size(); ++i) deferInclude(documents[i], files[i], depth + 1);
+			return documents;
+		}
+
+		std::vector<std::optional<estd::error>> errors(files.size());
+		std::vector<std::vector<std::string>> included_files(files.size());
+		std::vector<std::vector<std::string>> listed_directories(files.size());
+
+		param::parallelFor(files.size(), [&] (std::size_t i) {
+			// Collect the included files and listed directories per task, to append them in a deterministic order afterwards.
+			YamlPreprocessOptions file_options = options;
+			if (options.included_files) file_options.included_files = &included_files[i];
+			if (options.listed_directories) file_options.listed_directories = &listed_directories[i];
+
+			try {
+				estd::result<YAML::Node, estd::error> document = readIncluded(files[i], file_options, budget);
+				if (!document) {
+					// Errors for files that can not be opened already consist of the path.
+					estd::error const & error = document.error_unchecked();
+					if (error.description == files[i].native()) errors[i] = error;
+					else errors[i] = estd::error{error.code, files[i].native() + ": " + error.description};
+					return;
+				}
+
+				estd::result<void, estd::error> result = processRecursive(*document, PathInfo::forFile(files[i].native()), depth + 1, variables, file_options, budget);
+				if (!result) {
+					errors[i] = estd::error{result.error_unchecked().code, files[i].native() + ": " + result.error_unchecked().description};
+					return;
+				}
+				documents[i].reset(*document);
+			} catch (std::exception const & e) {
+				errors[i] = estd::error{std::errc::invalid_argument, files[i].native() + ": " + e.what()};
+			}
+		});
+
+		for (std::size_t i = 0; i < files.size(); ++i) {
+			if (errors[i]) return *errors[i];
+			if (options.included_files) options.included_files->insert(options.included_files->end(), included_files[i].begin(), included_files[i].end());
+			if (options.listed_directories) options.listed_directories->insert(options.listed_directories->end(), listed_directories[i].begin(), listed_directories[i].end());
+		}
+		return documents;
+	}
+
+	estd::result<void, estd::error> includeDirectory(YAML::Node & node, PathInfo const & path_info, std::size_t depth, std::map<std::string, std::string> const & variables, YamlPreprocessOptions const & options, Budget & budget) {
+		if (!node.IsScalar()) return estd::error{std::errc::invalid_argument, "!include_dir needs a string"};
+		estd::result<fs::path, estd::error> directory = includePath(node, path_info, variables);
+		if (!directory) return directory.error_unchecked();
+
+		estd::result<std::vector<fs::path>, estd::error> files = listFiles(*directory, std::nullopt);
+		if (!files) return files.error_unchecked();
+		if (options.listed_directories) options.listed_directories->push_back(directory->lexically_normal().native());
+
+		// Files with the same stem need not be adjacent after sorting, such as `a.yaml`, `a.yaml.yml` and `a.yml`.
+		std::set<std::string> stems;
+		for (fs::path const & file : *files) {
+			if (!stems.insert(file.stem().native()).second) {
+				return estd::error{std::errc::invalid_argument, "!include_dir found multiple files with stem `" + file.stem().native() + "' in " + directory->native()};
+			}
+		}
+
+		estd::result<std::vector<YAML::Node>, estd::error> documents = readIncludedFiles(*files, depth, variables, options, budget);
+		if (!documents) return documents.error_unchecked();
+
+		YAML::Node result{YAML::NodeType::Map};
+		for (std::size_t i = 0; i < files->size(); ++i) result[(*files)[i].stem().native()] = (*documents)[i];
+		node.SetTag("");
+		node = result;
+		return estd::in_place_valid;
+	}
+
+	estd::result<void, estd::error> includeGlob(YAML::Node & node, PathInfo const & path_info, std::size_t depth, std::map<std::string, std::string> const & variables, YamlPreprocessOptions const & options, Budget & budget) {
+		if (!node.IsScalar()) return estd::error{std::errc::invalid_argument, "!include_glob needs a string"};
+		estd::result<fs::path, estd::error> pattern = includePath(node, path_info, variables);
+		if (!pattern) return pattern.error_unchecked();
+
+		estd::result<std::vector<fs::path>, estd::error> files = listFiles(pattern->parent_path(), pattern->filename().native());
+		if (!files) return files.error_unchecked();
+		if (options.listed_directories) options.listed_directories->push_back(pattern->parent_path().lexically_normal().native());
+
+		estd::result<std::vector<YAML::Node>, estd::error> documents = readIncludedFiles(*files, depth, variables, options, budget);
+		if (!documents) return documents.error_unchecked();
 
+		YAML::Node result{YAML::NodeType::Sequence};
+		for (YAML::Node const & document : *documents) result.push_back(document);
+		node.SetTag("");
+		node = result;
 		return estd::in_place_valid;
 	}
 
@@ -62,9 +309,19 @@ namespace {
 		return estd::in_place_valid;
 	}
 
-	estd::result<bool, estd::error> processSingle(YAML::Node & node, std::vector<Work> & work, PathInfo const & path_info, std::map<std::string, std::string> const & variables) {
+	estd::result<bool, estd::error> processSingle(YAML::Node & node, std::vector<Work> & work, PathInfo const & path_info, std::size_t depth, std::map<std::string, std::string> const & variables, YamlPreprocessOptions const & options, Budget & budget) {
 		if (node.Tag() == "!include") {
-			estd::result<void, estd::error> result = includeFile(node, work, path_info, variables);
+			estd::result<void, estd::error> result = includeFile(node, work, path_info, depth, variables, options, budget);
+			if (!result) return result.error_unchecked();
+			return true;
+		}
+		if (node.Tag() == "!include_dir") {
+			estd::result<void, estd::error> result = includeDirectory(node, path_info, depth, variables, options, budget);
+			if (!result) return result.error_unchecked();
+			return true;
+		}
+		if (node.Tag() == "!include_glob") {
+			estd::result<void, estd::error> result = includeGlob(node, path_info, depth, variables, options, budget);
 			if (!result) return result.error_unchecked();
 			return true;
 		}
@@ -73,12 +330,16 @@ namespace {
 			if (!result) return result.error_unchecked();
 			return true;
 		}
+		// Deferred includes created by preprocessing are never visited again, so this one was written in a document.
+		if (detail::isYamlDeferredIncludeTag(node.Tag())) {
+			return estd::error{std::errc::invalid_argument, "the " + std::string{detail::yaml_deferred_include_tag} + " tag is reserved for preprocessing"};
+		}
 		return false;
 	}
 
-	estd::result<void, estd::error> processRecursive(YAML::Node & root, PathInfo const & path_info, std::map<std::string, std::string> variables) {
+	estd::result<void, estd::error> processRecursive(YAML::Node & root, PathInfo const & path_info, std::size_t depth, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options, Budget & budget) {
 		std::vector<Work> work;
-		work.push_back(Work{path_info, {root}});
+		work.push_back(Work{path_info, {root}, depth});
 
 		while (!work.empty()) {
 			Work current_work = std::move(work.back());
@@ -88,9 +349,10 @@ namespace {
 			while (!current_work.nodes.empty()) {
 				YAML::Node node = current_work.nodes.back();
 				current_work.nodes.pop_back();
+				if (auto error = budget.addNode()) return *error;
 
 				// Tag handlers must queue processed (child) nodes themselves, possibly with different PathInfo.
-				estd::result<bool, estd::error> changed = processSingle(node, work, current_work.path_info, variables);
+				estd::result<bool, estd::error> changed = processSingle(node, work, current_work.path_info, current_work.depth, variables, options, budget);
 				if (!changed) return changed.error_unchecked();
 				if (*changed) continue;
 
@@ -101,6 +363,92 @@ namespace {
 		}
 		return estd::in_place_valid;
 	}
+
+	estd::result<void, estd::error> resolveDeferredInclude(YAML::Node & node, std::size_t depth, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options, Budget & budget) {
+		// Continue counting from the depth of the original include, so include cycles still hit the depth limit.
+		std::string path = node.Scalar();
+		estd::result<YAML::Node, estd::error> included = readIncluded(path, options, budget);
+		if (!included) return included.error_unchecked();
+
+		estd::result<void, estd::error> result = processRecursive(*included, PathInfo::forFile(path), depth, std::move(variables), options, budget);
+		if (!result) return result;
+
+		node.SetTag("");
+		node = *included;
+		return estd::in_place_valid;
+	}
+
+	estd::result<void, estd::error> resolveIncludes(YAML::Node & node, std::map<std::string, std::string> const & variables, YamlPreprocessOptions const & options, Budget & budget) {
+		YamlPreprocessOptions eager_options = options;
+		eager_options.lazy_includes = false;
+
+		std::vector<YAML::Node> nodes{node};
+		while (!nodes.empty()) {
+			YAML::Node current = nodes.back();
+			nodes.pop_back();
+
+			if (std::optional<std::size_t> depth = deferredIncludeDepth(current)) {
+				estd::result<void, estd::error> result = resolveDeferredInclude(current, *depth, variables, eager_options, budget);
+				if (!result) return result;
+				continue;
+			}
+
+			if (current.IsMap())      for (YAML::iterator i = current.begin(); i != current.end(); ++i) nodes.push_back(i->second);
+			if (current.IsSequence()) for (YAML::iterator i = current.begin(); i != current.end(); ++i) nodes.push_back(*i);
+		}
+		return estd::in_place_valid;
+	}
+}
+
+estd::result<YAML::Node, estd::error> YamlIncludeCache::read(std::string const & path) {
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		auto found = documents_.find(path);
+		if (found != documents_.end()) return YAML::Clone(found->second);
+	}
+
+	// Read the file without holding the lock, so other files can be read in the mean time.
+	estd::result<YAML::Node, estd::error> document = readYamlFile(path);
+	if (!document) return document;
+
+	// Store a private copy, since the caller may modify the returned node.
+	std::lock_guard<std::mutex> lock{mutex_};
+	documents_.emplace(path, YAML::Clone(*document));
+	return document;
+}
+
+bool isDeferredYamlInclude(YAML::Node const & node) {
+	return deferredIncludeDepth(node).has_value();
+}
+
+estd::result<void, estd::error> resolveYamlIncludes(YAML::Node & node, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options) {
+	Budget budget{options.limits};
+	return resolveIncludes(node, variables, options, budget);
+}
+
+estd::result<YAML::Node, estd::error> resolveYamlPath(YAML::Node & root, std::string_view path, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options) {
+	YamlResult<std::vector<std::string_view>> steps = splitYamlPath(path);
+	if (!steps) return estd::error{std::errc::invalid_argument, steps.error().format()};
+
+	Budget budget{options.limits};
+	YAML::Node node = root;
+	for (std::size_t i = 0; i < steps->size(); ++i) {
+		if (std::optional<std::size_t> depth = deferredIncludeDepth(node)) {
+			estd::result<void, estd::error> result = resolveDeferredInclude(node, *depth, variables, options, budget);
+			if (!result) return result.error_unchecked();
+		}
+
+		YAML::Node child;
+		if (std::optional<YamlError> error = detail::selectYamlChild(node, (*steps)[i], child)) {
+			detail::appendYamlPathTrace(*error, root, {steps->begin(), steps->begin() + i});
+			return estd::error{std::errc::invalid_argument, error->format()};
+		}
+		node.reset(child);
+	}
+
+	estd::result<void, estd::error> result = resolveIncludes(node, variables, options, budget);
+	if (!result) return result.error_unchecked();
+	return node;
 }
 
 estd::result<void, estd::error> preprocessYamlWithFilePath(YAML::Node & root, std::string const & file, std::map<std::string, std::string> variables) {
@@ -121,6 +469,55 @@ estd::result<YAML::Node, estd::error> preprocessYamlFile(std::string const & pat
 	return *node;
 }
 
+estd::result<YAML::Node, estd::error> preprocessYamlFile(std::string const & path, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options) {
+	if (!options.disk_cache || options.lazy_includes) {
+		Budget budget{options.limits};
+		if (auto error = budget.addFile(path)) return *error;
+		estd::result<YAML::Node, estd::error> node = readYamlFile(path);
+		if (!node) return node.error_unchecked();
 
+		estd::result<void, estd::error> result = processRecursive(*node, PathInfo::forFile(path), 0, std::move(variables), options, budget);
+		if (!result) return result.error_unchecked();
+
+		return *node;
+	}
+
+	if (std::optional<YAML::Node> cached = options.disk_cache->lookup(path, variables, options.included_files, options.listed_directories)) return *cached;
+
+	// Collect the included files and listed directories to store them in the cache.
+	std::vector<std::string> included_files;
+	std::vector<std::string> listed_directories;
+	YamlPreprocessOptions uncached_options = options;
+	uncached_options.disk_cache         = nullptr;
+	uncached_options.included_files     = &included_files;
+	uncached_options.listed_directories = &listed_directories;
+
+	estd::result<YAML::Node, estd::error> node = preprocessYamlFile(path, variables, uncached_options);
+	if (!node) return node;
+
+	// Failing to store the document in the cache does not affect the result.
+	options.disk_cache->store(path, variables, *node, included_files, listed_directories);
+	if (options.included_files) options.included_files->insert(options.included_files->end(), included_files.begin(), included_files.end());
+	if (options.listed_directories) options.listed_directories->insert(options.listed_directories->end(), listed_directories.begin(), listed_directories.end());
+	return node;
+}
+
+estd::result<YAML::Node, estd::error> preprocessYamlFile(std::string const & path, std::map<std::string, std::string> variables, YamlIncludeCache & cache) {
+	YamlPreprocessOptions options;
+	options.cache = &cache;
+	return preprocessYamlFile(path, std::move(variables), options);
+}
+
+estd::result<YAML::Node, estd::error> preprocessYamlBuffer(std::string_view data, std::string const & base_dir, std::map<std::string, std::string> variables, YamlPreprocessOptions const & options) {
+	Budget budget{options.limits};
+	if (auto error = budget.addBytes(data.size())) return *error;
+	YamlResult<YAML::Node> node = YamlParseContext::threadLocal().load(data);
+	if (!node) return estd::error{std::errc::invalid_argument, node.error().format()};
+
+	estd::result<void, estd::error> result = processRecursive(*node, PathInfo::forDirectory(base_dir), 0, std::move(variables), options, budget);
+	if (!result) return result.error_unchecked();
+
+	return *node;
+}
 
 }
@@ -0,0 +1,395 @@
+#include "yaml_snapshot.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Snapshot file format.
+ *
+ * All integers are unsigned LEB128 varints, and all strings are a varint length followed by the raw bytes.
+ *
+ *   header:
+ *     magic           8 bytes "DRPSNAP2"
+ *     schema_hash     varint
+ *     variables_hash  varint
+ *     source_count    varint
+ *     sources         source_count times: absolute path (string), mtime in nanoseconds (varint), size (varint)
+ *     directory_count varint
+ *     directories     directory_count times: absolute path (string), entry count (varint), sorted entry names (string)
+ *     document        node
+ *
+ *   node:
+ *     type            1 byte (YAML::NodeType::value)
+ *     tag             string
+ *     scalar:         value (string)
+ *     sequence:       element count (varint), elements (node)
+ *     map:            entry count (varint), entries (key node, value node)
+ */
+
+namespace dr {
+
+namespace {
+	namespace fs = boost::filesystem;
+
+	constexpr std::string_view magic = "DRPSNAP2";
+
+	/// Maximum nesting depth of sequences and maps, to protect the stack.
+	constexpr int max_snapshot_depth = 512;
+
+	estd::error systemError(std::string const & path) {
+		int error = errno;
+		return estd::error{{error, std::system_category()}, path};
+	}
+
+	std::uint64_t variablesHash(std::map<std::string, std::string> const & variables) {
+		param::StableHash hash;
+		hash.add(std::uint64_t(variables.size()));
+		for (auto const & [name, value] : variables) {
+			hash.add(std::string_view{name});
+			hash.add(std::string_view{value});
+		}
+		return hash.value();
+	}
+
+	/// Modification time and size of a file.
+	struct FileStamp {
+		std::uint64_t mtime;
+		std::uint64_t size;
+	};
+
+	estd::result<FileStamp, estd::error> fileStamp(std::string const & path) {
+		struct ::stat info;
+		if (::stat(path.c_str(), &info) != 0) return systemError(path);
+		std::uint64_t mtime = std::uint64_t(info.st_mtim.tv_sec) * 1000000000u + std::uint64_t(info.st_mtim.tv_nsec);
+		return FileStamp{mtime, std::uint64_t(info.st_size)};
+	}
+
+	/// Get the sorted names of the entries in a directory.
+	estd::result<std::vector<std::string>, estd::error> directoryEntries(std::string const & directory) {
+		boost::system::error_code error;
+		std::vector<std::string> names;
+		for (fs::directory_iterator i{directory, error}, end; !error && i != end; i.increment(error)) names.push_back(i->path().filename().native());
+		if (error) return estd::error{{error.value(), std::system_category()}, directory};
+		std::sort(names.begin(), names.end());
+		return names;
+	}
+
+	class Writer {
+		std::string buffer_;
+
+	public:
+		std::string const & buffer() const {
+			return buffer_;
+		}
+
+		void writeVarint(std::uint64_t value) {
+			while (value >= 0x80) {
+				buffer_.push_back(char((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+			buffer_.push_back(char(value));
+		}
+
+		void writeString(std::string_view value) {
+			writeVarint(value.size());
+			buffer_.append(value);
+		}
+
+		/// Write a node, or return false if it is nested deeper than a reader accepts.
+		bool writeNode(YAML::Node const & node, int depth) {
+			if (depth > max_snapshot_depth) return false;
+			buffer_.push_back(char(node.Type()));
+			writeString(node.Tag());
+			switch (node.Type()) {
+				case YAML::NodeType::Scalar:
+					writeString(node.Scalar());
+					break;
+				case YAML::NodeType::Sequence:
+					writeVarint(node.size());
+					for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
+						if (!writeNode(*i, depth + 1)) return false;
+					}
+					break;
+				case YAML::NodeType::Map:
+					writeVarint(node.size());
+					for (YAML::const_iterator i = node.begin(); i != node.end(); ++i) {
+						if (!writeNode(i->first, depth + 1) || !writeNode(i->second, depth + 1)) return false;
+					}
+					break;
+				case YAML::NodeType::Null:
+				case YAML::NodeType::Undefined:
+					break;
+			}
+			return true;
+		}
+	};
+
+	class Reader {
+		char const * data_;
+		char const * end_;
+
+	public:
+		Reader(char const * data, std::size_t size) : data_{data}, end_{data + size} {}
+
+		bool readVarint(std::uint64_t & value) {
+			value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (data_ == end_) return false;
+				std::uint8_t byte = std::uint8_t(*data_++);
+				value |= std::uint64_t(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) return true;
+			}
+			return false;
+		}
+
+		bool readString(std::string_view & value) {
+			std::uint64_t size;
+			if (!readVarint(size)) return false;
+			if (size > std::uint64_t(end_ - data_)) return false;
+			value = std::string_view{data_, std::size_t(size)};
+			data_ += size;
+			return true;
+		}
+
+		bool readNode(YAML::Node & node, int depth) {
+			if (depth > max_snapshot_depth) return false;
+			if (data_ == end_) return false;
+			int type = std::uint8_t(*data_++);
+			std::string_view tag;
+			if (!readString(tag)) return false;
+
+			switch (type) {
+				case YAML::NodeType::Scalar: {
+					std::string_view value;
+					if (!readString(value)) return false;
+					node = YAML::Node{std::string{value}};
+					break;
+				}
+				case YAML::NodeType::Sequence: {
+					std::uint64_t size;
+					if (!readVarint(size)) return false;
+					node = YAML::Node{YAML::NodeType::Sequence};
+					for (std::uint64_t i = 0; i < size; ++i) {
+						YAML::Node element;
+						if (!readNode(element, depth + 1)) return false;
+						node.push_back(element);
+					}
+					break;
+				}
+				case YAML::NodeType::Map: {
+					std::uint64_t size;
+					if (!readVarint(size)) return false;
+					node = YAML::Node{YAML::NodeType::Map};
+					for (std::uint64_t i = 0; i < size; ++i) {
+						YAML::Node key;
+						YAML::Node value;
+						if (!readNode(key, depth + 1) || !readNode(value, depth + 1)) return false;
+						node.force_insert(key, value);
+					}
+					break;
+				}
+				case YAML::NodeType::Null:
+					node = YAML::Node{YAML::NodeType::Null};
+					break;
+				case YAML::NodeType::Undefined:
+					node = YAML::Node{};
+					break;
+				default:
+					return false;
+			}
+
+			if (!tag.empty()) node.SetTag(std::string{tag});
+			return true;
+		}
+
+		bool atEnd() const {
+			return data_ == end_;
+		}
+	};
+
+	/// Read-only memory mapping of a whole file.
+	class MappedFile {
+		void * data_ = MAP_FAILED;
+		std::size_t size_ = 0;
+
+	public:
+		MappedFile() = default;
+		MappedFile(MappedFile const &) = delete;
+		MappedFile & operator=(MappedFile const &) = delete;
+
+		~MappedFile() {
+			if (data_ != MAP_FAILED) ::munmap(data_, size_);
+		}
+
+		estd::result<void, estd::error> open(std::string const & path) {
+			int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return systemError(path);
+
+			struct ::stat info;
+			if (::fstat(fd, &info) != 0) {
+				estd::error error = systemError(path);
+				::close(fd);
+				return error;
+			}
+
+			size_ = std::size_t(info.st_size);
+			if (size_ > 0) {
+				data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data_ == MAP_FAILED) {
+					estd::error error = systemError(path);
+					::close(fd);
+					return error;
+				}
+			}
+
+			::close(fd);
+			return estd::in_place_valid;
+		}
+
+		char const * data() const {
+			return data_ == MAP_FAILED ? nullptr : static_cast<char const *>(data_);
+		}
+
+		std::size_t size() const {
+			return data_ == MAP_FAILED ? 0 : size_;
+		}
+	};
+}
+
+estd::result<void, estd::error> writeYamlSnapshot(
+	std::string const & path,
+	YAML::Node const & document,
+	std::uint64_t schema_hash,
+	std::map<std::string, std::string> const & variables,
+	std::vector<std::string> const & sources,
+	std::vector<std::string> const & listed_directories
+) {
+	Writer writer;
+	writer.writeString(magic);
+	writer.writeVarint(schema_hash);
+	writer.writeVarint(variablesHash(variables));
+	writer.writeVarint(sources.size());
+	for (std::string const & source : sources) {
+		// Store absolute paths, so the snapshot can be checked from a different working directory.
+		std::string absolute = fs::absolute(source).lexically_normal().native();
+		estd::result<FileStamp, estd::error> stamp = fileStamp(absolute);
+		if (!stamp) return stamp.error_unchecked();
+		writer.writeString(absolute);
+		writer.writeVarint(stamp->mtime);
+		writer.writeVarint(stamp->size);
+	}
+	writer.writeVarint(listed_directories.size());
+	for (std::string const & directory : listed_directories) {
+		std::string absolute = fs::absolute(directory).lexically_normal().native();
+		estd::result<std::vector<std::string>, estd::error> entries = directoryEntries(absolute);
+		if (!entries) return entries.error_unchecked();
+		writer.writeString(absolute);
+		writer.writeVarint(entries->size());
+		for (std::string const & entry : *entries) writer.writeString(entry);
+	}
+	if (!writer.writeNode(document, 0)) return estd::error{std::errc::invalid_argument, path + ": document is nested too deep for a snapshot"};
+
+	// Write to a temporary file first, so readers never see a partially written snapshot.
+	// The name includes the process ID and a counter, so concurrent writers never share a temporary file.
+	static std::atomic<unsigned int> counter{0};
+	std::string temporary = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file.good()) return systemError(temporary);
+		file.write(writer.buffer().data(), std::streamsize(writer.buffer().size()));
+		file.close();
+		if (!file.good()) {
+			estd::error error = systemError(temporary);
+			std::remove(temporary.c_str());
+			return error;
+		}
+	}
+
+	if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+		estd::error error = systemError(path);
+		std::remove(temporary.c_str());
+		return error;
+	}
+
+	return estd::in_place_valid;
+}
+
+estd::result<YAML::Node, estd::error> readYamlSnapshot(
+	std::string const & path,
+	std::uint64_t schema_hash,
+	std::map<std::string, std::string> const & variables,
+	std::string const & root_source
+) {
+	MappedFile file;
+	if (estd::result<void, estd::error> opened = file.open(path); !opened) return opened.error_unchecked();
+
+	Reader reader{file.data(), file.size()};
+	estd::error corrupt{std::errc::invalid_argument, path + ": corrupt snapshot"};
+
+	std::string_view file_magic;
+	if (!reader.readString(file_magic) || file_magic != magic) return estd::error{std::errc::invalid_argument, path + ": not a snapshot"};
+
+	std::uint64_t file_schema_hash;
+	std::uint64_t file_variables_hash;
+	if (!reader.readVarint(file_schema_hash) || !reader.readVarint(file_variables_hash)) return corrupt;
+	if (file_schema_hash != schema_hash) return estd::error{std::errc::invalid_argument, path + ": snapshot was written for a different schema"};
+	if (file_variables_hash != variablesHash(variables)) return estd::error{std::errc::invalid_argument, path + ": snapshot was written with different variables"};
+
+	std::uint64_t source_count;
+	if (!reader.readVarint(source_count)) return corrupt;
+	if (!root_source.empty() && source_count == 0) {
+		return estd::error{std::errc::invalid_argument, path + ": snapshot was not compiled from " + root_source};
+	}
+	for (std::uint64_t i = 0; i < source_count; ++i) {
+		std::string_view source;
+		FileStamp recorded;
+		if (!reader.readString(source) || !reader.readVarint(recorded.mtime) || !reader.readVarint(recorded.size)) return corrupt;
+
+		// The first source is the root file the snapshot was compiled from.
+		if (i == 0 && !root_source.empty() && source != fs::absolute(root_source).lexically_normal().native()) {
+			return estd::error{std::errc::invalid_argument, path + ": snapshot was compiled from " + std::string{source} + ", not from " + root_source};
+		}
+
+		estd::result<FileStamp, estd::error> current = fileStamp(std::string{source});
+		if (!current) return current.error_unchecked();
+		if (current->mtime != recorded.mtime || current->size != recorded.size) {
+			return estd::error{std::errc::invalid_argument, path + ": snapshot is outdated: " + std::string{source} + " was modified"};
+		}
+	}
+
+	std::uint64_t directory_count;
+	if (!reader.readVarint(directory_count)) return corrupt;
+	for (std::uint64_t i = 0; i < directory_count; ++i) {
+		std::string_view directory;
+		std::uint64_t entry_count;
+		if (!reader.readString(directory) || !reader.readVarint(entry_count)) return corrupt;
+
+		estd::result<std::vector<std::string>, estd::error> current = directoryEntries(std::string{directory});
+		if (!current) return current.error_unchecked();
+		bool changed = current->size() != entry_count;
+		for (std::uint64_t j = 0; j < entry_count; ++j) {
+			std::string_view entry;
+			if (!reader.readString(entry)) return corrupt;
+			if (!changed && (*current)[j] != entry) changed = true;
+		}
+		if (changed) return estd::error{std::errc::invalid_argument, path + ": snapshot is outdated: " + std::string{directory} + " was modified"};
+	}
+
+	YAML::Node document;
+	if (!reader.readNode(document, 0) || !reader.atEnd()) return corrupt;
+	return document;
+}
+
+}
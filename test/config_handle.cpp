@@ -0,0 +1,83 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "config_handle.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dr {
+
+namespace {
+	struct Pair {
+		int a;
+		int b;
+	};
+}
+
+TEST_CASE("ConfigHandle publish", "config_handle") {
+	ConfigHandle<std::string> handle{"first", 2};
+	std::optional<ConfigReader<std::string>> reader = handle.reader();
+	REQUIRE(reader);
+	REQUIRE(*reader->read() == "first");
+
+	{
+		// A snapshot stays valid while it is held, even after it is replaced.
+		ConfigSnapshot<std::string> snapshot = reader->read();
+		handle.publish("second");
+		handle.publish("third");
+		REQUIRE(*snapshot == "first");
+		REQUIRE(handle.retiredCount() == 2);
+	}
+
+	handle.reclaim();
+	REQUIRE(handle.retiredCount() == 0);
+	REQUIRE(*reader->read() == "third");
+	REQUIRE(reader->read()->size() == 5);
+}
+
+TEST_CASE("ConfigHandle reader slots", "config_handle") {
+	ConfigHandle<int> handle{1, 2};
+	std::optional<ConfigReader<int>> a = handle.reader();
+	std::optional<ConfigReader<int>> b = handle.reader();
+	REQUIRE(a);
+	REQUIRE(b);
+	REQUIRE(!handle.reader());
+
+	// Destroying a reader frees its slot.
+	b.reset();
+	REQUIRE(handle.reader());
+}
+
+TEST_CASE("ConfigHandle concurrent readers", "config_handle") {
+	ConfigHandle<Pair> handle{{0, 0}, 4};
+	std::atomic<bool> stop{false};
+	std::atomic<int> inconsistent{0};
+
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 3; ++i) {
+		readers.emplace_back([&] {
+			ConfigReader<Pair> reader = *handle.reader();
+			int last = 0;
+			while (!stop.load()) {
+				ConfigSnapshot<Pair> snapshot = reader.read();
+				// Snapshots are never torn, and never go back in time.
+				if (snapshot->a != snapshot->b || snapshot->a < last) ++inconsistent;
+				last = snapshot->a;
+			}
+		});
+	}
+
+	for (int i = 1; i <= 10000; ++i) handle.publish({i, i});
+	stop = true;
+	for (std::thread & reader : readers) reader.join();
+
+	REQUIRE(inconsistent == 0);
+	handle.reclaim();
+	REQUIRE(handle.retiredCount() == 0);
+}
+
+}
@@ -0,0 +1,129 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "diff.hpp"
+#include "decompose_macros.hpp"
+
+namespace dr {
+	enum class Mode { fast, precise };
+
+	struct Joint {
+		std::string name;
+		double limit;
+	};
+
+	struct Robot {
+		std::vector<Joint> joints;
+		std::optional<int> speed;
+		std::map<std::string, int> tools;
+		std::variant<int, std::string> id;
+		Mode mode;
+		std::vector<bool> flags;
+	};
+
+	template<> struct yaml_variant_name<int>         { static constexpr std::string_view value = "int"; };
+	template<> struct yaml_variant_name<std::string> { static constexpr std::string_view value = "string"; };
+}
+
+DR_PARAM_DEFINE_ENUM(dr::Mode,
+	(fast,    "fast")
+	(precise, "precise")
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Joint,
+	(name,  "string", "", true)
+	(limit, "double", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Robot,
+	(joints, "vector<Joint>",       "", true)
+	(speed,  "optional<int>",       "", false)
+	(tools,  "map<string, int>",    "", true)
+	(id,     "variant<int, string>", "", true)
+	(mode,   "Mode",                "", true)
+	(flags,  "vector<bool>",        "", true)
+);
+
+namespace dr {
+
+namespace {
+	std::vector<std::string> paths(std::vector<param::Difference> const & differences) {
+		std::vector<std::string> result;
+		for (param::Difference const & difference : differences) result.push_back(difference.path);
+		return result;
+	}
+}
+
+TEST_CASE("diff identical", "diff") {
+	Robot a{{{"base", 1.0}, {"elbow", std::nan("")}}, 3, {{"gripper", 1}}, 7, Mode::fast, {true}};
+	Robot b = a;
+	REQUIRE(param::diff(a, b).empty());
+	REQUIRE(param::diff(a, a).empty());
+}
+
+TEST_CASE("diff members", "diff") {
+	Robot a{{{"base", 1.0}, {"elbow", 2.0}}, 3, {{"gripper", 1}, {"camera", 2}}, 7, Mode::fast, {true, false}};
+	Robot b{{{"base", 1.5}}, std::nullopt, {{"gripper", 1}, {"vacuum", 3}}, std::string{"seven"}, Mode::precise, {true, true}};
+
+	std::vector<param::Difference> differences = param::diff(a, b, true);
+	REQUIRE(paths(differences) == std::vector<std::string>{
+		"joints[0].limit",
+		"joints[1]",
+		"speed",
+		"tools.camera",
+		"tools.vacuum",
+		"id",
+		"mode",
+		"flags[1]",
+	});
+
+	REQUIRE(differences[0].old_value->as<double>() == 1.0);
+	REQUIRE(differences[0].new_value->as<double>() == 1.5);
+	REQUIRE((*differences[1].old_value)["name"].as<std::string>() == "elbow");
+	REQUIRE(!differences[1].new_value);
+	REQUIRE(differences[2].old_value->as<int>() == 3);
+	REQUIRE(differences[2].new_value->IsNull());
+	REQUIRE(!differences[3].new_value);
+	REQUIRE(!differences[4].old_value);
+	REQUIRE(differences[5].new_value->as<std::string>() == "seven");
+	REQUIRE(differences[6].old_value->as<std::string>() == "fast");
+
+	// Without values, only the paths are returned.
+	differences = param::diff(a, b);
+	REQUIRE(!differences[0].old_value);
+	REQUIRE(!differences[0].new_value);
+}
+
+TEST_CASE("diff unordered and flat maps", "diff") {
+	std::unordered_map<std::string, int> a{{"aap", 1}, {"noot", 2}, {"mies", 3}, {"wim", 4}};
+	std::unordered_map<std::string, int> b{{"zus", 5}, {"wim", 4}, {"mies", 0}, {"aap", 1}};
+	b.reserve(100);
+	REQUIRE(param::diff(a, a).empty());
+	REQUIRE(paths(param::diff(a, b)) == std::vector<std::string>{"mies", "noot", "zus"});
+
+	std::vector<param::Difference> differences = param::diff(a, b, true);
+	REQUIRE(differences[0].old_value->as<int>() == 3);
+	REQUIRE(differences[0].new_value->as<int>() == 0);
+	REQUIRE(!differences[1].new_value);
+	REQUIRE(!differences[2].old_value);
+
+	FlatMap<int, double> c{{{1, 0.5}, {2, 1.5}, {4, 2.5}}};
+	FlatMap<int, double> d{{{4, 2.5}, {3, 1.5}, {1, 1.0}}};
+	REQUIRE(param::diff(c, c).empty());
+	REQUIRE(paths(param::diff(c, d)) == std::vector<std::string>{"1", "2", "3"});
+}
+
+TEST_CASE("diff root", "diff") {
+	REQUIRE(param::diff(1, 1).empty());
+	REQUIRE(paths(param::diff(1, 2)) == std::vector<std::string>{""});
+	REQUIRE(paths(param::diff(std::vector<int>{1, 2}, std::vector<int>{1, 3})) == std::vector<std::string>{"1"});
+	REQUIRE(paths(param::diff(std::map<int, int>{{1, 2}}, std::map<int, int>{{1, 3}})) == std::vector<std::string>{"1"});
+	REQUIRE(paths(param::diff(std::map<Mode, int>{{Mode::fast, 2}}, std::map<Mode, int>{{Mode::fast, 3}})) == std::vector<std::string>{"fast"});
+	REQUIRE(paths(param::diff(std::map<std::string, int>{{"", 1}}, std::map<std::string, int>{{"", 2}})) == std::vector<std::string>{""});
+	REQUIRE(paths(param::diff(std::map<std::string, std::vector<int>>{{"", {1}}}, std::map<std::string, std::vector<int>>{{"", {2}}})) == std::vector<std::string>{"[0]"});
+	REQUIRE(param::diff(YAML::Load("{a: 1, b: [2]}"), YAML::Load("{b: [2], a: 1}")).empty());
+	REQUIRE(!param::diff(YAML::Load("{a: 1, b: [2]}"), YAML::Load("{b: [3], a: 1}")).empty());
+}
+
+}
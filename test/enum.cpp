@@ -0,0 +1,87 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_dom.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+namespace dr {
+	enum class Mode {
+		fast,
+		precise,
+		off = -1,
+		unnamed = 7,
+	};
+
+	enum class Unit {
+		meter,
+		millimeter,
+	};
+}
+
+DR_PARAM_DEFINE_ENUM(dr::Mode,
+	(fast,    "fast")
+	(precise, "precise")
+	(precise, "accurate")
+	(off,     "off")
+);
+
+DR_PARAM_DEFINE_ENUM_CASE_INSENSITIVE(dr::Unit,
+	(meter,      "m")
+	(millimeter, "mm")
+);
+
+namespace dr {
+
+TEST_CASE("Enum table", "enum") {
+	static_assert(param::enumValue<Mode>("accurate") == Mode::precise);
+	static_assert(param::enumName(Mode::precise) == "precise");
+	REQUIRE(param::enumName(Mode::off) == "off");
+	REQUIRE(param::enumName(Mode::unnamed) == std::nullopt);
+	REQUIRE(param::enumValue<Mode>("Fast") == std::nullopt);
+	REQUIRE(param::enumValue<Unit>("MM") == Unit::millimeter);
+	REQUIRE(param::enumValue<Unit>("M") == Unit::meter);
+}
+
+TEST_CASE("Enum conversions", "enum") {
+	YamlResult<std::vector<Mode>> decoded = parseYaml<std::vector<Mode>>(YAML::Load("[fast, accurate, off]"));
+	REQUIRE(decoded);
+	REQUIRE(*decoded == std::vector<Mode>{Mode::fast, Mode::precise, Mode::off});
+
+	REQUIRE(YAML::Dump(encodeYaml(*decoded)) == "- fast\n- precise\n- off");
+	REQUIRE(YAML::Dump(encodeYaml(Mode::unnamed)) == "7");
+
+	YamlResult<Mode> invalid = parseYaml<Mode>(YAML::Load("slow"));
+	REQUIRE(!invalid);
+	REQUIRE(invalid.error().message() == "invalid value `slow', expected one of: fast, precise, accurate, off");
+
+	YamlResult<Unit> unit = parseYaml<Unit>(YAML::Load("Mm"));
+	REQUIRE(unit);
+	REQUIRE(*unit == Unit::millimeter);
+}
+
+TEST_CASE("Enum values without a name", "enum") {
+	// Values without a name are encoded as integer and decode back to the same value.
+	YamlResult<Mode> decoded = parseYaml<Mode>(encodeYaml(Mode::unnamed));
+	REQUIRE(decoded);
+	REQUIRE(*decoded == Mode::unnamed);
+
+	// Named values must be spelled by name.
+	REQUIRE(!parseYaml<Mode>(YAML::Load("0")));
+	REQUIRE(parseYaml<Mode>(YAML::Load("0")).error().message() == "invalid value `0', expected one of: fast, precise, accurate, off");
+
+	std::map<Mode, int> map{{Mode::fast, 1}, {Mode::unnamed, 2}};
+	YamlResult<std::map<Mode, int>> decoded_map = parseYaml<std::map<Mode, int>>(encodeYaml(map));
+	REQUIRE(decoded_map);
+	REQUIRE(*decoded_map == map);
+
+	YamlResult<YamlDom> dom = loadYamlDom(YAML::Dump(encodeYaml(map)));
+	REQUIRE(dom);
+	decoded_map = parseYaml<std::map<Mode, int>>(*dom);
+	REQUIRE(decoded_map);
+	REQUIRE(*decoded_map == map);
+}
+
+}
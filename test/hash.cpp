@@ -0,0 +1,136 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "hash.hpp"
+#include "decompose_macros.hpp"
+
+#include <cmath>
+#include <unordered_set>
+
+namespace dr {
+	struct Joint {
+		std::string name;
+		double limit;
+	};
+
+	struct RenamedJoint {
+		std::string name;
+		double limit;
+	};
+
+	struct Robot {
+		std::vector<Joint> joints;
+		std::optional<int> speed;
+		std::map<std::string, int> tools;
+		std::variant<int, std::string> id;
+		YAML::Node extra;
+	};
+
+	struct Tables {
+		std::unordered_map<std::string, int> counts;
+		FlatMap<int, double> offsets;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Joint,
+	(name,  "string", "", true)
+	(limit, "double", "", true)
+);
+
+DR_PARAM_DEFINE_DECOMPOSITION(dr::RenamedJoint,
+	("name",      "string", "", true, &dr::RenamedJoint::name)
+	("max_limit", "double", "", true, &dr::RenamedJoint::limit)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Robot,
+	(joints, "vector<Joint>",        "", true)
+	(speed,  "optional<int>",        "", false)
+	(tools,  "map<string, int>",     "", true)
+	(id,     "variant<int, string>", "", true)
+	(extra,  "any",                  "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Tables,
+	(counts,  "unordered_map<string, int>", "", true)
+	(offsets, "flat_map<int, double>",      "", true)
+);
+
+namespace dr {
+
+TEST_CASE("hash and equal", "hash") {
+	Robot a{{{"base", 1.0}, {"elbow", std::nan("")}}, 3, {{"gripper", 1}}, 7, YAML::Load("{a: 1, b: 2}")};
+	Robot b{{{"base", 1.0}, {"elbow", std::nan("")}}, 3, {{"gripper", 1}}, 7, YAML::Load("{b: 2, a: 1}")};
+	REQUIRE(param::equal(a, b));
+	REQUIRE(param::hash(a) == param::hash(b));
+
+	b.joints[0].limit = -0.0;
+	a.joints[0].limit = 0.0;
+	REQUIRE(param::equal(a, b));
+	REQUIRE(param::hash(a) == param::hash(b));
+
+	b.speed = std::nullopt;
+	REQUIRE(!param::equal(a, b));
+	REQUIRE(param::hash(a) != param::hash(b));
+
+	b.speed = 3;
+	b.id = std::string{"7"};
+	REQUIRE(!param::equal(a, b));
+	REQUIRE(param::hash(a) != param::hash(b));
+
+	b.id = 7;
+	b.extra = YAML::Load("{a: 1, b: 3}");
+	REQUIRE(!param::equal(a, b));
+	REQUIRE(param::hash(a) != param::hash(b));
+}
+
+TEST_CASE("hash is stable", "hash") {
+	// The hash must not change between runs or platforms.
+	REQUIRE(param::hash(std::string{"aap"}) == param::hash(std::string_view{"aap"}));
+	REQUIRE(param::hash(Joint{"base", 1.5}) == param::hash(Joint{"base", 1.5}));
+	REQUIRE(param::hash(std::vector<int>{1, 2, 3}) == 0xb981081392b03a26ull);
+}
+
+TEST_CASE("hash includes member names", "hash") {
+	REQUIRE(param::hash(Joint{"base", 1.5}) != param::hash(RenamedJoint{"base", 1.5}));
+}
+
+TEST_CASE("hash unordered and flat maps", "hash") {
+	Tables a{{}, FlatMap<int, double>{{{1, 0.5}, {2, 1.5}}}};
+	Tables b{{}, FlatMap<int, double>{{{2, 1.5}, {1, 0.5}}}};
+
+	// Fill the unordered maps in a different order and with a different bucket count.
+	a.counts.emplace("aap", 1);
+	a.counts.emplace("noot", 2);
+	a.counts.emplace("mies", 3);
+	b.counts.reserve(100);
+	b.counts.emplace("mies", 3);
+	b.counts.emplace("noot", 2);
+	b.counts.emplace("aap", 1);
+	REQUIRE(param::equal(a, b));
+	REQUIRE(param::hash(a) == param::hash(b));
+
+	b.counts["noot"] = 4;
+	REQUIRE(!param::equal(a, b));
+	REQUIRE(param::hash(a) != param::hash(b));
+
+	b.counts.erase("noot");
+	b.counts.emplace("wim", 2);
+	REQUIRE(!param::equal(a, b));
+	REQUIRE(param::hash(a) != param::hash(b));
+
+	b.counts = a.counts;
+	b.offsets = FlatMap<int, double>{{{1, 0.5}, {3, 1.5}}};
+	REQUIRE(!param::equal(a, b));
+	REQUIRE(param::hash(a) != param::hash(b));
+}
+
+TEST_CASE("hash in unordered containers", "hash") {
+	std::unordered_set<Joint, param::StructuralHash, param::StructuralEqual> joints;
+	joints.insert(Joint{"base", 1.0});
+	joints.insert(Joint{"base", 1.0});
+	joints.insert(Joint{"elbow", 1.0});
+	REQUIRE(joints.size() == 2);
+}
+
+}
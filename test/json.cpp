@@ -0,0 +1,121 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "json.hpp"
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+namespace dr {
+	struct JsonRobot {
+		std::string name;
+		std::vector<double> joints;
+	};
+
+	struct JsonConfig {
+		JsonRobot robot;
+		bool enabled;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::JsonRobot,
+	(name,   "std::string",         "The name of the robot.", false)
+	(joints, "std::vector<double>", "The joint positions of the robot.", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::JsonConfig,
+	(robot,   "JsonRobot", "The robot.", false)
+	(enabled, "bool",      "If false, the robot is not used.", false)
+);
+
+namespace dr {
+
+#define STRINGIFY(TEXT) #TEXT
+#define STRINGIFY_MACRO(TEXT) STRINGIFY(TEXT)
+
+namespace {
+	std::string data_path = STRINGIFY_MACRO(TEST_DATA);
+
+	/// Check that two node trees are equal, including the exact tags.
+	bool sameTree(YAML::Node const & a, YAML::Node const & b) {
+		if (a.Type() != b.Type() || a.Tag() != b.Tag()) return false;
+		if (a.IsScalar()) return a.Scalar() == b.Scalar();
+		if (a.size() != b.size()) return false;
+		if (a.IsSequence()) {
+			for (std::size_t i = 0; i < a.size(); ++i) {
+				if (!sameTree(a[i], b[i])) return false;
+			}
+		}
+		if (a.IsMap()) {
+			for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j) {
+				if (!sameTree(i->first, j->first) || !sameTree(i->second, j->second)) return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST_CASE("loadJson produces the same tree as yaml-cpp", "json") {
+	for (std::string_view document : {
+		R"({"a": 1, "b": [true, false, null], "c": {"d": "text", "e": -1.5e3}})",
+		R"([])",
+		R"({})",
+		R"("string")",
+		R"(  [ 0, 0.5 , {"nested": [[]]} ] )",
+		R"({"escapes": "quote \" slash \/ backslash \\ tab \t newline \n"})",
+		R"({"1": "numeric key", "true": "bool key"})",
+	}) {
+		CAPTURE(document);
+		YamlResult<YAML::Node> node = loadJson(document);
+		REQUIRE(node);
+		CHECK(sameTree(*node, YAML::Load(std::string{document})));
+	}
+}
+
+TEST_CASE("loadJson decodes unicode escapes", "json") {
+	YamlResult<YAML::Node> node = loadJson(R"(["A", "é", "€", "😀"])");
+	REQUIRE(node);
+	CHECK((*node)[0].Scalar() == "A");
+	CHECK((*node)[1].Scalar() == "\xc3\xa9");
+	CHECK((*node)[2].Scalar() == "\xe2\x82\xac");
+	CHECK((*node)[3].Scalar() == "\xf0\x9f\x98\x80");
+}
+
+TEST_CASE("loadJson reports syntax errors", "json") {
+	auto error = [] (std::string_view document) {
+		YamlResult<YAML::Node> node = loadJson(document);
+		REQUIRE(!node);
+		return node.error().message();
+	};
+
+	CHECK(error("") == "line 1, column 1: unexpected end of document");
+	CHECK(error("{\n  \"a\": 1,\n  \"b\" 2\n}") == "line 3, column 7: expected `:' after object key");
+	CHECK(error("[1, 2") == "line 1, column 6: expected `,' or `]' in array");
+	CHECK(error("{a: 1}") == "line 1, column 2: expected string as object key");
+	CHECK(error("[01]") == "line 1, column 2: invalid number: leading zero");
+	CHECK(error("[1.]") == "line 1, column 4: invalid number: expected digits after decimal point");
+	CHECK(error("[tru]") == "line 1, column 2: invalid literal");
+	CHECK(error(R"(["\x"])") == "line 1, column 4: invalid escape sequence");
+	CHECK(error(R"(["\ud83d"])") == "line 1, column 9: invalid surrogate pair");
+	CHECK(error(R"(["\ude00"])") == "line 1, column 9: invalid surrogate pair");
+	CHECK(error(R"(["\ude00\ud83d"])") == "line 1, column 9: invalid surrogate pair");
+	CHECK(error("\"unterminated") == "line 1, column 14: unterminated string");
+	CHECK(error("[] []") == "line 1, column 4: unexpected data after the end of the document");
+	CHECK(error(std::string(1000, '[') + std::string(1000, ']')) == "line 1, column 513: nesting too deep");
+}
+
+TEST_CASE("JSON files decode like YAML files", "json") {
+	estd::result<YAML::Node, estd::error> node = readYamlFile(data_path + "/config.json");
+	REQUIRE(node);
+
+	YamlResult<JsonConfig> config = parseYaml<JsonConfig>(*node);
+	REQUIRE(config);
+	CHECK(config->robot.name == "arm");
+	CHECK(config->robot.joints == std::vector<double>{1, 2.5, -300});
+	CHECK(config->enabled);
+
+	CHECK(!readJsonFile(data_path + "/does_not_exist.json"));
+}
+
+}
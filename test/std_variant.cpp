@@ -0,0 +1,185 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+namespace dr {
+	struct Circle {
+		double radius;
+	};
+
+	struct Rectangle {
+		double width;
+		double height;
+	};
+
+	struct Square {
+		double side;
+	};
+
+	struct Label {
+		std::string type;
+		double size;
+	};
+
+	using Shape = std::variant<Circle, Rectangle>;
+	using Number = std::variant<int, std::string>;
+	using Item = std::variant<Circle, Square, Label, std::map<std::string, double>>;
+
+	template<> struct yaml_variant_name<Circle>      { static constexpr std::string_view value = "circle"; };
+	template<> struct yaml_variant_name<Rectangle>   { static constexpr std::string_view value = "rectangle"; };
+	template<> struct yaml_variant_name<int>         { static constexpr std::string_view value = "int"; };
+	template<> struct yaml_variant_name<std::string> { static constexpr std::string_view value = "string"; };
+	template<> struct yaml_variant_name<Square>      { static constexpr std::string_view value = "square"; };
+	template<> struct yaml_variant_name<Label>       { static constexpr std::string_view value = "label"; };
+	template<> struct yaml_variant_name<std::map<std::string, double>> { static constexpr std::string_view value = "table"; };
+
+	template<> struct yaml_variant_discriminator<Shape> { static constexpr std::string_view value = "type"; };
+	template<> struct yaml_variant_discriminator<Item>  { static constexpr std::string_view value = "type"; };
+
+	template<> struct use_yaml_member_table<Square> : std::true_type {};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Circle,
+	(radius, "double", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Rectangle,
+	(width,  "double", "", true)
+	(height, "double", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Square,
+	(side, "double", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Label,
+	(type, "string", "", true)
+	(size, "double", "", true)
+);
+
+namespace dr {
+
+TEST_CASE("StringTable", "string_table") {
+	constexpr param::StringTable<3> table{{"aap", "noot", "mies"}};
+	static_assert(table.find("noot") == 1);
+	REQUIRE(table.find("aap") == 0);
+	REQUIRE(table.find("mies") == 2);
+	REQUIRE(table.find("wim") == std::nullopt);
+	REQUIRE(table.find("") == std::nullopt);
+}
+
+TEST_CASE("Variant selected by tag", "variant") {
+	YamlResult<Number> decoded = parseYaml<Number>(YAML::Load("!int 7"));
+	REQUIRE(decoded);
+	REQUIRE(std::get<int>(*decoded) == 7);
+
+	decoded = parseYaml<Number>(YAML::Load("!string 7"));
+	REQUIRE(decoded);
+	REQUIRE(std::get<std::string>(*decoded) == "7");
+
+	decoded = parseYaml<Number>(YAML::Load("!float 7"));
+	REQUIRE(!decoded);
+	REQUIRE(decoded.error().message() == "unknown variant alternative `float'");
+
+	decoded = parseYaml<Number>(YAML::Load("7"));
+	REQUIRE(!decoded);
+}
+
+TEST_CASE("Variant selected by discriminator", "variant") {
+	YamlResult<std::vector<Shape>> decoded = parseYaml<std::vector<Shape>>(YAML::Load(
+		"[{type: circle, radius: 1}, !rectangle {width: 2, height: 3}, {height: 5, type: rectangle, width: 4}]"
+	));
+	REQUIRE(decoded);
+	REQUIRE(decoded->size() == 3);
+	REQUIRE(std::get<Circle>((*decoded)[0]).radius == 1);
+	REQUIRE(std::get<Rectangle>((*decoded)[1]).width == 2);
+	REQUIRE(std::get<Rectangle>((*decoded)[1]).height == 3);
+	REQUIRE(std::get<Rectangle>((*decoded)[2]).width == 4);
+	REQUIRE(std::get<Rectangle>((*decoded)[2]).height == 5);
+
+	// The alternative is still checked by the decomposition.
+	decoded = parseYaml<std::vector<Shape>>(YAML::Load("[{type: circle, width: 1}]"));
+	REQUIRE(!decoded);
+	REQUIRE(decoded.error().format() == "0: unknown property `width'");
+
+	decoded = parseYaml<std::vector<Shape>>(YAML::Load("[{type: triangle}]"));
+	REQUIRE(!decoded);
+	REQUIRE(decoded.error().format() == "0.type: unknown variant alternative `triangle'");
+
+	decoded = parseYaml<std::vector<Shape>>(YAML::Load("[{radius: 1}]"));
+	REQUIRE(!decoded);
+}
+
+TEST_CASE("Variant round trip", "variant") {
+	std::vector<Shape> original{Circle{1.5}, Rectangle{2, 3}};
+	std::string encoded = YAML::Dump(encodeYaml(original));
+	YamlResult<std::vector<Shape>> decoded = parseYaml<std::vector<Shape>>(YAML::Load(encoded));
+	REQUIRE(decoded);
+	REQUIRE(decoded->size() == 2);
+	REQUIRE(std::get<Circle>((*decoded)[0]).radius == 1.5);
+	REQUIRE(std::get<Rectangle>((*decoded)[1]).width == 2);
+
+	std::vector<Number> numbers{7, std::string{"7"}};
+	encoded = YAML::Dump(encodeYaml(numbers));
+	YamlResult<std::vector<Number>> decoded_numbers = parseYaml<std::vector<Number>>(YAML::Load(encoded));
+	REQUIRE(decoded_numbers);
+	REQUIRE(*decoded_numbers == numbers);
+}
+
+TEST_CASE("Variant discriminator key", "variant") {
+	// The discriminator key is skipped for all kinds of alternatives, also if the alternative is selected by tag.
+	std::string const document = "[{type: circle, radius: 1}, {type: square, side: 2}, {type: table, a: 3}, !circle {type: circle, radius: 4}, !square {type: square, side: 5}]";
+	YamlResult<std::vector<Item>> decoded = parseYaml<std::vector<Item>>(YAML::Load(document));
+	REQUIRE(decoded);
+	REQUIRE(decoded->size() == 5);
+	REQUIRE(std::get<Circle>((*decoded)[0]).radius == 1);
+	REQUIRE(std::get<Square>((*decoded)[1]).side == 2);
+	REQUIRE(std::get<std::map<std::string, double>>((*decoded)[2]) == std::map<std::string, double>{{"a", 3}});
+	REQUIRE(std::get<Circle>((*decoded)[3]).radius == 4);
+	REQUIRE(std::get<Square>((*decoded)[4]).side == 5);
+
+	// If both a tag and the discriminator key are present, they must select the same alternative.
+	REQUIRE(!parseYaml<std::vector<Item>>(YAML::Load("[!circle {type: square, radius: 1}]")));
+
+	// The key is only skipped in the map that selected the alternative.
+	REQUIRE(!parseYaml<Circle>(YAML::Load("{type: circle, radius: 1}")));
+	REQUIRE(!parseYaml<Square>(YAML::Load("{type: square, side: 1}")));
+}
+
+TEST_CASE("Variant discriminator key of an aliased node", "variant") {
+	// The key is only skipped while decoding the variant, also if the same aliased node is decoded again as plain struct.
+	YAML::Node const document = YAML::Load("{item: &a {type: circle, radius: 1}, circle: *a, square: &b {type: square, side: 2}, items: [*b]}");
+	YamlAliasScope scope{document};
+	YamlResult<Item> item = parseYaml<Item>(document["item"]);
+	REQUIRE(item);
+	REQUIRE(std::get<Circle>(*item).radius == 1);
+	REQUIRE(!parseYaml<Circle>(document["circle"]));
+
+	// The same holds for alternatives decoded with a member table, and in the other order.
+	REQUIRE(!parseYaml<Square>(document["square"]));
+	YamlResult<std::vector<Item>> items = parseYaml<std::vector<Item>>(document["items"]);
+	REQUIRE(items);
+	REQUIRE(std::get<Square>((*items)[0]).side == 2);
+}
+
+TEST_CASE("Variant alternative with a property named like the discriminator", "variant") {
+	// Alternatives that have their own property with the name of the discriminator key are encoded with a tag.
+	std::vector<Item> original{Label{"bold", 2}, std::map<std::string, double>{{"type", 1}, {"b", 2}}};
+	YAML::Node encoded = encodeYaml(original);
+	REQUIRE(encoded[0].Tag() == "!label");
+	REQUIRE(encoded[0]["type"].as<std::string>() == "bold");
+	REQUIRE(encoded[1].Tag() == "!table");
+
+	YamlResult<std::vector<Item>> decoded = parseYaml<std::vector<Item>>(YAML::Load(YAML::Dump(encoded)));
+	REQUIRE(decoded);
+	REQUIRE(decoded->size() == 2);
+	REQUIRE(std::get<Label>((*decoded)[0]).type == "bold");
+	REQUIRE(std::get<Label>((*decoded)[0]).size == 2);
+	REQUIRE(std::get<std::map<std::string, double>>((*decoded)[1]) == std::map<std::string, double>{{"type", 1}, {"b", 2}});
+}
+
+}
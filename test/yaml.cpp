@@ -5,6 +5,10 @@
 #include "yaml.hpp"
 #include <estd/result/catch_string_conversions.hpp>
 
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 namespace dr {
 
 TEST_CASE("array conversions", "[array]") {
@@ -93,4 +97,126 @@ TEST_CASE("Merge from an empty YAML node", "[yaml_node]") {
 	CHECK(a["mies"].as<int>() == 3);
 }
 
+TEST_CASE("floating point values round trip exactly", "[numbers]") {
+	std::vector<double> doubles{0.1, 1.0 / 3.0, -2.5e-300, 4.9e-324, 1.7976931348623157e308, 123456789.123456789, 0.0, -0.0};
+	std::string encoded = YAML::Dump(encodeYaml(doubles));
+	YamlResult<std::vector<double>> decoded_doubles = parseYaml<std::vector<double>>(YAML::Load(encoded));
+	REQUIRE(decoded_doubles);
+	REQUIRE(decoded_doubles->size() == doubles.size());
+	for (std::size_t i = 0; i < doubles.size(); ++i) {
+		REQUIRE(std::memcmp(&(*decoded_doubles)[i], &doubles[i], sizeof(double)) == 0);
+	}
+
+	std::vector<float> floats{0.1f, 1.0f / 3.0f, 1e-45f, 3.4028235e38f, 16777217.0f};
+	encoded = YAML::Dump(encodeYaml(floats));
+	YamlResult<std::vector<float>> decoded_floats = parseYaml<std::vector<float>>(YAML::Load(encoded));
+	REQUIRE(decoded_floats);
+	REQUIRE(*decoded_floats == floats);
+
+	REQUIRE(YAML::Dump(encodeYaml(0.1)) == "0.1");
+	REQUIRE(YAML::Dump(encodeYaml(0.1f)) == "0.1");
+}
+
+TEST_CASE("special floating point values", "[numbers]") {
+	std::vector<double> specials{std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+	std::string encoded = YAML::Dump(encodeYaml(specials));
+	REQUIRE(encoded == "[.inf, -.inf]");
+	REQUIRE(parseYaml<std::vector<double>>(YAML::Load(encoded)) == specials);
+
+	YamlResult<double> nan = parseYaml<double>(encodeYaml(std::numeric_limits<double>::quiet_NaN()));
+	REQUIRE(nan);
+	REQUIRE(std::isnan(*nan));
+
+	REQUIRE(!parseYaml<double>(YAML::Load("1e400")));
+	REQUIRE(!parseYaml<double>(YAML::Load("1.5x")));
+}
+
+TEST_CASE("integer values are encoded as numbers", "[numbers]") {
+	REQUIRE(YAML::Dump(encodeYaml(std::vector<char>{65, -1})) == "[65, -1]");
+	REQUIRE(YAML::Dump(encodeYaml(std::numeric_limits<long long>::min())) == "-9223372036854775808");
+	REQUIRE(parseYaml<unsigned char>(encodeYaml((unsigned char)(200))) == 200);
+	REQUIRE(YAML::Dump(encodeYaml(std::array<int, 3>{{1, 2, 3}})) == "[1, 2, 3]");
+}
+
+TEST_CASE("invalid integer values", "[numbers]") {
+	REQUIRE(parseYaml<long long>(YAML::Load("99999999999999999999")).error().message() == "integer value out of range: 99999999999999999999");
+	REQUIRE(parseYaml<int>(YAML::Load("12abc")).error().message() == "invalid integer value: 12abc");
+	REQUIRE(parseYaml<unsigned int>(YAML::Load("abc")).error().message() == "invalid integer value: abc");
+
+	// Values that do not fit in narrow types.
+	REQUIRE(parseYaml<int>(YAML::Load("3000000000")).error().message() == "integer value out of range: 3000000000");
+	REQUIRE(parseYaml<int>(YAML::Load("-3000000000")).error().message() == "integer value out of range: -3000000000");
+	REQUIRE(parseYaml<unsigned int>(YAML::Load("-1")).error().message() == "integer value out of range: -1");
+	REQUIRE(parseYaml<unsigned char>(YAML::Load("300")).error().message() == "integer value out of range: 300");
+	REQUIRE(parseYaml<short>(YAML::Load("32768")).error().message() == "integer value out of range: 32768");
+	REQUIRE(*parseYaml<short>(YAML::Load("-32768")) == -32768);
+	REQUIRE(*parseYaml<unsigned char>(YAML::Load("255")) == 255);
+	REQUIRE(*parseYaml<unsigned long long>(YAML::Load("18446744073709551615")) == 18446744073709551615ull);
+}
+
+TEST_CASE("decoding limits", "[limits]") {
+	YamlLimits limits;
+	limits.max_sequence_length = 3;
+	REQUIRE(parseYaml<std::vector<int>>(YAML::Load("[1, 2, 3]"), limits));
+	YamlResult<std::vector<std::vector<int>>> too_long = parseYaml<std::vector<std::vector<int>>>(YAML::Load("[[1], [1, 2, 3, 4]]"), limits);
+	REQUIRE(!too_long);
+	REQUIRE(too_long.error().message() == "decoding limit exceeded: 4 elements, but at most 3 are allowed");
+	REQUIRE(too_long.error().formatTrace() == "1");
+	REQUIRE(!parseYaml<std::map<std::string, int>>(YAML::Load("{a: 1, b: 2, c: 3, d: 4}"), limits));
+
+	// Aliases are counted each time they are decoded.
+	YAML::Node bomb = YAML::Load(R"(
+- &a [1, 1, 1, 1, 1, 1, 1, 1, 1, 1]
+- &b [*a, *a, *a, *a, *a, *a, *a, *a, *a, *a]
+- &c [*b, *b, *b, *b, *b, *b, *b, *b, *b, *b]
+- [*c, *c, *c, *c, *c, *c, *c, *c, *c, *c]
+)");
+	using Bomb = std::vector<std::vector<std::vector<std::vector<int>>>>;
+	bomb.reset(bomb[3]);
+	limits = YamlLimits{};
+	limits.max_nodes = 1000;
+	YamlResult<Bomb> exploded = parseYaml<Bomb>(bomb, limits);
+	REQUIRE(!exploded);
+	REQUIRE(exploded.error().message() == "decoding limit exceeded: more than 1000 nodes");
+
+	limits = YamlLimits{};
+	limits.max_decode_time = std::chrono::seconds{0};
+	REQUIRE(!parseYaml<Bomb>(bomb, limits));
+
+	// The limits only apply within the scope.
+	REQUIRE(parseYaml<Bomb>(bomb));
+}
+
+TEST_CASE("errors are a single pointer", "[error]") {
+	static_assert(sizeof(YamlError) == sizeof(void *));
+
+	YamlResult<std::map<std::string, std::vector<int>>> result = parseYaml<std::map<std::string, std::vector<int>>>(YAML::Load("a: [1, 2]\nb: [3, x]\n"));
+	REQUIRE(!result);
+	REQUIRE(result.error().format() == "b[1]: invalid integer value: x");
+
+	std::vector<YamlNodeDescription> trace = result.error().trace();
+	REQUIRE(trace.size() == 2);
+	REQUIRE(trace[0].name == "1");
+	REQUIRE(trace[1].name == "b");
+
+	// Copies are independent.
+	YamlError copy = result.error();
+	copy.appendTrace({"root", "", YAML::NodeType::Map});
+	REQUIRE(copy.formatTrace() == "root.b[1]");
+	REQUIRE(result.error().formatTrace() == "b[1]");
+}
+
+TEST_CASE("structural equality", "[equal]") {
+	REQUIRE(yamlEqual(YAML::Load("{a: 1, b: [2, 3], c: {d: 4}}"), YAML::Load("{a: 1, b: [2, 3], c: {d: 4}}")));
+	REQUIRE(yamlEqual(YAML::Load("{a: 1, b: [2, 3], c: {d: 4}}"), YAML::Load("{c: {d: 4}, a: 1, b: [2, 3]}")));
+	REQUIRE(yamlEqual(YAML::Load("{a: 1, b: 2, c: 3}"), YAML::Load("{a: 1, c: 3, b: 2}")));
+	REQUIRE(!yamlEqual(YAML::Load("{a: 1, b: 2, c: 3}"), YAML::Load("{a: 1, c: 2, b: 3}")));
+	REQUIRE(!yamlEqual(YAML::Load("{a: 1, b: 2, c: 3}"), YAML::Load("{a: 1, b: 2, d: 3}")));
+	REQUIRE(!yamlEqual(YAML::Load("{a: 1, b: 2}"), YAML::Load("{b: 2, a: !x 1}")));
+
+	// Keys that are not scalars are searched for.
+	REQUIRE(yamlEqual(YAML::Load("{a: 1, [b]: 2, {c: 3}: 4}"), YAML::Load("{{c: 3}: 4, a: 1, [b]: 2}")));
+	REQUIRE(!yamlEqual(YAML::Load("{a: 1, [b]: 2, {c: 3}: 4}"), YAML::Load("{{c: 3}: 2, a: 1, [b]: 4}")));
+}
+
 }
@@ -0,0 +1,183 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_accessor.hpp"
+#include "yaml_path.hpp"
+#include "flat_map.hpp"
+#include "decompose_macros.hpp"
+
+#include <unordered_map>
+
+namespace dr {
+	struct Gains {
+		double kp;
+		double ki;
+	};
+
+	struct Controller {
+		std::vector<Gains> gains;
+		std::map<std::string, int> limits;
+		std::optional<Gains> fallback;
+	};
+
+	struct Robot {
+		std::string name;
+		Controller controller;
+	};
+
+	struct Arm {
+		std::optional<Controller> controller;
+	};
+
+	struct Tables {
+		std::map<int, double> offsets;
+		std::map<std::string_view, int> labels;
+		std::unordered_map<std::string, int> counts;
+		FlatMap<int, double> scales;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Gains,
+	(kp, "double", "", true)
+	(ki, "double", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Controller,
+	(gains,    "vector<Gains>",    "", true)
+	(limits,   "map<string, int>", "", true)
+	(fallback, "Gains",            "", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Robot,
+	(name,       "string",     "", true)
+	(controller, "Controller", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Arm,
+	(controller, "Controller", "", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Tables,
+	(offsets, "map<int, double>",      "", true)
+	(labels,  "map<string_view, int>", "", true)
+	(counts,  "unordered_map<string, int>", "", true)
+	(scales,  "FlatMap<int, double>", "", true)
+);
+
+namespace dr {
+
+TEST_CASE("YamlAccessor get and set", "yaml_accessor") {
+	Robot robot{"bob", {{{1, 2}, {3, 4}}, {{"speed", 5}}, std::nullopt}};
+
+	YamlResult<YamlAccessor<Robot>> kp = YamlAccessor<Robot>::compile("controller.gains[1].kp");
+	REQUIRE(kp);
+	REQUIRE(kp->type() == typeid(double));
+	REQUIRE(kp->get<double>(robot) == &robot.controller.gains[1].kp);
+	REQUIRE(kp->get<int>(robot) == nullptr);
+	REQUIRE(kp->getYaml(robot)->as<double>() == 3);
+
+	REQUIRE(!kp->setYaml(robot, YAML::Node(7.5)));
+	REQUIRE(robot.controller.gains[1].kp == 7.5);
+	REQUIRE(robot.controller.gains[1].ki == 4);
+
+	// A failed decode leaves the member untouched.
+	REQUIRE(kp->setYaml(robot, YAML::Load("[1]")));
+	REQUIRE(robot.controller.gains[1].kp == 7.5);
+
+	// Whole sub-objects can be read and written too.
+	YamlResult<YamlAccessor<Robot>> gains = YamlAccessor<Robot>::compile("controller.gains[0]");
+	REQUIRE(gains);
+	REQUIRE(!gains->setYaml(robot, YAML::Load("{kp: 10, ki: 11}")));
+	REQUIRE(robot.controller.gains[0].ki == 11);
+
+	// Elements are checked when the accessor is used.
+	robot.controller.gains.resize(1);
+	REQUIRE(kp->get<double>(robot) == nullptr);
+	REQUIRE(kp->getYaml(robot).error().message() == "path `controller.gains[1].kp' does not exist in the object");
+
+	YamlResult<YamlAccessor<Robot>> fallback = YamlAccessor<Robot>::compile("controller.fallback.kp");
+	REQUIRE(fallback);
+	REQUIRE(fallback->get<double>(robot) == nullptr);
+	robot.controller.fallback = Gains{1, 2};
+	REQUIRE(*fallback->get<double>(robot) == 1);
+}
+
+TEST_CASE("YamlAccessor empty optional", "yaml_accessor") {
+	// Reading through an empty optional fails, writing value initializes it like parseYamlPaths().
+	Robot robot{"bob", {{}, {}, std::nullopt}};
+	YamlResult<YamlAccessor<Robot>> fallback = YamlAccessor<Robot>::compile("controller.fallback.kp");
+	REQUIRE(fallback);
+	REQUIRE(!fallback->getYaml(robot));
+	REQUIRE(!fallback->setYaml(robot, YAML::Node(3)));
+	REQUIRE(robot.controller.fallback);
+	REQUIRE(robot.controller.fallback->kp == 3);
+	REQUIRE(robot.controller.fallback->ki == 0);
+
+	Robot decoded{"bob", {{}, {}, std::nullopt}};
+	REQUIRE(!parseYamlPaths(YAML::Load("{controller: {fallback: {kp: 3}}}"), decoded, {"controller.fallback.kp"}));
+	REQUIRE(decoded.controller.fallback);
+	REQUIRE(decoded.controller.fallback->kp == robot.controller.fallback->kp);
+	REQUIRE(decoded.controller.fallback->ki == robot.controller.fallback->ki);
+
+	// A failed decode does not create the optional.
+	Robot failed{"bob", {{}, {}, std::nullopt}};
+	REQUIRE(fallback->setYaml(failed, YAML::Load("[1]")));
+	REQUIRE(!failed.controller.fallback);
+
+	// Neither does a path that turns out not to exist in the created value.
+	Arm arm;
+	YamlResult<YamlAccessor<Arm>> kp = YamlAccessor<Arm>::compile("controller.gains[0].kp");
+	REQUIRE(kp);
+	REQUIRE(kp->setYaml(arm, YAML::Node(3)).value().message() == "path `controller.gains[0].kp' does not exist in the object");
+	REQUIRE(!arm.controller);
+}
+
+TEST_CASE("YamlAccessor errors", "yaml_accessor") {
+	REQUIRE(YamlAccessor<Robot>::compile("controller.gain").error().message() == "invalid path `controller.gain': unknown property `gain'");
+	REQUIRE(YamlAccessor<Robot>::compile("controller.gains.kp").error().message() == "invalid path `controller.gains.kp': invalid sequence index `kp'");
+	REQUIRE(YamlAccessor<Robot>::compile("name.first").error().message() == "invalid path `name.first': can not select `first' in a value without members");
+	REQUIRE(!YamlAccessor<Robot>::compile("controller..gains"));
+}
+
+TEST_CASE("YamlAccessor map keys", "yaml_accessor") {
+	Tables tables{{{-2, 0.5}}, {{"arm", 3}}, {{"cycles", 4}}, FlatMap<int, double>{{{1, 0.5}, {2, 2.5}}}};
+
+	YamlResult<YamlAccessor<Tables>> offset = YamlAccessor<Tables>::compile("offsets.-2");
+	REQUIRE(offset);
+	REQUIRE(offset->get<double>(tables) == &tables.offsets[-2]);
+	REQUIRE(!YamlAccessor<Tables>::compile("offsets.3")->get<double>(tables));
+	REQUIRE(YamlAccessor<Tables>::compile("offsets.x").error().message() == "invalid path `offsets.x': invalid key `x': invalid integer value: x");
+
+	YamlResult<YamlAccessor<Tables>> label = YamlAccessor<Tables>::compile("labels.arm");
+	REQUIRE(label);
+	REQUIRE(label->get<int>(tables) == &tables.labels["arm"]);
+
+	// Unordered maps and flat maps can be stepped through too.
+	YamlResult<YamlAccessor<Tables>> count = YamlAccessor<Tables>::compile("counts.cycles");
+	REQUIRE(count);
+	REQUIRE(count->get<int>(tables) == &tables.counts["cycles"]);
+	REQUIRE(!YamlAccessor<Tables>::compile("counts.other")->get<int>(tables));
+
+	YamlResult<YamlAccessor<Tables>> scale = YamlAccessor<Tables>::compile("scales.2");
+	REQUIRE(scale);
+	REQUIRE(scale->get<double>(tables) == &tables.scales.at(2));
+	REQUIRE(!YamlAccessor<Tables>::compile("scales.3")->get<double>(tables));
+}
+
+TEST_CASE("YamlAccessorRegistry", "yaml_accessor") {
+	Robot robot{"bob", {{{1, 2}}, {{"speed", 5}}, std::nullopt}};
+	YamlAccessorRegistry<Robot> registry;
+
+	REQUIRE(registry.getYaml(robot, "controller.limits.speed")->as<int>() == 5);
+	REQUIRE(!registry.setYaml(robot, "controller.limits.speed", YAML::Node(6)));
+	REQUIRE(robot.controller.limits["speed"] == 6);
+	REQUIRE(registry.setYaml(robot, "controller.limits.force", YAML::Node(6)));
+
+	// The same path gives the same compiled accessor.
+	REQUIRE(*registry.find("name") == *registry.find("name"));
+	REQUIRE(!registry.find("nope"));
+}
+
+}
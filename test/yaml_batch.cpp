@@ -0,0 +1,105 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "parallel.hpp"
+#include "yaml_batch.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace dr {
+	struct Shared {
+		std::string value;
+	};
+
+	struct Cell {
+		std::string name;
+		Shared shared;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Shared,
+	(value, "string", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Cell,
+	(name,   "string", "", true)
+	(shared, "Shared", "", true)
+);
+
+namespace dr {
+
+#define STRINGIFY(TEXT) #TEXT
+#define STRINGIFY_MACRO(TEXT) STRINGIFY(TEXT)
+
+std::string data_path = STRINGIFY_MACRO(TEST_DATA);
+
+TEST_CASE("parallelFor runs every index once", "parallel") {
+	std::vector<std::atomic<int>> counts(1000);
+	param::parallelFor(counts.size(), [&] (std::size_t index) { ++counts[index]; }, 4);
+	for (std::atomic<int> const & count : counts) REQUIRE(count == 1);
+
+	int called = 0;
+	param::parallelFor(0, [&] (std::size_t) { ++called; });
+	REQUIRE(called == 0);
+}
+
+TEST_CASE("Nested parallelFor runs serially", "parallel") {
+	std::vector<std::atomic<int>> counts(100);
+	std::atomic<bool> same_thread{true};
+	param::parallelFor(10, [&] (std::size_t outer) {
+		std::thread::id thread = std::this_thread::get_id();
+		param::parallelFor(10, [&] (std::size_t inner) {
+			if (std::this_thread::get_id() != thread) same_thread = false;
+			++counts[outer * 10 + inner];
+		}, 4);
+	}, 4);
+	for (std::atomic<int> const & count : counts) REQUIRE(count == 1);
+	REQUIRE(same_thread);
+}
+
+TEST_CASE("loadYamlFiles", "batch") {
+	std::vector<std::string> paths;
+	for (int i = 0; i < 20; ++i) {
+		paths.push_back(data_path + "/batch/one.yaml");
+		paths.push_back(data_path + "/batch/two.yaml");
+		paths.push_back(data_path + "/batch/three.yaml");
+	}
+
+	std::vector<YamlResult<Cell>> results = loadYamlFiles<Cell>(paths, {{"robot", "r1"}}, 4);
+	REQUIRE(results.size() == paths.size());
+	for (std::size_t i = 0; i < results.size(); i += 3) {
+		REQUIRE(results[i]);
+		REQUIRE(results[i]->name == "one");
+		REQUIRE(results[i]->shared.value == data_path + "/batch/r1");
+		REQUIRE(results[i + 1]);
+		REQUIRE(results[i + 1]->name == "two");
+		REQUIRE(!results[i + 2]);
+	}
+}
+
+TEST_CASE("loadYamlFiles with limits", "batch") {
+	std::vector<std::string> paths;
+	for (int i = 0; i < 20; ++i) paths.push_back(data_path + "/batch/one.yaml");
+
+	YamlLimits limits;
+	limits.max_include_depth = 0;
+	for (YamlResult<Cell> const & result : loadYamlFiles<Cell>(paths, {{"robot", "r1"}}, 4, limits)) REQUIRE(!result);
+
+	// The limits apply to each file separately.
+	limits = {};
+	limits.max_nodes = 5;
+	for (YamlResult<Cell> const & result : loadYamlFiles<Cell>(paths, {{"robot", "r1"}}, 4, limits)) REQUIRE(result);
+
+	// Decoding is limited on every worker thread.
+	using Map = std::map<std::string, YAML::Node>;
+	limits = {};
+	limits.max_sequence_length = 1;
+	for (YamlResult<Map> const & result : loadYamlFiles<Map>(paths, {{"robot", "r1"}}, 4, limits)) REQUIRE(!result);
+	REQUIRE(detail::current_yaml_decode_budget == nullptr);
+}
+
+}
@@ -0,0 +1,125 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_context.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	std::atomic<std::size_t> allocations{0};
+}
+
+// Do not inline the replacements, or the compiler sees memory from std::malloc()
+// released with operator delete (or the reverse) and warns about mismatched allocation functions.
+[[gnu::noinline]] void * operator new(std::size_t size) {
+	++allocations;
+	if (void * result = std::malloc(size ? size : 1)) return result;
+	throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * pointer) noexcept {
+	std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void * pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+namespace dr {
+	struct Command {
+		int sequence;
+		double speed;
+		bool enabled;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Command,
+	(sequence, "int",    "The sequence number of the command, which is echoed in the reply to the command.", true)
+	(speed,    "double", "The speed to move at, as fraction of the maximum speed of the robot.", true)
+	(enabled,  "bool",   "If false, the command is ignored, but still acknowledged to the sender.", false)
+);
+
+namespace dr {
+
+TEST_CASE("YamlParseContext parse", "yaml_context") {
+	YamlParseContext & context = YamlParseContext::threadLocal();
+	REQUIRE(&context == &YamlParseContext::threadLocal());
+
+	for (int i = 0; i < 3; ++i) {
+		YamlResult<Command> command = context.parse<Command>("{sequence: " + std::to_string(i) + ", speed: 0.5}");
+		REQUIRE(command);
+		REQUIRE(command->sequence == i);
+		REQUIRE(command->speed == 0.5);
+	}
+}
+
+TEST_CASE("YamlParseContext errors", "yaml_context") {
+	YamlParseContext context;
+
+	YamlResult<Command> command = context.parse<Command>("{sequence: 1, speed: [}");
+	REQUIRE(!command);
+	REQUIRE(command.error().message().rfind("line 1, column ", 0) == 0);
+
+	command = context.parse<Command>("{sequence: 1, speed: fast}");
+	REQUIRE(!command);
+	REQUIRE(command.error().trace().size() == 1);
+	REQUIRE(command.error().trace()[0].name == "speed");
+
+	// The context must still be usable after an error.
+	command = context.parse<Command>("{sequence: 2, speed: 1}");
+	REQUIRE(command);
+	REQUIRE(command->sequence == 2);
+}
+
+TEST_CASE("parseYamlBuffer", "yaml_context") {
+	// Only the given part of the buffer is parsed.
+	std::string_view message = "{sequence: 3, speed: 2, enabled: false} trailing garbage";
+	YamlResult<Command> command = parseYamlBuffer<Command>(message.substr(0, message.find('}') + 1));
+	REQUIRE(command);
+	REQUIRE(command->sequence == 3);
+	REQUIRE(command->speed == 2);
+	REQUIRE(command->enabled == false);
+
+	// The trace is the same as for parseYaml<T>().
+	command = parseYamlBuffer<Command>("{sequence: 3, speed: [1]}");
+	REQUIRE(!command);
+	YamlError expected = parseYaml<Command>(YAML::Load("{sequence: 3, speed: [1]}")).error();
+	REQUIRE(command.error().format() == expected.format());
+}
+
+TEST_CASE("YamlParseContext no allocations", "yaml_context") {
+	YamlParseContext context;
+	std::string_view message = "{sequence: 4, speed: 0.25, enabled: true}";
+
+	// The first call creates the cached decomposition.
+	REQUIRE(context.parse<Command>(message));
+
+	// Decoding allocates nothing beyond the node tree built by yaml-cpp.
+	std::size_t before = allocations;
+	YamlResult<YAML::Node> node = context.load(message);
+	std::size_t load_allocations = allocations - before;
+
+	before = allocations;
+	YamlResult<Command> command = context.parse<Command>(message);
+	std::size_t parse_allocations = allocations - before;
+
+	REQUIRE(node);
+	REQUIRE(command);
+	REQUIRE(command->sequence == 4);
+	REQUIRE(parse_allocations == load_allocations);
+
+	// Reading the buffer through the context allocates less than loading it through a new stream.
+	before = allocations;
+	YAML::Node loaded = YAML::Load(std::string{message});
+	std::size_t stream_allocations = allocations - before;
+	REQUIRE(loaded.IsMap());
+	REQUIRE(load_allocations < stream_allocations);
+}
+
+}
@@ -5,14 +5,9 @@
 #include "yaml.hpp"
 #include "yaml_decompose.hpp"
 #include "decompose_macros.hpp"
+#include "yaml_decompose_types.hpp"
 
 namespace dr {
-	struct Struct {
-		int a;
-		bool b;
-		std::string c;
-	};
-
 	class Class {
 		int member_;
 
@@ -20,18 +15,64 @@ namespace dr {
 		int       & member()       { return member_; }
 		int const & member() const { return member_; }
 	};
-}
 
-DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Struct,
-	(a, "int", "", true)
-	(b, "int", "", true)
-	(c, "int", "", true)
-);
+	class Constructed {
+		int value_;
+		std::string name_;
+
+	public:
+		Constructed(int value, std::string name) : value_{value}, name_{std::move(name)} {}
+
+		int value() const { return value_; }
+		std::string const & name() const { return name_; }
+	};
+
+	struct Assembly {
+		Constructed const part;
+		int count;
+	};
+
+	struct Station {
+		std::shared_ptr<Struct const> shared;
+		Struct copied;
+	};
+}
 
 DR_PARAM_DEFINE_DECOMPOSITION(dr::Class,
 	("member", "int", "", true, [] (auto & v) { return &v.member();} )
 );
 
+DR_PARAM_DEFINE_CONSTRUCTOR_DECOMPOSITION(dr::Constructed,
+	("value", "int",    "", true,  [] (dr::Constructed const & v) { return v.value(); })
+	("name",  "string", "", false, [] (dr::Constructed const & v) { return &v.name(); })
+);
+
+DR_PARAM_DEFINE_CONSTRUCTOR_DECOMPOSITION(dr::Assembly,
+	("part",  "Constructed", "", true,  &dr::Assembly::part)
+	("count", "int",         "", false, &dr::Assembly::count)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Station,
+	(shared, "Struct", "", true)
+	(copied, "Struct", "", true)
+);
+
+namespace dr {
+	struct Renamed {
+		int value;
+	};
+
+	/// The name of Renamed::value, which can change at run-time.
+	std::string renamed_key = "value";
+}
+
+/// Hand-written decomposition that depends on run-time state, so it must not be cached.
+template<> struct dr::param::Decomposition<dr::Renamed> {
+	static auto decompose() {
+		return std::make_tuple(dr::param::memberInfo(dr::renamed_key, "int", "", true, &dr::Renamed::value));
+	}
+};
+
 namespace dr {
 
 TEST_CASE("YamlParser 0", "decompose_struct") {
@@ -50,4 +91,128 @@ TEST_CASE("YamlParser 1", "decompose_class") {
 	REQUIRE(foo->member() == 7);
 }
 
+TEST_CASE("YamlParser 2", "explicit_instantiation") {
+	YAML::Node node = YAML::Load("[{a: 1, b: [{a: 7, b: true, c: aap}]}, {a: 2, b: []}]");
+	YamlResult<std::vector<Instantiated>> foo = parseYaml<std::vector<Instantiated>>(node);
+	REQUIRE(foo);
+	REQUIRE(foo->size() == 2);
+	REQUIRE((*foo)[0].b[0].c == "aap");
+	REQUIRE((*foo)[1].a == 2);
+
+	YAML::Node encoded = encodeYaml(*foo);
+	REQUIRE(encoded[0]["b"][0]["a"].as<int>() == 7);
+}
+
+TEST_CASE("YamlParser 3", "member_table") {
+	YAML::Node node = YAML::Load("{a: 7, b: true, c: \"aap noot mies\"}");
+	YamlResult<Struct> foo = parseDecomposableFromYamlTable<Struct>(node);
+	REQUIRE(foo);
+	REQUIRE(foo->a == 7);
+	REQUIRE(foo->b == true);
+	REQUIRE(foo->c == "aap noot mies");
+
+	YamlResult<Class> bar = parseDecomposableFromYamlTable<Class>(YAML::Load("{member: 7}"));
+	REQUIRE(bar);
+	REQUIRE(bar->member() == 7);
+
+	// Errors must be identical to the unrolled implementation.
+	for (char const * input : {"{a: 7, b: true}", "{a: 7, b: true, c: aap, d: 1}", "{a: x, b: true, c: aap}", "[]"}) {
+		YamlResult<Struct> unrolled = parseDecomposableFromYaml<Struct>(YAML::Load(input));
+		YamlResult<Struct> table    = parseDecomposableFromYamlTable<Struct>(YAML::Load(input));
+		REQUIRE(!unrolled);
+		REQUIRE(!table);
+		REQUIRE(table.error().format() == unrolled.error().format());
+	}
+}
+
+TEST_CASE("YamlParser 4", "constructor_decomposition") {
+	YamlResult<Immutable> immutable = parseYaml<Immutable>(YAML::Load("{a: 7, b: [1, 2, 3]}"));
+	REQUIRE(immutable);
+	REQUIRE(immutable->a == 7);
+	REQUIRE(immutable->b == std::vector<int>{1, 2, 3});
+
+	YamlResult<Immutable> defaulted = parseYaml<Immutable>(YAML::Load("{a: 8}"));
+	REQUIRE(defaulted);
+	REQUIRE(defaulted->a == 8);
+	REQUIRE(defaulted->b.empty());
+
+	YamlResult<Constructed> constructed = parseYaml<Constructed>(YAML::Load("{value: 3, name: aap}"));
+	REQUIRE(constructed);
+	REQUIRE(constructed->value() == 3);
+	REQUIRE(constructed->name() == "aap");
+
+	YAML::Node encoded = encodeYaml(*constructed);
+	REQUIRE(encoded["value"].as<int>() == 3);
+	REQUIRE(encoded["name"].as<std::string>() == "aap");
+
+	// Errors must be identical to those for normal decompositions.
+	REQUIRE(parseYaml<Constructed>(YAML::Load("{name: aap}")).error().format() == "missing property `value'");
+	REQUIRE(parseYaml<Constructed>(YAML::Load("{value: 3, noot: 1}")).error().format() == "unknown property `noot'");
+	REQUIRE(!parseYaml<Constructed>(YAML::Load("{value: mies}")));
+
+	// Nested types that are not default constructible.
+	YamlResult<Assembly> assembly = parseYaml<Assembly>(YAML::Load("{part: {value: 4}}"));
+	REQUIRE(assembly);
+	REQUIRE(assembly->part.value() == 4);
+	REQUIRE(assembly->count == 0);
+	REQUIRE(parseYaml<Assembly>(YAML::Load("{count: 2}")).error().format() == "missing property `part'");
+	REQUIRE(parseYaml<Assembly>(YAML::Load("{part: {name: aap}}")).error().format() == "part: missing property `value'");
+}
+
+TEST_CASE("YamlParser 5", "shared_aliases") {
+	YAML::Node node = YAML::Load(R"(
+- {shared: &gripper {a: 1, b: true, c: "vacuum"}, copied: *gripper}
+- {shared: *gripper, copied: *gripper}
+- {shared: {a: 1, b: true, c: "vacuum"}, copied: *gripper}
+)");
+
+	// Without memoization, each alias is decoded separately.
+	YamlResult<std::vector<Station>> separate = parseYaml<std::vector<Station>>(node);
+	REQUIRE(separate);
+	REQUIRE((*separate)[0].shared != (*separate)[1].shared);
+
+	// With memoization, all aliases share the same object.
+	YamlResult<std::vector<Station>> shared = parseYamlShared<std::vector<Station>>(node);
+	REQUIRE(shared);
+	REQUIRE((*shared)[0].shared == (*shared)[1].shared);
+	REQUIRE((*shared)[1].copied.c == "vacuum");
+	REQUIRE((*shared)[2].copied.a == 1);
+
+	// Equal nodes that are not aliases are still decoded separately.
+	REQUIRE((*shared)[0].shared != (*shared)[2].shared);
+	REQUIRE((*shared)[2].shared->c == "vacuum");
+
+	// Shared pointers encode as the value they point to.
+	REQUIRE(encodeYaml((*shared)[0])["shared"]["c"].as<std::string>() == "vacuum");
+}
+
+TEST_CASE("YamlParser 6", "shared_aliases") {
+	YAML::Node document = YAML::Load("[&gripper {a: 1, b: true, c: vacuum}, *gripper]");
+	YamlAliasScope scope{document};
+	REQUIRE(parseYaml<Struct>(document[0]));
+
+	// The scope keeps the document alive, so the identities of its aliased nodes are not reused by other documents.
+	document.reset();
+	for (int i = 0; i < 100; ++i) {
+		YAML::Node other = YAML::Load("{a: " + std::to_string(i) + ", b: false, c: suction}");
+		YamlResult<Struct> decoded = parseYaml<Struct>(other);
+		REQUIRE(decoded);
+		REQUIRE(decoded->a == i);
+	}
+}
+
+TEST_CASE("YamlParser 7", "uncached_decomposition") {
+	STATIC_REQUIRE(param::caches_decomposition<Struct>);
+	STATIC_REQUIRE(!param::caches_decomposition<Renamed>);
+
+	renamed_key = "value";
+	REQUIRE(parseYaml<Renamed>(YAML::Load("{value: 1}"))->value == 1);
+
+	// Decompositions that are not defined with the macros are created again for every use.
+	renamed_key = "other";
+	REQUIRE(parseYaml<Renamed>(YAML::Load("{other: 2}"))->value == 2);
+	REQUIRE(!parseYaml<Renamed>(YAML::Load("{value: 1}")));
+	REQUIRE(encodeYaml(Renamed{3})["other"].as<int>() == 3);
+}
+
 }
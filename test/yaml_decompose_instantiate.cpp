@@ -0,0 +1,5 @@
+/// Fizyr
+#include "yaml_decompose_types.hpp"
+
+DR_PARAM_INSTANTIATE_YAML(dr::Instantiated);
+DR_PARAM_INSTANTIATE_YAML(dr::Immutable);
@@ -0,0 +1,44 @@
+#pragma once
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+#include <string>
+#include <vector>
+
+namespace dr {
+	struct Struct {
+		int a;
+		bool b;
+		std::string c;
+	};
+
+	struct Instantiated {
+		int a;
+		std::vector<Struct> b;
+	};
+
+	struct Immutable {
+		int const a;
+		std::vector<int> const b;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Struct,
+	(a, "int", "", true)
+	(b, "int", "", true)
+	(c, "int", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Instantiated,
+	(a, "int",            "", true)
+	(b, "vector<Struct>", "", true)
+);
+
+DR_PARAM_DEFINE_CONSTRUCTOR_DECOMPOSITION(dr::Immutable,
+	("a", "int",         "", true,  &dr::Immutable::a)
+	("b", "vector<int>", "", false, &dr::Immutable::b)
+);
+
+// The conversions are instantiated in yaml_decompose_instantiate.cpp only.
+DR_PARAM_EXTERN_YAML(dr::Instantiated);
+DR_PARAM_EXTERN_YAML(dr::Immutable);
@@ -0,0 +1,172 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml_disk_cache.hpp"
+#include "yaml_preprocess.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace dr {
+
+namespace fs = boost::filesystem;
+
+namespace {
+	void writeFile(fs::path const & path, std::string const & data) {
+		std::ofstream file(path.native());
+		file << data;
+	}
+}
+
+TEST_CASE("disk cache hits and misses", "disk_cache") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir / "config");
+	writeFile(dir / "config/robot.yaml", "name: !expand $name\ntool: !include tool.yaml\n");
+	writeFile(dir / "config/tool.yaml", "name: gripper\n");
+	std::string path = (dir / "config/robot.yaml").native();
+
+	YamlDiskCache cache{(dir / "cache").native()};
+	YamlPreprocessOptions options;
+	options.disk_cache = &cache;
+
+	auto node = preprocessYamlFile(path, {{"name", "r1"}}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["name"].as<std::string>() == "r1");
+	REQUIRE(cache.stats().misses == 1);
+	REQUIRE(cache.stats().stores == 1);
+	REQUIRE(cache.stats().files == 2);
+
+	std::vector<std::string> included;
+	options.included_files = &included;
+	node = preprocessYamlFile(path, {{"name", "r1"}}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["tool"]["name"].as<std::string>() == "gripper");
+	REQUIRE(cache.stats().hits == 1);
+	REQUIRE(included == std::vector<std::string>{(dir / "config/tool.yaml").native()});
+	options.included_files = nullptr;
+
+	// Different variables are a different entry.
+	node = preprocessYamlFile(path, {{"name", "r2"}}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["name"].as<std::string>() == "r2");
+	REQUIRE(cache.stats().misses == 2);
+
+	// Changing an included file invalidates the entry.
+	writeFile(dir / "config/tool.yaml", "name: suction cup\n");
+	node = preprocessYamlFile(path, {{"name", "r1"}}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["tool"]["name"].as<std::string>() == "suction cup");
+	REQUIRE(cache.stats().misses == 3);
+
+	node = preprocessYamlFile(path, {{"name", "r1"}}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["tool"]["name"].as<std::string>() == "suction cup");
+	REQUIRE(cache.stats().hits == 2);
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("disk cache with directory includes", "disk_cache") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir / "config/tools");
+	fs::create_directories(dir / "config/grippers");
+	writeFile(dir / "config/robot.yaml", "tools: !include_dir tools\ngrippers: !include_glob grippers/*.yaml\n");
+	writeFile(dir / "config/tools/a.yaml", "1\n");
+	writeFile(dir / "config/grippers/a.yaml", "1\n");
+	std::string path = (dir / "config/robot.yaml").native();
+
+	YamlDiskCache cache{(dir / "cache").native()};
+	YamlPreprocessOptions options;
+	options.disk_cache = &cache;
+
+	REQUIRE(preprocessYamlFile(path, {}, options));
+	std::vector<std::string> listed;
+	options.listed_directories = &listed;
+	REQUIRE(preprocessYamlFile(path, {}, options));
+	REQUIRE(cache.stats().hits == 1);
+	REQUIRE(listed.size() == 2);
+	options.listed_directories = nullptr;
+
+	// Adding a file to a listed directory invalidates the entry.
+	writeFile(dir / "config/tools/b.yaml", "2\n");
+	auto node = preprocessYamlFile(path, {}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["tools"].size() == 2);
+	REQUIRE(cache.stats().hits == 1);
+
+	writeFile(dir / "config/grippers/b.yaml", "2\n");
+	node = preprocessYamlFile(path, {}, options);
+	REQUIRE(node);
+	REQUIRE((*node)["grippers"].size() == 2);
+	REQUIRE(cache.stats().hits == 1);
+
+	node = preprocessYamlFile(path, {}, options);
+	REQUIRE(node);
+	REQUIRE(cache.stats().hits == 2);
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("disk cache with identical files in different directories", "disk_cache") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir / "a");
+	fs::create_directories(dir / "b");
+	writeFile(dir / "a/robot.yaml", "dir: !expand $DIR\ntool: !include tool.yaml\n");
+	writeFile(dir / "b/robot.yaml", "dir: !expand $DIR\ntool: !include tool.yaml\n");
+	writeFile(dir / "a/tool.yaml", "gripper\n");
+	writeFile(dir / "b/tool.yaml", "suction cup\n");
+	writeFile(dir / "a/name.yaml", "name: !expand $DIR\n");
+	writeFile(dir / "b/name.yaml", "name: !expand $DIR\n");
+
+	YamlDiskCache cache{(dir / "cache").native()};
+	YamlPreprocessOptions options;
+	options.disk_cache = &cache;
+
+	for (int i = 0; i < 2; ++i) {
+		auto a = preprocessYamlFile((dir / "a/robot.yaml").native(), {}, options);
+		auto b = preprocessYamlFile((dir / "b/robot.yaml").native(), {}, options);
+		REQUIRE(a);
+		REQUIRE(b);
+		REQUIRE((*a)["dir"].as<std::string>() == (dir / "a").native());
+		REQUIRE((*b)["dir"].as<std::string>() == (dir / "b").native());
+		REQUIRE((*a)["tool"].as<std::string>() == "gripper");
+		REQUIRE((*b)["tool"].as<std::string>() == "suction cup");
+
+		// Without includes, only the location of the root file tells the entries apart.
+		a = preprocessYamlFile((dir / "a/name.yaml").native(), {}, options);
+		b = preprocessYamlFile((dir / "b/name.yaml").native(), {}, options);
+		REQUIRE(a);
+		REQUIRE(b);
+		REQUIRE((*a)["name"].as<std::string>() == (dir / "a").native());
+		REQUIRE((*b)["name"].as<std::string>() == (dir / "b").native());
+	}
+	REQUIRE(cache.stats().stores == 4);
+	REQUIRE(cache.stats().hits == 4);
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("disk cache eviction", "disk_cache") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+
+	YamlDiskCache cache{(dir / "cache").native(), 256};
+	for (int i = 0; i < 10; ++i) {
+		fs::path file = dir / (std::to_string(i) + ".yaml");
+		writeFile(file, "value: " + std::string(40, 'a' + i) + "\n");
+		YamlPreprocessOptions options;
+		options.disk_cache = &cache;
+		REQUIRE(preprocessYamlFile(file.native(), {}, options));
+	}
+
+	YamlDiskCacheStats stats = cache.stats();
+	REQUIRE(stats.stores == 10);
+	REQUIRE(stats.evictions > 0);
+	REQUIRE(stats.bytes <= 256);
+
+	fs::remove_all(dir);
+}
+
+}
@@ -0,0 +1,68 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "yaml_document.hpp"
+#include "decompose_macros.hpp"
+
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace dr {
+	struct Recipe {
+		std::string_view name;
+		std::map<std::string_view, std::string_view> steps;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Recipe,
+	(name,  "string",              "", true)
+	(steps, "map<string, string>", "", true)
+);
+
+namespace dr {
+
+TEST_CASE("YamlDocument buffer", "yaml_document") {
+	std::optional<YamlDocument<Recipe>> document;
+	{
+		std::string data = "{name: pancakes, steps: {mix: flour and eggs, bake: both sides}}";
+		YamlResult<YamlDocument<Recipe>> result = parseYamlDocumentBuffer<Recipe>(data);
+		REQUIRE(result);
+		document.emplace(std::move(*result));
+		// Overwrite the buffer, the views must not point into it.
+		data.assign(data.size(), 'x');
+	}
+
+	REQUIRE((*document)->name == "pancakes");
+	REQUIRE((*document)->steps.size() == 2);
+	REQUIRE((*document)->steps.at("mix") == "flour and eggs");
+	REQUIRE((*document)->steps.at("bake") == "both sides");
+
+	// The views point into the node tree, they are not copies.
+	REQUIRE((*document)->name.data() == document->node()["name"].Scalar().data());
+
+	// Copies share the node tree, so their views remain valid too.
+	YamlDocument<Recipe> copy = *document;
+	document.reset();
+	REQUIRE(copy->name == "pancakes");
+	REQUIRE(copy->steps.at("mix") == "flour and eggs");
+}
+
+TEST_CASE("YamlDocument node", "yaml_document") {
+	YAML::Node node = YAML::Load("{name: soup, steps: {boil: water}}");
+	YamlResult<YamlDocument<Recipe>> document = parseYamlDocument<Recipe>(node);
+	REQUIRE(document);
+	node.reset();
+	REQUIRE((*document)->name == "soup");
+	REQUIRE(encodeYaml(document->value())["steps"]["boil"].as<std::string>() == "water");
+
+	YamlResult<YamlDocument<Recipe>> error = parseYamlDocumentBuffer<Recipe>("{name: soup, steps: [boil]}");
+	REQUIRE(!error);
+	REQUIRE(error.error().trace().size() == 1);
+	REQUIRE(error.error().trace()[0].name == "steps");
+}
+
+}
@@ -0,0 +1,258 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_dom.hpp"
+#include "yaml_decompose.hpp"
+#include "yaml_preprocess.hpp"
+#include "decompose_macros.hpp"
+
+namespace dr {
+	enum class DomMode {
+		fast,
+		precise,
+	};
+
+	struct DomCircle {
+		double radius;
+	};
+
+	struct DomSquare {
+		double side;
+	};
+
+	using DomShape = std::variant<DomCircle, DomSquare>;
+
+	template<> struct yaml_variant_name<DomCircle> { static constexpr std::string_view value = "circle"; };
+	template<> struct yaml_variant_name<DomSquare> { static constexpr std::string_view value = "square"; };
+	template<> struct yaml_variant_name<int>       { static constexpr std::string_view value = "int"; };
+	template<> struct yaml_variant_discriminator<DomShape> { static constexpr std::string_view value = "kind"; };
+
+	struct DomConfig {
+		std::string name;
+		std::string_view label;
+		DomMode mode;
+		std::vector<double> joints;
+		std::map<std::string_view, int> limits;
+		std::optional<std::array<int, 2>> range;
+		std::variant<DomCircle, int> shape;
+	};
+}
+
+DR_PARAM_DEFINE_ENUM(dr::DomMode,
+	(fast,    "fast")
+	(precise, "precise")
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::DomCircle,
+	(radius, "double", "The radius of the circle.", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::DomSquare,
+	(side, "double", "The length of the sides of the square.", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::DomConfig,
+	(name,   "std::string",                        "The name of the robot.", true)
+	(label,  "std::string_view",                   "The label of the robot.", true)
+	(mode,   "DomMode",                            "The motion mode.", true)
+	(joints, "std::vector<double>",                "The joint positions.", true)
+	(limits, "std::map<std::string_view, int>",    "The limits by name.", false)
+	(range,  "std::optional<std::array<int, 2>>",  "The allowed range.", false)
+	(shape,  "std::variant<DomCircle, int>",       "The shape of the tool.", true)
+);
+
+namespace dr {
+
+#define STRINGIFY(TEXT) #TEXT
+#define STRINGIFY_MACRO(TEXT) STRINGIFY(TEXT)
+
+namespace {
+	std::string const data_path = STRINGIFY_MACRO(TEST_DATA);
+
+	std::string const document =
+		"name: arm\n"
+		"label: left arm\n"
+		"mode: precise\n"
+		"joints: [1, 2.5, -3]\n"
+		"limits: {speed: 3, force: 20}\n"
+		"range: [0, 10]\n"
+		"shape: !circle {radius: 0.5}\n";
+}
+
+TEST_CASE("YamlDom stores the structure of a document", "yaml_dom") {
+	YamlResult<YamlDom> dom = loadYamlDom("a: [1, \"two\", ~]\nb: {c: !tag d}\n");
+	REQUIRE(dom);
+
+	YamlDomNode root = dom->root();
+	REQUIRE(root.isMap());
+	REQUIRE(root.size() == 2);
+	CHECK(root.entry(0).key.scalar() == "a");
+	CHECK(root.entry(1).key.scalar() == "b");
+
+	YamlDomNode a = *root.find("a");
+	REQUIRE(a.isSequence());
+	REQUIRE(a.size() == 3);
+	CHECK(a[0].scalar() == "1");
+	CHECK(a[0].tag() == "?");
+	CHECK(a[1].scalar() == "two");
+	CHECK(a[1].tag() == "!");
+	CHECK(a[2].isNull());
+
+	std::vector<std::string_view> scalars;
+	for (YamlDomNode element : a) scalars.push_back(element.scalar());
+	CHECK(scalars == std::vector<std::string_view>{"1", "two", ""});
+
+	YamlDomNode c = *root.find("b")->find("c");
+	CHECK(c.scalar() == "d");
+	CHECK(c.tag() == "!tag");
+	CHECK(!root.find("missing"));
+}
+
+TEST_CASE("YamlDom resolves aliases to shared nodes", "yaml_dom") {
+	YamlResult<YamlDom> dom = loadYamlDom("base: &base {x: 1}\ncopy: *base\n");
+	REQUIRE(dom);
+	YamlDomNode root = dom->root();
+	CHECK(root.find("base")->identity() == root.find("copy")->identity());
+	CHECK(dom->nodeCount() == 6);
+
+	// Sharing survives the conversions to and from YAML::Node.
+	YAML::Node node = dom->toYaml();
+	CHECK(node["base"].is(node["copy"]));
+	YamlDom copy{node};
+	CHECK(copy.root().find("base")->identity() == copy.root().find("copy")->identity());
+}
+
+TEST_CASE("YamlDom reports syntax errors", "yaml_dom") {
+	YamlResult<YamlDom> dom = loadYamlDom("a: [1, 2\n");
+	REQUIRE(!dom);
+	CHECK(dom.error().message().rfind("line ", 0) == 0);
+
+	YamlResult<YamlDom> empty = loadYamlDom("");
+	REQUIRE(empty);
+	CHECK(empty->root().isNull());
+}
+
+TEST_CASE("YamlDom converts to and from YAML::Node", "yaml_dom") {
+	YAML::Node node = YAML::Load(document);
+	YamlDom dom{node};
+	CHECK(yamlEqual(dom.toYaml(), node));
+
+	YamlResult<YamlDom> loaded = loadYamlDom(document);
+	REQUIRE(loaded);
+	CHECK(yamlEqual(loaded->toYaml(), node));
+	CHECK(loaded->root().find("shape")->tag() == "!circle");
+}
+
+TEST_CASE("Parse decomposable type from YamlDom", "yaml_dom") {
+	YamlResult<YamlDom> dom = loadYamlDom(document);
+	REQUIRE(dom);
+
+	YamlResult<DomConfig> config = parseYaml<DomConfig>(*dom);
+	REQUIRE(config);
+	CHECK(config->name == "arm");
+	CHECK(config->label == "left arm");
+	CHECK(config->mode == DomMode::precise);
+	CHECK(config->joints == std::vector<double>{1, 2.5, -3});
+	CHECK(config->limits == std::map<std::string_view, int>{{"speed", 3}, {"force", 20}});
+	CHECK(config->range == std::array<int, 2>{0, 10});
+	REQUIRE(std::holds_alternative<DomCircle>(config->shape));
+	CHECK(std::get<DomCircle>(config->shape).radius == 0.5);
+
+	// Views point into the document.
+	YamlDomNode label = *dom->root().find("label");
+	CHECK(config->label.data() == label.scalar().data());
+}
+
+TEST_CASE("Errors from YamlDom match errors from YAML::Node", "yaml_dom") {
+	for (std::string const & text : {
+		document + "extra: 1\n",
+		std::string{"name: arm\nlabel: x\nmode: slow\njoints: []\nshape: 1\n"},
+		std::string{"name: arm\nlabel: x\nmode: fast\njoints: [1, a]\nshape: 1\n"},
+		std::string{"name: arm\nlabel: x\nmode: fast\njoints: {}\nshape: 1\n"},
+		std::string{"name: arm\nlabel: x\nmode: fast\njoints: []\nrange: [1]\nshape: 1\n"},
+		std::string{"name: arm\nlabel: x\nmode: fast\njoints: []\n"},
+	}) {
+		CAPTURE(text);
+		YamlResult<DomConfig> from_node = parseYaml<DomConfig>(YAML::Load(text));
+		YamlResult<DomConfig> from_dom  = parseYaml<DomConfig>(*loadYamlDom(text));
+		REQUIRE(!from_node);
+		REQUIRE(!from_dom);
+		CHECK(from_dom.error().format() == from_node.error().format());
+	}
+}
+
+TEST_CASE("Parse variant with discriminator key from YamlDom", "yaml_dom") {
+	YamlResult<YamlDom> dom = loadYamlDom("[{kind: square, side: 2}, !circle {kind: circle, radius: 1}]");
+	REQUIRE(dom);
+	YamlResult<std::vector<DomShape>> shapes = parseYaml<std::vector<DomShape>>(*dom);
+	REQUIRE(shapes);
+	REQUIRE(shapes->size() == 2);
+	CHECK(std::get<DomSquare>((*shapes)[0]).side == 2);
+	CHECK(std::get<DomCircle>((*shapes)[1]).radius == 1);
+
+	// The discriminator key is only skipped when decoding the variant.
+	YamlDomNode square = dom->root()[0];
+	CHECK(!parseYaml<DomSquare>(square));
+	DomSquare object;
+	CHECK(parseDecomposableFromYaml(square, object, {"kind", ""}) == std::nullopt);
+	CHECK(object.side == 2);
+
+	// The skipped key must select the alternative selected by the tag.
+	YamlDomNode circle = dom->root()[1];
+	std::optional<YamlError> from_dom = parseDecomposableFromYaml(circle, object, {"kind", "square"});
+	REQUIRE(from_dom);
+	std::optional<YamlError> from_node = parseDecomposableFromYaml(circle.toYaml(), object, {"kind", "square"});
+	REQUIRE(from_node);
+	CHECK(from_dom->format() == from_node->format());
+}
+
+TEST_CASE("YamlDom decoding respects limits", "yaml_dom") {
+	YamlResult<YamlDom> dom = loadYamlDom("[1, 2, 3, 4]");
+	REQUIRE(dom);
+	YamlLimits limits;
+	limits.max_sequence_length = 3;
+	YamlLimitsScope scope{limits};
+	CHECK(!parseYaml<std::vector<int>>(*dom));
+}
+
+TEST_CASE("YamlDom rejects unresolved deferred includes", "yaml_dom") {
+	YamlPreprocessOptions options;
+	options.lazy_includes = true;
+	auto node = preprocessYamlFile(data_path + "/recursive_include.yaml", {}, options);
+	REQUIRE(node);
+
+	YamlDom dom{*node};
+	YamlResult<std::string> decoded = parseYaml<std::string>(dom.root().find("a").value());
+	REQUIRE(!decoded);
+	CHECK(decoded.error().message().rfind("unresolved deferred include", 0) == 0);
+
+	YamlResult<std::map<std::string, std::string>> map = parseYaml<std::map<std::string, std::string>>(dom);
+	REQUIRE(!map);
+	CHECK(map.error().format().rfind("a: unresolved deferred include", 0) == 0);
+}
+
+TEST_CASE("Merge YamlDoms", "yaml_dom") {
+	std::string const a = "a: 1\nb: {c: 2, d: 3}\ne: [1]\n";
+	std::string const b = "b: {d: 4, f: 5}\ne: [2]\ng: 6\n";
+
+	YAML::Node expected = YAML::Load(a);
+	REQUIRE(mergeYamlNodes(expected, YAML::Load(b)));
+
+	YamlResult<YamlDom> dom_a = loadYamlDom(a);
+	YamlResult<YamlDom> dom_b = loadYamlDom(b);
+	REQUIRE(dom_a);
+	REQUIRE(dom_b);
+	YamlResult<YamlDom> merged = mergeYamlDoms(dom_a->root(), dom_b->root());
+	REQUIRE(merged);
+	CHECK(yamlEqual(merged->toYaml(), expected));
+
+	YamlResult<YamlDom> conflict = loadYamlDom("a: {x: 1}");
+	REQUIRE(conflict);
+	YamlResult<YamlDom> error = mergeYamlDoms(dom_a->root(), conflict->root());
+	REQUIRE(!error);
+	CHECK(error.error().format() == "a: tried to merge into a YAML node that is not a map");
+}
+
+}
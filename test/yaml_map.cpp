@@ -0,0 +1,130 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml.hpp"
+#include "yaml_decompose.hpp"
+#include "yaml_dom.hpp"
+#include "decompose_macros.hpp"
+
+#include <map>
+#include <unordered_map>
+
+namespace dr {
+	enum class Axis {
+		x,
+		y,
+		z,
+	};
+}
+
+DR_PARAM_DEFINE_ENUM(dr::Axis,
+	(x, "x")
+	(y, "y")
+	(z, "z")
+);
+
+namespace dr {
+
+TEST_CASE("FlatMap keeps its entries sorted", "yaml_map") {
+	FlatMap<int, std::string> map{{{3, "c"}, {1, "a"}, {2, "b"}, {1, "d"}}};
+	REQUIRE(map.size() == 3);
+	REQUIRE(map.entries() == std::vector<std::pair<int, std::string>>{{1, "a"}, {2, "b"}, {3, "c"}});
+	REQUIRE(map.at(2) == "b");
+	REQUIRE(map.contains(3));
+	REQUIRE(map.find(4) == map.end());
+	REQUIRE_THROWS_AS(map.at(4), std::out_of_range);
+
+	REQUIRE(map.insert({0, "z"}).second);
+	REQUIRE(!map.insert({2, "e"}).second);
+	REQUIRE(map.begin()->first == 0);
+	REQUIRE(map.at(2) == "b");
+}
+
+TEST_CASE("Maps with integral and enum keys", "yaml_map") {
+	YamlResult<std::map<unsigned short, int>> integral = parseYaml<std::map<unsigned short, int>>(YAML::Load("{3: 30, 1: 10}"));
+	REQUIRE(integral);
+	REQUIRE(*integral == std::map<unsigned short, int>{{1, 10}, {3, 30}});
+	REQUIRE(YAML::Dump(encodeYaml(*integral)) == "1: 10\n3: 30");
+
+	YamlResult<std::map<Axis, double>> axes = parseYaml<std::map<Axis, double>>(YAML::Load("{y: 2, x: 1}"));
+	REQUIRE(axes);
+	REQUIRE(*axes == std::map<Axis, double>{{Axis::x, 1}, {Axis::y, 2}});
+	REQUIRE(YAML::Dump(encodeYaml(*axes)) == "x: 1\ny: 2");
+
+	YamlResult<std::map<Axis, double>> invalid = parseYaml<std::map<Axis, double>>(YAML::Load("{w: 1}"));
+	REQUIRE(!invalid);
+	REQUIRE(invalid.error().format() == "w: invalid value `w', expected one of: x, y, z");
+}
+
+TEST_CASE("Unordered maps", "yaml_map") {
+	YamlResult<std::unordered_map<std::string, int>> decoded = parseYaml<std::unordered_map<std::string, int>>(YAML::Load("{a: 1, b: 2}"));
+	REQUIRE(decoded);
+	REQUIRE(*decoded == std::unordered_map<std::string, int>{{"a", 1}, {"b", 2}});
+
+	YAML::Node encoded = encodeYaml(*decoded);
+	REQUIRE(yamlEqual(encoded, YAML::Load("{a: 1, b: 2}")));
+
+	YamlResult<std::unordered_map<Axis, int>> axes = parseYaml<std::unordered_map<Axis, int>>(YAML::Load("{z: 3}"));
+	REQUIRE(axes);
+	REQUIRE(axes->at(Axis::z) == 3);
+
+	REQUIRE(parseYaml<std::unordered_map<int, int>>(YAML::Load("{}"))->empty());
+	REQUIRE(!parseYaml<std::unordered_map<int, int>>(YAML::Load("[1, 2]")));
+}
+
+TEST_CASE("Flat maps", "yaml_map") {
+	YamlResult<FlatMap<std::string, int>> decoded = parseYaml<FlatMap<std::string, int>>(YAML::Load("{c: 3, a: 1, b: 2}"));
+	REQUIRE(decoded);
+	REQUIRE(decoded->entries() == std::vector<std::pair<std::string, int>>{{"a", 1}, {"b", 2}, {"c", 3}});
+	REQUIRE(YAML::Dump(encodeYaml(*decoded)) == "a: 1\nb: 2\nc: 3");
+
+	YamlResult<FlatMap<int, std::vector<int>>> nested = parseYaml<FlatMap<int, std::vector<int>>>(YAML::Load("{2: [1, 2], 1: [x]}"));
+	REQUIRE(!nested);
+	REQUIRE(nested.error().format() == "1[0]: invalid integer value: x");
+}
+
+TEST_CASE("Duplicate keys are rejected", "yaml_map") {
+	std::string const document = "{a: 1, b: 2, c: 3, b: 4}";
+	REQUIRE(parseYaml<std::map<std::string, int>>(YAML::Load(document)).error().format() == "b: duplicate key");
+	REQUIRE(parseYaml<std::unordered_map<std::string, int>>(YAML::Load(document)).error().format() == "b: duplicate key");
+	REQUIRE(parseYaml<FlatMap<std::string, int>>(YAML::Load(document)).error().format() == "b: duplicate key");
+
+	// Keys that are spelled differently can still be the same value.
+	REQUIRE(parseYaml<FlatMap<int, int>>(YAML::Load("{1: 1, 01: 2}")).error().format() == "01: duplicate key");
+
+	YamlResult<YamlDom> dom = loadYamlDom(document);
+	REQUIRE(dom);
+	REQUIRE(parseYaml<std::map<std::string, int>>(*dom).error().format() == "b: duplicate key");
+	REQUIRE(parseYaml<std::unordered_map<std::string, int>>(*dom).error().format() == "b: duplicate key");
+	REQUIRE(parseYaml<FlatMap<std::string, int>>(*dom).error().format() == "b: duplicate key");
+}
+
+TEST_CASE("Duplicate keys are reported within limits", "yaml_map") {
+	// Looking up the duplicate key decodes the keys again, which may exceed the limits by itself.
+	std::string const document = "{a: 1, b: 2, c: 3, b: 4}";
+	YamlResult<YamlDom> dom = loadYamlDom(document);
+	REQUIRE(dom);
+	for (std::size_t max_nodes = 0; max_nodes < 20; ++max_nodes) {
+		YamlLimits limits;
+		limits.max_nodes = max_nodes;
+		REQUIRE(!parseYaml<FlatMap<std::string, int>>(YAML::Load(document), limits));
+		YamlLimitsScope scope{limits};
+		REQUIRE(!parseYaml<FlatMap<std::string, int>>(*dom));
+	}
+}
+
+TEST_CASE("Maps decoded from a YamlDom", "yaml_map") {
+	YamlResult<YamlDom> dom = loadYamlDom("{z: 3, x: 1}");
+	REQUIRE(dom);
+
+	YamlResult<FlatMap<Axis, int>> flat = parseYaml<FlatMap<Axis, int>>(*dom);
+	REQUIRE(flat);
+	REQUIRE(flat->entries() == std::vector<std::pair<Axis, int>>{{Axis::x, 1}, {Axis::z, 3}});
+
+	YamlResult<std::unordered_map<Axis, int>> unordered = parseYaml<std::unordered_map<Axis, int>>(*dom);
+	REQUIRE(unordered);
+	REQUIRE(*unordered == std::unordered_map<Axis, int>{{Axis::x, 1}, {Axis::z, 3}});
+}
+
+}
@@ -0,0 +1,168 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "flat_map.hpp"
+#include "yaml.hpp"
+#include "yaml_path.hpp"
+#include "decompose_macros.hpp"
+
+namespace dr {
+	struct Tool {
+		std::string name;
+		std::vector<double> calibration;
+	};
+
+	struct Robot {
+		std::string name;
+		std::optional<Tool> tool;
+	};
+
+	struct Config {
+		std::vector<Robot> robots;
+		std::map<std::string, int> limits;
+		int version = 0;
+		std::map<int, double> offsets;
+		std::map<std::string_view, int> labels;
+		std::unordered_map<std::string, int> counts;
+		FlatMap<int, double> scales;
+		std::array<int, 2> range{};
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Tool,
+	(name,        "string",         "", true)
+	(calibration, "vector<double>", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Robot,
+	(name, "string", "", true)
+	(tool, "Tool",   "", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Config,
+	(robots,  "vector<Robot>",    "", true)
+	(limits,  "map<string, int>", "", true)
+	(version, "int",              "", true)
+	(offsets, "map<int, double>", "", false)
+	(labels,  "map<string_view, int>", "", false)
+	(counts,  "unordered_map<string, int>", "", false)
+	(scales,  "FlatMap<int, double>", "", false)
+	(range,   "array<int, 2>", "", false)
+);
+
+namespace dr {
+
+namespace {
+	// The first robot is invalid, to check that it is not decoded.
+	YAML::Node document = YAML::Load(R"(
+robots:
+  - name: 7
+    tool: {name: [], calibration: aap}
+  - name: bob
+    tool: {name: gripper, calibration: [1, 2, 3]}
+limits: {speed: 3, force: 4}
+version: 2
+offsets: {1: 0.5, 2: 1.5}
+labels: {a: 1}
+counts: {x: 1, y: [nope]}
+scales: {3: 0.5}
+range: [4, 5]
+)");
+}
+
+TEST_CASE("splitYamlPath", "yaml_path") {
+	REQUIRE(*splitYamlPath("robots[1].tool.calibration") == std::vector<std::string_view>{"robots", "1", "tool", "calibration"});
+	REQUIRE(*splitYamlPath("[3].name") == std::vector<std::string_view>{"3", "name"});
+	REQUIRE(!splitYamlPath(""));
+	REQUIRE(!splitYamlPath("robots[1"));
+	REQUIRE(!splitYamlPath("robots[x]"));
+	REQUIRE(!splitYamlPath("robots..tool"));
+	REQUIRE(!splitYamlPath("robots[1]tool"));
+}
+
+TEST_CASE("selectYamlPath", "yaml_path") {
+	YamlResult<YAML::Node> node = selectYamlPath(document, "robots[1].tool.name");
+	REQUIRE(node);
+	REQUIRE(node->Scalar() == "gripper");
+
+	REQUIRE(selectYamlPath(document, "robots[2]").error().format() == "robots: sequence index 2 out of range, sequence has 2 elements");
+	REQUIRE(selectYamlPath(document, "robots[1].arm").error().format() == "robots[1]: missing property `arm'");
+	REQUIRE(selectYamlPath(document, "version.major").error().format() == "version: invalid node type: expected map or sequence, got scalar");
+}
+
+TEST_CASE("parseYamlPath", "yaml_path") {
+	YamlResult<std::vector<double>> calibration = parseYamlPath<std::vector<double>>(document, "robots[1].tool.calibration");
+	REQUIRE(calibration);
+	REQUIRE(*calibration == std::vector<double>{1, 2, 3});
+
+	YamlResult<Tool> tool = parseYamlPath<Tool>(document, "robots[0].tool");
+	REQUIRE(!tool);
+	REQUIRE(tool.error().formatTrace() == "robots[0].tool.name");
+}
+
+TEST_CASE("parseYamlPaths", "yaml_path") {
+	Config config;
+	REQUIRE(!parseYamlPaths(document, config, {"robots[1].tool.calibration", "limits.force", "version"}));
+	REQUIRE(config.robots.size() == 2);
+	REQUIRE(config.robots[0].name == "");
+	REQUIRE(!config.robots[0].tool);
+	REQUIRE(config.robots[1].name == "");
+	REQUIRE(config.robots[1].tool);
+	REQUIRE(config.robots[1].tool->calibration == std::vector<double>{1, 2, 3});
+	REQUIRE(config.limits == std::map<std::string, int>{{"force", 4}});
+	REQUIRE(config.version == 2);
+
+	std::optional<YamlError> error = parseYamlPaths(document, config, {"robots[0].tool.calibration"});
+	REQUIRE(error);
+	REQUIRE(error->formatTrace() == "robots[0].tool.calibration");
+	REQUIRE(!config.robots[0].tool);
+
+	error = parseYamlPaths(document, config, {"robots[1].arm"});
+	REQUIRE(error);
+	REQUIRE(error->format() == "robots[1]: unknown property `arm'");
+
+	// Steps into maps are decoded as the key type.
+	REQUIRE(!parseYamlPaths(document, config, {"offsets.2"}));
+	REQUIRE(config.offsets == std::map<int, double>{{2, 1.5}});
+	error = parseYamlPaths(document, config, {"labels.a"});
+	REQUIRE(error);
+	REQUIRE(error->format() == "labels.a: can not select entries of this map in a path");
+}
+
+TEST_CASE("parseYamlPaths through other containers", "yaml_path") {
+	Config config;
+	REQUIRE(!parseYamlPaths(document, config, {"counts.x", "scales.3", "range[1]"}));
+	REQUIRE(config.counts == std::unordered_map<std::string, int>{{"x", 1}});
+	REQUIRE(config.scales.size() == 1);
+	REQUIRE(config.scales.find(3)->second == 0.5);
+	REQUIRE(config.range == std::array<int, 2>{0, 5});
+
+	std::optional<YamlError> error = parseYamlPaths(document, config, {"counts.y"});
+	REQUIRE(error);
+	REQUIRE(error->formatTrace() == "counts.y");
+	REQUIRE(config.counts.count("y") == 0);
+
+	// A std::array does not grow.
+	error = parseYamlPaths(YAML::Load("{range: [1, 2, 3]}"), config, {"range[2]"});
+	REQUIRE(error);
+	REQUIRE(error->format() == "range: can not select `2' past the end of the list");
+}
+
+TEST_CASE("parseYamlPaths leaves the object untouched on error", "yaml_path") {
+	// Nothing along a failing path is added to the object.
+	Config config;
+	REQUIRE(parseYamlPaths(YAML::Load("{limits: {x: bad}}"), config, {"limits.x"}));
+	REQUIRE(config.limits.empty());
+
+	YAML::Node robots = YAML::Load("{robots: [{name: a}, {name: b}, {tool: {name: c, calibration: bad}}]}");
+	REQUIRE(parseYamlPaths(robots, config, {"robots[2].tool.calibration"}));
+	REQUIRE(config.robots.empty());
+
+	// Paths before the failing path are still decoded.
+	REQUIRE(parseYamlPaths(robots, config, {"robots[1].name", "robots[2].tool.calibration"}));
+	REQUIRE(config.robots.size() == 2);
+	REQUIRE(config.robots[1].name == "b");
+}
+
+}
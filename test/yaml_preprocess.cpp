@@ -86,4 +86,158 @@ TEST_CASE("YamlPreprocess 6", "include_recursive") {
 	REQUIRE((*node)["a"]["b"]["foo"].as<std::string>() == "bar");
 }
 
+TEST_CASE("YamlPreprocess 7", "include_lazy") {
+	std::vector<std::string> included_files;
+	YamlPreprocessOptions options;
+	options.lazy_includes  = true;
+	options.included_files = &included_files;
+
+	// The missing include is not an error as long as it is not resolved.
+	auto node = preprocessYamlFile(data_path + "/batch/three.yaml", {}, options);
+	REQUIRE(node);
+	REQUIRE(isDeferredYamlInclude((*node)["shared"]));
+	REQUIRE(resolveYamlPath(*node, "name", {}, options));
+	REQUIRE(!resolveYamlPath(*node, "shared", {}, options));
+
+	node = preprocessYamlFile(data_path + "/recursive_include.yaml", {}, options);
+	REQUIRE(node);
+	REQUIRE(included_files.empty());
+	REQUIRE(isDeferredYamlInclude((*node)["a"]));
+
+	// Resolving a path only reads the files along the path.
+	auto foo = resolveYamlPath(*node, "a.b.foo", {}, options);
+	REQUIRE(foo);
+	REQUIRE(foo->as<std::string>() == "bar");
+	REQUIRE(included_files.size() == 2);
+	REQUIRE((*node)["a"]["b"]["foo"].as<std::string>() == "bar");
+
+	// Variables in included files are expanded with the correct $DIR.
+	node = preprocessYamlFile(data_path + "/batch/one.yaml", {{"robot", "aap"}}, options);
+	REQUIRE(node);
+	REQUIRE(resolveYamlIncludes(*node, {{"robot", "aap"}}, options));
+	REQUIRE((*node)["shared"]["value"].as<std::string>() == data_path + "/batch/aap");
+}
+
+TEST_CASE("YamlPreprocess 8", "include_dir") {
+	std::vector<std::string> included_files;
+	YamlPreprocessOptions options;
+	options.included_files = &included_files;
+
+	auto node = preprocessYamlFile(data_path + "/include_multiple.yaml", {}, options);
+	REQUIRE(node);
+
+	YAML::Node tools = (*node)["tools"];
+	REQUIRE(tools.IsMap());
+	REQUIRE(tools.size() == 2);
+	REQUIRE(tools["camera"]["name"].as<std::string>() == "camera");
+	REQUIRE(tools["gripper"]["config"]["foo"].as<std::string>() == "bar");
+
+	YAML::Node glob = (*node)["glob"];
+	REQUIRE(glob.IsSequence());
+	REQUIRE(glob.size() == 2);
+	REQUIRE(glob[0]["name"].as<std::string>() == "camera");
+	REQUIRE(glob[1]["name"].as<std::string>() == "gripper");
+
+	// Each file is read twice, and the nested include once for each time.
+	REQUIRE(included_files.size() == 6);
+
+	REQUIRE(!preprocessYamlFile(data_path + "/include_dir_missing.yaml", {}));
+
+	// Errors name the file they came from.
+	auto error = preprocessYamlFile(data_path + "/include_dir_error.yaml", {});
+	REQUIRE(!error);
+	REQUIRE(error.error().description == data_path + "/include_dir_error/bad.yaml: !include needs a string");
+
+	// Files with the same stem are rejected, also if they are not adjacent when sorted by name.
+	error = preprocessYamlBuffer("tools: !include_dir include_dir_stems", data_path, {});
+	REQUIRE(!error);
+	REQUIRE(error.error().description == "!include_dir found multiple files with stem `tool' in " + data_path + "/include_dir_stems");
+}
+
+TEST_CASE("YamlPreprocess 9", "buffer") {
+	std::string_view data = "b: !include subdir/b.yaml\ndir: !expand $DIR\n";
+	auto node = preprocessYamlBuffer(data, data_path, {});
+	REQUIRE(node);
+	REQUIRE((*node)["b"]["foo"].as<std::string>() == "bar");
+	REQUIRE((*node)["dir"].as<std::string>() == data_path);
+
+	// Syntax errors report the position in the buffer.
+	auto error = preprocessYamlBuffer("a: [", data_path, {});
+	REQUIRE(!error);
+	REQUIRE(error.error().description.rfind("line 1, column ", 0) == 0);
+}
+
+TEST_CASE("YamlPreprocess 10", "limits") {
+	YamlPreprocessOptions options;
+	options.limits.max_include_depth = 2;
+	REQUIRE(preprocessYamlFile(data_path + "/recursive_include.yaml", {}, options));
+
+	options.limits.max_include_depth = 1;
+	auto error = preprocessYamlFile(data_path + "/recursive_include.yaml", {}, options);
+	REQUIRE(!error);
+	REQUIRE(error.error().code == std::errc::value_too_large);
+	REQUIRE(error.error().description == "preprocessing limit exceeded: includes nested more than 1 deep");
+
+	// Include cycles fail instead of running out of memory.
+	options.limits.max_include_depth = 16;
+	REQUIRE(!preprocessYamlFile(data_path + "/include_cycle.yaml", {}, options));
+
+	options = {};
+	options.limits.max_bytes_read = 10;
+	error = preprocessYamlFile(data_path + "/include.yaml", {}, options);
+	REQUIRE(!error);
+	REQUIRE(error.error().description == "preprocessing limit exceeded: more than 10 bytes read");
+
+	// Errors for files included by !include_dir and !include_glob name the file.
+	options.limits.max_bytes_read = 75;
+	error = preprocessYamlFile(data_path + "/include_multiple.yaml", {}, options);
+	REQUIRE(!error);
+	REQUIRE(error.error().description == data_path + "/include_dir/camera.yml: preprocessing limit exceeded: more than 75 bytes read");
+
+	options = {};
+	options.limits.max_nodes = 3;
+	REQUIRE(!preprocessYamlBuffer("[1, 2, 3]", data_path, {}, options));
+	REQUIRE(preprocessYamlBuffer("[1, 2]", data_path, {}, options));
+}
+
+TEST_CASE("YamlPreprocess 11", "include_lazy_limits") {
+	YamlPreprocessOptions options;
+	options.lazy_includes = true;
+	options.limits.max_include_depth = 16;
+
+	// Resolving a deferred include continues counting the include depth, so lazy include cycles fail too.
+	auto node = preprocessYamlFile(data_path + "/include_cycle.yaml", {}, options);
+	REQUIRE(node);
+	auto error = resolveYamlIncludes(*node, {}, options);
+	REQUIRE(!error);
+	REQUIRE(error.error().code == std::errc::value_too_large);
+
+	node = preprocessYamlFile(data_path + "/include_cycle.yaml", {}, options);
+	REQUIRE(node);
+	std::string path = "a";
+	for (int i = 0; i < 20; ++i) path += ".a";
+	auto resolved = resolveYamlPath(*node, path, {}, options);
+	REQUIRE(!resolved);
+	REQUIRE(resolved.error().code == std::errc::value_too_large);
+
+	// Deferred includes that were not resolved can not be decoded.
+	node = preprocessYamlFile(data_path + "/recursive_include.yaml", {}, options);
+	REQUIRE(node);
+	YamlResult<std::string> decoded = parseYaml<std::string>((*node)["a"]);
+	REQUIRE(!decoded);
+	REQUIRE(decoded.error().message().rfind("unresolved deferred include", 0) == 0);
+}
+
+TEST_CASE("YamlPreprocess 12", "include_lazy_forged") {
+	// A deferred include tag written in a document is not trusted as path to include.
+	YAML::Node node = YAML::Load("a: !deferred_include " + data_path + "/include.yaml");
+	REQUIRE(!isDeferredYamlInclude(node["a"]));
+	REQUIRE(resolveYamlIncludes(node, {}));
+	REQUIRE(node["a"].Scalar() == data_path + "/include.yaml");
+	REQUIRE(!parseYaml<std::string>(node["a"]));
+
+	// Preprocessing rejects the tag.
+	REQUIRE(!preprocessYamlBuffer("a: !deferred_include " + data_path + "/include.yaml", data_path, {}));
+}
+
 }
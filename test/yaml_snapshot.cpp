@@ -0,0 +1,234 @@
+/// Catch
+#include <catch2/catch_test_macros.hpp>
+
+/// Fizyr
+#include "yaml_snapshot.hpp"
+#include "yaml_decompose.hpp"
+#include "decompose_macros.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+
+namespace dr {
+	struct Tool {
+		std::string name;
+		std::vector<double> offset;
+	};
+
+	struct Robot {
+		std::string name;
+		std::optional<Tool> tool;
+	};
+
+	struct OtherRobot {
+		std::string name;
+		std::optional<Tool> tool;
+		int speed;
+	};
+
+	struct Frame {
+		std::string name;
+		std::vector<Frame> children;
+	};
+
+	struct Link {
+		std::string name;
+		std::vector<Frame> children;
+	};
+}
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Tool,
+	(name,   "string",         "", true)
+	(offset, "vector<double>", "", true)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Robot,
+	(name, "string", "", true)
+	(tool, "Tool",   "", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::OtherRobot,
+	(name,  "string", "", true)
+	(tool,  "Tool",   "", false)
+	(speed, "int",    "", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Frame,
+	(name,     "string",        "", true)
+	(children, "vector<Frame>", "", false)
+);
+
+DR_PARAM_DEFINE_STRUCT_DECOMPOSITION(dr::Link,
+	(name,     "string",        "", true)
+	(children, "vector<Frame>", "", false)
+);
+
+namespace dr {
+
+namespace fs = boost::filesystem;
+
+namespace {
+	void writeFile(fs::path const & path, std::string const & data) {
+		std::ofstream file(path.native());
+		file << data;
+	}
+}
+
+TEST_CASE("schema hash", "snapshot") {
+	REQUIRE(param::schemaHash<Robot>() == param::schemaHash<Robot>());
+	REQUIRE(param::schemaHash<Robot>() != param::schemaHash<OtherRobot>());
+	REQUIRE(param::schemaHash<std::vector<int>>() != param::schemaHash<std::vector<long long>>());
+	REQUIRE(param::schemaHash<std::unordered_map<std::string, int>>() != param::schemaHash<std::unordered_map<std::string, double>>());
+	REQUIRE(param::schemaHash<std::unordered_map<std::string, int>>() != param::schemaHash<std::unordered_map<int, int>>());
+	REQUIRE(param::schemaHash<FlatMap<std::string, int>>() != param::schemaHash<FlatMap<std::string, double>>());
+	REQUIRE(param::schemaHash<FlatMap<std::string, int>>() != param::schemaHash<FlatMap<int, int>>());
+
+	// Recursive types refer back to themselves instead of recursing forever.
+	REQUIRE(param::schemaHash<Frame>() == param::schemaHash<Frame>());
+	REQUIRE(param::schemaHash<Frame>() != param::schemaHash<Link>());
+	REQUIRE(param::schemaHash<std::vector<Frame>>() != param::schemaHash<std::vector<Link>>());
+}
+
+TEST_CASE("snapshot round trip", "snapshot") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+	writeFile(dir / "robot.yaml", "name: !expand $name\ntool: !include tool.yaml\n");
+	writeFile(dir / "tool.yaml", "name: gripper\noffset: [0.1, 0.2, 0.3]\n");
+
+	std::string yaml     = (dir / "robot.yaml").native();
+	std::string snapshot = (dir / "robot.snapshot").native();
+
+	REQUIRE(compileYamlSnapshot<Robot>(yaml, snapshot, {{"name", "r1"}}));
+
+	estd::result<YAML::Node, estd::error> document = readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {{"name", "r1"}});
+	REQUIRE(document);
+	REQUIRE((*document)["tool"]["offset"][1].as<double>() == 0.2);
+
+	YamlResult<Robot> robot = loadYamlSnapshot<Robot>(snapshot, yaml, {{"name", "r1"}});
+	REQUIRE(robot);
+	REQUIRE(robot->name == "r1");
+	REQUIRE(robot->tool->name == "gripper");
+	REQUIRE(robot->tool->offset == std::vector<double>{0.1, 0.2, 0.3});
+
+	// Different schema or variables invalidate the snapshot.
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<OtherRobot>(), {{"name", "r1"}}));
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {{"name", "r2"}}));
+	robot = loadYamlSnapshot<Robot>(snapshot, yaml, {{"name", "r2"}});
+	REQUIRE(robot);
+	REQUIRE(robot->name == "r2");
+
+	// Modifying an included file invalidates the snapshot.
+	writeFile(dir / "tool.yaml", "name: suction cup\noffset: [0.1, 0.2, 0.3]\n");
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {{"name", "r1"}}));
+	robot = loadYamlSnapshot<Robot>(snapshot, yaml, {{"name", "r1"}});
+	REQUIRE(robot);
+	REQUIRE(robot->tool->name == "suction cup");
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("snapshot sources are absolute", "snapshot") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+	writeFile(dir / "robot.yaml", "name: r1\n");
+
+	// Compile with a relative path, and read the snapshot from a different working directory.
+	fs::path original = fs::current_path();
+	fs::current_path(dir);
+	REQUIRE(compileYamlSnapshot<Robot>("robot.yaml", "robot.snapshot", {}));
+	fs::current_path(original);
+
+	std::string snapshot = (dir / "robot.snapshot").native();
+	REQUIRE(readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {}));
+
+	writeFile(dir / "robot.yaml", "name: r2\n");
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {}));
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("snapshot with directory includes", "snapshot") {
+	using Tools = std::map<std::string, std::vector<Tool>>;
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir / "tools");
+	writeFile(dir / "robot.yaml", "tools: !include_glob tools/*.yaml\n");
+	writeFile(dir / "tools/a.yaml", "name: gripper\noffset: [0.1]\n");
+
+	std::string yaml     = (dir / "robot.yaml").native();
+	std::string snapshot = (dir / "robot.snapshot").native();
+
+	REQUIRE(compileYamlSnapshot<Tools>(yaml, snapshot, {}));
+	REQUIRE(readYamlSnapshot(snapshot, param::schemaHash<Tools>(), {}));
+
+	// Adding or removing a file in a listed directory invalidates the snapshot.
+	writeFile(dir / "tools/b.yaml", "name: suction cup\noffset: [0.2]\n");
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<Tools>(), {}));
+	YamlResult<Tools> tools = loadYamlSnapshot<Tools>(snapshot, yaml, {});
+	REQUIRE(tools);
+	REQUIRE((*tools)["tools"].size() == 2);
+
+	REQUIRE(compileYamlSnapshot<Tools>(yaml, snapshot, {}));
+	REQUIRE(readYamlSnapshot(snapshot, param::schemaHash<Tools>(), {}));
+	fs::remove(dir / "tools/a.yaml");
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<Tools>(), {}));
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("snapshot of a different root file", "snapshot") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+	writeFile(dir / "a.yaml", "name: a\n");
+	writeFile(dir / "b.yaml", "name: b\n");
+
+	std::string snapshot = (dir / "robot.snapshot").native();
+	REQUIRE(compileYamlSnapshot<Robot>((dir / "a.yaml").native(), snapshot, {}));
+	REQUIRE(readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {}, (dir / "a.yaml").native()));
+	REQUIRE(!readYamlSnapshot(snapshot, param::schemaHash<Robot>(), {}, (dir / "b.yaml").native()));
+
+	YamlResult<Robot> robot = loadYamlSnapshot<Robot>(snapshot, (dir / "b.yaml").native(), {});
+	REQUIRE(robot);
+	REQUIRE(robot->name == "b");
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("snapshot nesting depth", "snapshot") {
+	fs::path dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+	std::string snapshot = (dir / "deep.snapshot").native();
+
+	YAML::Node deep{YAML::NodeType::Null};
+	for (int i = 0; i < 1000; ++i) {
+		YAML::Node parent{YAML::NodeType::Sequence};
+		parent.push_back(deep);
+		deep.reset(parent);
+	}
+	REQUIRE(!writeYamlSnapshot(snapshot, deep, 0, {}, {}));
+
+	// Write a valid snapshot of a single scalar, and replace the scalar with deeply nested sequences.
+	REQUIRE(writeYamlSnapshot(snapshot, YAML::Node{"x"}, 0, {}, {}));
+	std::string data;
+	{
+		std::ifstream file(snapshot, std::ios::binary);
+		data.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+	}
+	// A scalar is its type, an empty tag and a value of one byte, each with a length byte.
+	data.resize(data.size() - 4);
+	for (int i = 0; i < 100000; ++i) data += std::string{char(YAML::NodeType::Sequence), '\0', '\1'};
+	data += std::string{char(YAML::NodeType::Null), '\0'};
+	{
+		std::ofstream file(snapshot, std::ios::binary | std::ios::trunc);
+		file << data;
+	}
+
+	estd::result<YAML::Node, estd::error> document = readYamlSnapshot(snapshot, 0, {});
+	REQUIRE(!document);
+	REQUIRE(document.error().format().find("corrupt snapshot") != std::string::npos);
+
+	fs::remove_all(dir);
+}
+
+}